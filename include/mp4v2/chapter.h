@@ -49,6 +49,30 @@ void MP4AddChapter(
     MP4Duration   chapterDuration,
     const char*   chapterTitle DEFAULT(0));
 
+/** Add QuickTime chapters in bulk.
+ *
+ *  This function appends all chapters of <b>chapterList</b> to the chapter
+ *  track of file <b>hFile</b>. Unlike calling MP4AddChapter() per chapter,
+ *  the text samples are written as a single chunk with one write and the
+ *  sample tables are extended in one pass.
+ *
+ *  MP4SetChapters() uses this for QuickTime chapters and writes Nero
+ *  chapters in the same call when asked for #MP4ChapterTypeAny.
+ *
+ *  @param hFile handle of file to add chapters.
+ *  @param chapterTrackId ID of chapter track.
+ *  @param chapterList array of chapter items, durations in milliseconds.
+ *  @param chapterCount count of items in array.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4AddChapters(
+    MP4FileHandle       hFile,
+    MP4TrackId          chapterTrackId,
+    const MP4Chapter_t* chapterList,
+    uint32_t            chapterCount );
+
 /** Add a QuickTime chapter track.
  *
  *  This function adds a chapter (text) track to file <b>hFile</b>.
@@ -153,6 +177,7 @@ MP4ChapterType MP4GetChapters(
  *  This functions sets the complete chapter list in file <b>hFile</b>.
  *  If any chapters of the same type already exist they will first
  *  be deleted.
+ *  All chapters of a type are written at once, see MP4AddChapters().
  *
  *  @param hFile handle of file to modify.
  *  @param chapterList array of chapters items.
@@ -12,6 +12,14 @@
 #define MP4_CREATE_64BIT_DATA 0x01
 /** Bit: enable 64-bit time-atoms. @note Incompatible with QuickTime. */
 #define MP4_CREATE_64BIT_TIME 0x02
+/** Bit: write chunk data on a background thread, see MP4Create(). */
+#define MP4_CREATE_ASYNC_WRITE 0x04
+/** Bit: write chunk data bypassing the OS cache, see MP4Create(). */
+#define MP4_CREATE_DIRECT_IO 0x08
+/** Bit: rewrite moov where it is instead of appending it, see MP4Modify(). */
+#define MP4_MODIFY_IN_PLACE 0x01
+/** Default padding reserved after a relocated moov, see MP4SetMoovPadding(). */
+#define MP4_DEFAULT_MOOV_PADDING 4096
 /** Bit: do not recompute avg/max bitrates on file close.  @note See http://code.google.com/p/mp4v2/issues/detail?id=66 */
 #define MP4_CLOSE_DO_NOT_COMPUTE_BITRATE 0x01
 
@@ -66,6 +74,24 @@ void MP4Close(
  *  ie. invoking MP4Create() followed by MP4Close() will result in a file
  *  with a non-zero size.
  *
+ *  With #MP4_CREATE_ASYNC_WRITE, sample data is written behind the caller's
+ *  back: whenever a chunk is complete it is queued for a background thread
+ *  instead of being written by MP4WriteSample() itself, so the calling
+ *  thread no longer waits on storage. The queue is bounded, so a caller
+ *  that outpaces the disk will eventually block. Sample tables are still
+ *  maintained by the calling thread, MP4Close() waits for the queue to be
+ *  written out, and a write error is reported by whichever later call
+ *  touches the file. Buffers given to MP4WriteSampleRef() may be released
+ *  from the background thread.
+ *
+ *  With #MP4_CREATE_DIRECT_IO, chunk data is collected in an aligned buffer
+ *  and written to mdat in whole blocks that bypass the OS cache (O_DIRECT,
+ *  or F_NOCACHE on Mac OS X), which keeps long recordings from evicting
+ *  everything else from memory. Atom headers and a trailing partial block
+ *  still use normal I/O. Where the platform does not support it the flag
+ *  is ignored and a warning is logged. The flag combines with
+ *  #MP4_CREATE_ASYNC_WRITE.
+ *
  *  @param fileName pathname of the file to be created.
  *      On Windows, this should be a UTF-8 encoded string.
  *      On other platforms, it should be an 8-bit encoding that is
@@ -75,6 +101,8 @@ void MP4Close(
  *      data or time atoms. Valid bits may be any combination of:
  *          @li #MP4_CREATE_64BIT_DATA
  *          @li #MP4_CREATE_64BIT_TIME
+ *          @li #MP4_CREATE_ASYNC_WRITE
+ *          @li #MP4_CREATE_DIRECT_IO
  *
  *  @return On success a handle of the newly created file for use in
  *      subsequent calls to the library.
@@ -98,6 +126,8 @@ MP4FileHandle MP4Create(
  *      data or time atoms. Valid bits may be any combination of:
  *          @li #MP4_CREATE_64BIT_DATA
  *          @li #MP4_CREATE_64BIT_TIME
+ *          @li #MP4_CREATE_ASYNC_WRITE
+ *          @li #MP4_CREATE_DIRECT_IO
  *  @param add_ftyp if true an <b>ftyp</b> atom is automatically created.
  *  @param add_iods if true an <b>iods</b> atom is automatically created.
  *  @param majorBrand <b>ftyp</b> brand identifier.
@@ -148,6 +178,49 @@ bool MP4Dump(
     MP4FileHandle hFile,
     bool          dumpImplicits DEFAULT(0) );
 
+/** Compute the size of the moov atom without writing it.
+ *
+ *  MP4EstimateMoovSize serializes the in-memory moov atom the same way
+ *  MP4Close() or MP4Optimize() would, but only accounts for the bytes
+ *  instead of sending them to the file. The value is therefore exact for
+ *  the current state of the file, including chunk offset tables which have
+ *  been switched from 32-bit (stco) to 64-bit (co64) because an offset
+ *  crossed the 4 GiB boundary. Table entries for samples which are still
+ *  buffered in a pending chunk and the sample dependency table (sdtp)
+ *  built from MP4WriteSampleDependency() are added the way MP4Close()
+ *  would add them.
+ *
+ *  This allows a caller to reserve space ahead of the media data, for
+ *  example when laying out a progressive download file, without going
+ *  through a write/rewrite cycle.
+ *
+ *  @param hFile handle of file to measure.
+ *
+ *  @return On success the number of bytes the moov atom would occupy,
+ *      including its own header.
+ *      On failure, <b>0</b>.
+ */
+MP4V2_EXPORT
+uint64_t MP4EstimateMoovSize(
+    MP4FileHandle hFile );
+
+/** Set the padding reserved after a relocated moov atom.
+ *
+ *  When a file opened with #MP4_MODIFY_IN_PLACE grows beyond the space of
+ *  its moov atom, MP4Close() appends moov to the file followed by a free
+ *  atom of this many bytes, so that a few more edits fit in place again.
+ *  The default is #MP4_DEFAULT_MOOV_PADDING, <b>0</b> reserves nothing.
+ *
+ *  @param hFile handle of file to change.
+ *  @param padding number of bytes to reserve.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4SetMoovPadding(
+    MP4FileHandle hFile,
+    uint32_t      padding );
+
 /** Return a textual summary of an mp4 file.
  *
  *  MP4FileInfo provides a string that contains a textual summary of the
@@ -200,6 +273,62 @@ MP4V2_EXPORT
 const char* MP4GetFilename(
     MP4FileHandle hFile );
 
+/** I/O and parse statistics of a file handle, see MP4GetFileStats().
+ *
+ *  Bytes and calls count what reaches the file, including files holding
+ *  samples of referencing tracks; work done in a memory buffer is not
+ *  counted. Chunks written on the background thread of
+ *  #MP4_CREATE_ASYNC_WRITE count when they are queued.
+ */
+typedef struct MP4FileStats_s
+{
+    uint64_t bytesRead;            /**< bytes read */
+    uint64_t bytesWritten;         /**< bytes written */
+    uint64_t readCalls;            /**< number of reads */
+    uint64_t seekCalls;            /**< number of seeks */
+    uint64_t writeCalls;           /**< number of writes, a gather write counts once */
+    uint64_t atomsParsed;          /**< atoms read from the file */
+    uint64_t propertiesAllocated;  /**< properties created, read or added */
+    uint64_t cacheHits;            /**< sample table and sample lookups served from cache */
+    uint64_t cacheMisses;          /**< sample table and sample lookups that had to search */
+    uint64_t parseMicroseconds;    /**< time spent reading the atom tree */
+    uint64_t sampleIoMicroseconds; /**< time spent reading and writing sample data,
+                                        only with MP4SetFileStatsTiming() */
+} MP4FileStats;
+
+/** Get I/O and parse statistics of a file.
+ *
+ *  MP4GetFileStats returns the counters collected for @p hFile since it
+ *  was opened. Counters are never reset, take the difference of two
+ *  calls to measure a single operation.
+ *
+ *  @param hFile handle of file to query.
+ *  @param stats receives the statistics.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4GetFileStats(
+    MP4FileHandle hFile,
+    MP4FileStats* stats );
+
+/** Enable timing of sample I/O.
+ *
+ *  MP4SetFileStatsTiming turns collection of
+ *  MP4FileStats::sampleIoMicroseconds on or off for @p hFile. It is off
+ *  by default so reading and writing samples does not query the clock;
+ *  all other statistics are always collected.
+ *
+ *  @param hFile handle of file to change.
+ *  @param enable <b>true</b> to time sample I/O from now on.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4SetFileStatsTiming(
+    MP4FileHandle hFile,
+    bool          enable );
+
 /** Return a textual summary of an mp4 file.
  *
  *  MP4FileInfo provides a string that contains a textual summary of the
@@ -247,12 +376,28 @@ char* MP4Info(
  *  file layout, you may want to use MP4Optimize() after you have  modified
  *  and closed the mp4 file.
  *
+ *  By default the old moov atom is turned into a free atom and the new one
+ *  is appended to the file, after a new mdat atom for added samples.
+ *
+ *  With #MP4_MODIFY_IN_PLACE, meant for metadata edits such as tagging,
+ *  MP4Close() writes moov back into the space it occupied, together with
+ *  any free or skip atoms directly around it. What is left of that space
+ *  becomes a free atom, so the file neither grows nor changes its layout.
+ *  Only if moov no longer fits it moves to the end of the file, followed by
+ *  padding for later edits, see MP4SetMoovPadding(). A moov in front of the
+ *  media data then loses that position, which players use to start before
+ *  the whole file is downloaded; a later edit after which moov fits into
+ *  the free space it left there moves it back. No sample data can be
+ *  written in this mode.
+ *
  *  @param fileName pathname of the file to be modified.
  *      On Windows, this should be a UTF-8 encoded string.
  *      On other platforms, it should be an 8-bit encoding that is
  *      appropriate for the platform, locale, file system, etc.
  *      (prefer to use UTF-8 when possible).
- *  @param flags currently ignored.
+ *  @param flags bitmask that allows the modification to be customized.
+ *      Valid bits include:
+ *          @li #MP4_MODIFY_IN_PLACE
  *
  *  @return On success a handle of the target file for use in subsequent calls
  *      to the library.
@@ -15,6 +15,7 @@ typedef uint32_t    MP4SampleId;
 typedef uint64_t    MP4Timestamp;
 typedef uint64_t    MP4Duration;
 typedef uint32_t    MP4EditId;
+typedef void*       MP4SampleCursorHandle;
 
 typedef enum {
     MP4_LOG_NONE = 0,
@@ -34,6 +35,50 @@ typedef void (*MP4LogCallback)(
     const char* fmt,
     va_list     ap );
 
+/** Kind of message in an MP4LogRecord. */
+typedef enum {
+    MP4_LOG_CODE_NONE = 0,      /**< not classified */
+    MP4_LOG_CODE_EXCEPTION,     /**< an API call failed */
+    MP4_LOG_CODE_SAMPLE_READ,   /**< a sample is read */
+    MP4_LOG_CODE_SAMPLE_WRITE,  /**< a sample is written or referenced */
+    MP4_LOG_CODE_CHUNK_READ,    /**< a chunk is read */
+    MP4_LOG_CODE_CHUNK_WRITE    /**< a chunk is written */
+} MP4LogCode;
+
+/** A log message with its context, see MP4SetLogSink(). */
+typedef struct MP4LogRecord_s {
+    MP4LogLevel   level;    /**< level of detail of the message */
+    MP4LogCode    code;     /**< kind of message */
+    MP4FileHandle file;     /**< file of the sink, #MP4_INVALID_FILE_HANDLE for the global sink */
+    MP4TrackId    trackId;  /**< track concerned, or #MP4_INVALID_TRACK_ID */
+    MP4SampleId   sampleId; /**< sample concerned, or #MP4_INVALID_SAMPLE_ID */
+    const char*   message;  /**< formatted text without newline, valid during the call only */
+} MP4LogRecord;
+
+typedef void (*MP4LogSink)(
+    const MP4LogRecord* record,
+    void*               userData );
+
+/** Kind of event in an MP4TraceRecord. */
+typedef enum {
+    MP4_TRACE_BEGIN,  /**< a span starts */
+    MP4_TRACE_END     /**< the innermost open span of the thread ends */
+} MP4TraceEvent;
+
+/** A span boundary, see MP4SetTraceCallback(). */
+typedef struct MP4TraceRecord_s {
+    MP4TraceEvent event;     /**< begin or end */
+    const char*   category;  /**< phase: "parse", "read", "write" or "optimize" */
+    const char*   name;      /**< operation or atom type, valid during the call only */
+    MP4FileHandle file;      /**< file concerned, or #MP4_INVALID_FILE_HANDLE */
+    uint32_t      depth;     /**< number of spans of the thread enclosing this one */
+    int64_t       timestamp; /**< monotonic time in microseconds */
+} MP4TraceRecord;
+
+typedef void (*MP4TraceCallback)(
+    const MP4TraceRecord* record,
+    void*                 userData );
+
 /*****************************************************************************/
 
 /** Encryption function pointer.
@@ -51,6 +96,7 @@ typedef uint32_t (*encryptFunc_t)( uint32_t, uint32_t, uint8_t*, uint32_t*, uint
 #define MP4_INVALID_TIMESTAMP   ((MP4Timestamp)-1)    /**< Constant: invalid MP4Timestamp. */
 #define MP4_INVALID_DURATION    ((MP4Duration)-1)     /**< Constant: invalid MP4Duration. */
 #define MP4_INVALID_EDIT_ID     ((MP4EditId)0)        /**< Constant: invalid MP4EditId. */
+#define MP4_INVALID_SAMPLE_CURSOR ((MP4SampleCursorHandle)NULL) /**< Constant: invalid MP4SampleCursorHandle. */
 
 /* Macros to test for API type validity */
 #define MP4_IS_VALID_FILE_HANDLE(x) ((x) != MP4_INVALID_FILE_HANDLE)
@@ -366,6 +412,67 @@ MP4SampleId MP4GetSampleIdFromEditTime(
     MP4Timestamp* pStartTime DEFAULT(NULL),
     MP4Duration*  pDuration DEFAULT(NULL) );
 
+/** Create a cursor over the samples of a track in presentation order.
+ *
+ *  MP4CreateSampleCursor returns a cursor which, with each call to
+ *  MP4NextSampleCursor(), yields the next sample of a track along with its
+ *  start time and duration. With <b>applyEdits</b> the track's edit list
+ *  is followed, giving the same answers as repeated calls to
+ *  MP4GetSampleIdFromEditTime(), only in one pass over the edit list and
+ *  the sample tables rather than a search per sample. Empty edits are
+ *  skipped. Without an edit list, or with <b>applyEdits</b> false, all
+ *  samples are returned in decoding order with their media times.
+ *
+ *  The track must neither be modified nor deleted, and the file not be
+ *  closed, before the cursor is freed with MP4FreeSampleCursor().
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of track for operation.
+ *  @param applyEdits follow the edit list, if the track has one.
+ *
+ *  @return On success, handle of the new cursor.
+ *      On error, #MP4_INVALID_SAMPLE_CURSOR.
+ *
+ *  @see MP4NextSampleCursor().
+ *  @see MP4FreeSampleCursor().
+ */
+MP4V2_EXPORT
+MP4SampleCursorHandle MP4CreateSampleCursor(
+    MP4FileHandle hFile,
+    MP4TrackId    trackId,
+    bool          applyEdits DEFAULT(true) );
+
+/** Advance a sample cursor.
+ *
+ *  @param cursor handle of cursor for operation.
+ *  @param pSampleId pointer to variable that will hold the id of the next
+ *      sample.
+ *  @param pStartTime pointer to variable that will hold the start time of
+ *      the sample, in the edit timeline if edits are applied. Pass NULL
+ *      to ignore.
+ *  @param pDuration pointer to variable that will hold the duration of
+ *      the sample, shortened to its edit if edits are applied. Pass NULL
+ *      to ignore.
+ *
+ *  @return <b>true</b> if a sample was returned, <b>false</b> at the end
+ *      of the track or on error.
+ */
+MP4V2_EXPORT
+bool MP4NextSampleCursor(
+    MP4SampleCursorHandle cursor,
+    MP4SampleId*          pSampleId,
+    MP4Timestamp*         pStartTime DEFAULT(NULL),
+    MP4Duration*          pDuration DEFAULT(NULL) );
+
+/** Free a sample cursor.
+ *
+ *  @param cursor handle of cursor to be freed. #MP4_INVALID_SAMPLE_CURSOR
+ *      is ignored.
+ */
+MP4V2_EXPORT
+void MP4FreeSampleCursor(
+    MP4SampleCursorHandle cursor );
+
 /* time conversion utilties */
 
 /* predefined values for timeScale parameter below */
@@ -492,4 +599,82 @@ MP4LogLevel MP4LogGetLevel( void );
 MP4V2_EXPORT
 void MP4LogSetLevel( MP4LogLevel verbosity );
 
+/**
+ * Route the log messages of a file to a sink of its own
+ *
+ * Messages about <b>hFile</b> are passed to <b>sink</b> as records, up to
+ * <b>verbosity</b> and independent of the global level, rather than to the
+ * global log. The sink is called on the thread doing the work; messages of
+ * different files don't share a lock or buffer on the way.
+ *
+ * Messages from code that does not know its file, and those issued while
+ * a file is being opened, still go to the global log.
+ *
+ * The sink is not swapped atomically: call this function while no other
+ * thread uses <b>hFile</b>, or for the global log while no other thread
+ * calls into the library.
+ *
+ * @param hFile handle of file for operation, or #MP4_INVALID_FILE_HANDLE to
+ *      set a sink for the global log, which then takes precedence over the
+ *      MP4SetLogCallback() function and is set to <b>verbosity</b>.
+ * @param sink the function to call, or NULL to go back to the global log.
+ * @param userData passed through to <b>sink</b>.
+ * @param verbosity maximum level of messages passed to <b>sink</b>.
+ *
+ * @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4SetLogSink(
+    MP4FileHandle hFile,
+    MP4LogSink    sink,
+    void*         userData,
+    MP4LogLevel   verbosity DEFAULT(MP4_LOG_ERROR) );
+
+/**
+ * Trace the phases of library calls as nested spans
+ *
+ * <b>callback</b> is called when a span begins and when it ends. Spans
+ * cover reading the atom tree (per top-level atom, track setup and
+ * property caching), sample and chunk I/O, finishing a written file and
+ * MP4Optimize(). They nest within a thread; an end event always closes
+ * the innermost span open on its thread.
+ *
+ * The callback is called on the thread doing the work, concurrently if
+ * several threads use the library. Without a callback spans cost a single
+ * test. Set the callback while no other library call is running.
+ *
+ * @param callback the function to call, or NULL to stop tracing.
+ * @param userData passed through to <b>callback</b>.
+ *
+ * @see MP4StartChromeTrace() for a ready-made callback.
+ */
+MP4V2_EXPORT
+void MP4SetTraceCallback(
+    MP4TraceCallback callback,
+    void*            userData );
+
+/**
+ * Trace to a file in Chrome trace event format
+ *
+ * Installs a trace callback writing every span to <b>fileName</b> as JSON
+ * to be loaded into chrome://tracing, Perfetto or similar viewers. Threads
+ * appear as separate rows. Replaces any callback set with
+ * MP4SetTraceCallback().
+ *
+ * @param fileName pathname of the trace file, it is overwritten.
+ *
+ * @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ * @see MP4StopChromeTrace().
+ */
+MP4V2_EXPORT
+bool MP4StartChromeTrace(
+    const char* fileName );
+
+/**
+ * Stop a trace started with MP4StartChromeTrace() and close its file
+ */
+MP4V2_EXPORT
+void MP4StopChromeTrace( void );
+
 #endif /* MP4V2_GENERAL_H */
@@ -184,11 +184,27 @@ const MP4Tags* MP4TagsAlloc( void );
 MP4V2_EXPORT
 bool MP4TagsFetch( const MP4Tags* tags, MP4FileHandle hFile );
 
+/** Fetch data from mp4 file and populate structure, except for artwork.
+ *
+ *  Like MP4TagsFetch() but no cover art is copied, <b>tags->artwork</b>
+ *  is left empty. Use MP4GetArtworkInfo() and MP4ReadArtwork() to get at
+ *  the images. MP4TagsStore() keeps the artwork already in the file and
+ *  only adds images added with MP4TagsAddArtwork() after the fetch.
+ *
+ *  @param tags structure to fetch (write) into.
+ *  @param hFile handle of file to fetch data from.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4TagsFetchWithoutArtwork( const MP4Tags* tags, MP4FileHandle hFile );
+
 /** Store data to mp4 file from structure.
  *
  *  The tags structure is pushed out to the mp4 file,
  *  adding tags if needed, removing tags if needed, and updating
- *  the values to modified tags.
+ *  the values to modified tags. Items already holding the stored
+ *  value are left untouched.
  *
  *  @param tags structure to store (read) from.
  *  @param hFile handle of file to store data to.
@@ -198,6 +214,22 @@ bool MP4TagsFetch( const MP4Tags* tags, MP4FileHandle hFile );
 MP4V2_EXPORT
 bool MP4TagsStore( const MP4Tags* tags, MP4FileHandle hFile );
 
+/** Store data to mp4 file from structure and report any change.
+ *
+ *  As MP4TagsStore(), but tells whether the file's metadata changed.
+ *  Storing unchanged tags leaves the atom tree alone, so a file opened
+ *  with #MP4_MODIFY_IN_PLACE is closed without writing anything.
+ *
+ *  @param tags structure to store (read) from.
+ *  @param hFile handle of file to store data to.
+ *  @param changed set to <b>true</b> if any item was added, replaced or
+ *      removed. May be NULL.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4TagsStoreChanges( const MP4Tags* tags, MP4FileHandle hFile, bool* changed );
+
 /** Free tags convenience structure.
  *
  *  This function frees memory associated with the structure.
@@ -284,6 +316,52 @@ MP4V2_EXPORT bool MP4TagsSetGenreID           ( const MP4Tags*, const uint32_t*
 MP4V2_EXPORT bool MP4TagsSetComposerID        ( const MP4Tags*, const uint32_t* );
 MP4V2_EXPORT bool MP4TagsSetXID               ( const MP4Tags*, const char* );
 
+/** Get the number of cover art images in a file.
+ *
+ *  @param hFile handle of file to operate on.
+ *
+ *  @return number of images, 0 on failure.
+ */
+MP4V2_EXPORT
+uint32_t MP4GetArtworkCount( MP4FileHandle hFile );
+
+/** Get type and size of a cover art image without reading it.
+ *
+ *  For a file opened with MP4Read() images stay in the file until they
+ *  are asked for, this does not read image data.
+ *
+ *  @param hFile handle of file to operate on.
+ *  @param index 0-based index of image.
+ *  @param artwork receives size and type, <b>data</b> is set to NULL.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4GetArtworkInfo( MP4FileHandle hFile, uint32_t index, MP4TagArtwork* artwork );
+
+/** Read part of a cover art image into a caller supplied buffer.
+ *
+ *  For a file opened with MP4Read() the bytes are read straight from the
+ *  file, so large images can be streamed in pieces without the library
+ *  holding a copy.
+ *
+ *  @param hFile handle of file to operate on.
+ *  @param index 0-based index of image.
+ *  @param offset of first byte to read within the image.
+ *  @param buffer receiving <b>size</b> bytes.
+ *  @param size number of bytes to read, offset + size must not exceed
+ *      the image size reported by MP4GetArtworkInfo().
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ */
+MP4V2_EXPORT
+bool MP4ReadArtwork(
+    MP4FileHandle hFile,
+    uint32_t      index,
+    uint32_t      offset,
+    void*         buffer,
+    uint32_t      size );
+
 /** @} ***********************************************************************/
 
 #endif /* MP4V2_ITMF_TAGS_H */
@@ -24,6 +24,16 @@ typedef enum MP4SampleDependencyType_e {
     _MP4_SDT_RESERVED                     = 0x80 /**< reserved */
 } MP4SampleDependencyType;
 
+/** Sample buffer release callback.
+ *
+ *  Called by the library once it no longer needs a buffer handed to
+ *  MP4WriteSampleRef().
+ *
+ *  @param userData the value given to MP4WriteSampleRef().
+ *  @param pBytes the sample data pointer given to MP4WriteSampleRef().
+ */
+typedef void (*MP4SampleReleaseFunc)( void* userData, const uint8_t* pBytes );
+
 /** Read a track sample.
  *
  *  MP4ReadSample reads the specified sample from the specified track.
@@ -224,6 +234,50 @@ bool MP4WriteSample(
     MP4Duration    renderingOffset DEFAULT(0),
     bool           isSyncSample DEFAULT(true) );
 
+/** Write a track sample without copying it.
+ *
+ *  MP4WriteSampleRef behaves like MP4WriteSample() except that the sample
+ *  data is not copied into the library's chunk buffer. Instead the buffer
+ *  is retained by reference and written out directly, together with the
+ *  other samples of the same chunk, in a single gather write when the
+ *  chunk is flushed. This avoids an extra copy for large samples such as
+ *  video frames.
+ *
+ *  The caller must keep the buffer unchanged until @p release is called.
+ *  The callback is invoked exactly once per call, after the chunk holding
+ *  the sample was written, when the file is closed, or right away if the
+ *  sample could not be accepted. It may be <b>NULL</b> if the buffer is
+ *  known to outlive MP4Close().
+ *
+ *  MP4WriteSampleRef() and MP4WriteSample() may be intermixed freely.
+ *
+ *  @param hFile handle of file for operation.
+ *  @param trackId id of track for operation.
+ *  @param pBytes pointer to sample data.
+ *  @param numBytes length of sample data in bytes.
+ *  @param release callback handing the buffer back to the caller.
+ *  @param userData passed as is to @p release.
+ *  @param duration sample duration. Caveat: should be in track timescale.
+ *  @param renderingOffset the rendering offset for this sample.
+ *      Caveat: The offset should be in the track timescale.
+ *  @param isSyncSample the sync/random access flag for this sample.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4WriteSample().
+ */
+MP4V2_EXPORT
+bool MP4WriteSampleRef(
+    MP4FileHandle        hFile,
+    MP4TrackId           trackId,
+    const uint8_t*       pBytes,
+    uint32_t             numBytes,
+    MP4SampleReleaseFunc release,
+    void*                userData,
+    MP4Duration          duration DEFAULT(MP4_INVALID_DURATION),
+    MP4Duration          renderingOffset DEFAULT(0),
+    bool                 isSyncSample DEFAULT(true) );
+
 /** Write a track sample and supply dependency information.
  *
  *  MP4WriteSampleDependency writes the given sample at the end of the specified track.
@@ -350,7 +404,32 @@ bool MP4EncAndCopySample(
     MP4TrackId    dstTrackId DEFAULT(MP4_INVALID_TRACK_ID),
     MP4Duration   dstSampleDuration DEFAULT(MP4_INVALID_DURATION) );
 
-/** Not implemented.
+/** Reference a sample in another file.
+ *
+ *  MP4ReferenceSample adds a new sample to a track whose data stays where
+ *  it is in the source file. Only the sample tables of <b>dstFile</b>
+ *  grow; the track points at the source through the url entry of its
+ *  data reference, which readers like MP4ReadSample() follow.
+ *
+ *  The url records the absolute path of <b>srcFile</b>, a relative name
+ *  it was opened with is resolved against the current directory. The
+ *  source sample must be located in the source file itself and all
+ *  samples of a track must be referenced in the same file; referenced and
+ *  written samples can't be mixed in one track.
+ *
+ *  @param srcFile source sample file handle.
+ *  @param srcTrackId source sample track id.
+ *  @param srcSampleId source sample id.
+ *  @param dstFile destination file handle for new (referencing) sample,
+ *      which must differ from <b>srcFile</b>.
+ *  @param dstTrackId destination track id for new sample.
+ *  @param dstSampleDuration duration in track timescale for new sample.
+ *      If the value is #MP4_INVALID_DURATION, then the duration of
+ *      the source sample is used.
+ *
+ *  @return <b>true</b> on success, <b>false</b> on failure.
+ *
+ *  @see MP4ReferenceTrack().
  */
 MP4V2_EXPORT
 bool MP4ReferenceSample(
@@ -388,6 +388,35 @@ MP4TrackId MP4CopyTrack(
     bool          applyEdits DEFAULT(false),
     MP4TrackId    dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
 
+/** Reference a track in another file.
+ *
+ *  MP4ReferenceTrack is like MP4CopyTrack() except that no sample data is
+ *  copied: every sample is added with MP4ReferenceSample(), so the new
+ *  track costs only its header and sample tables in <b>dstFile</b>.
+ *  With <b>applyEdits</b> only the samples within the edits of the source
+ *  track are referenced, which makes for a cheap trim.
+ *
+ *  @param srcFile handle of file of the source track.
+ *  @param srcTrackId id of the source track.
+ *  @param dstFile handle of file for the new track, which must differ from
+ *      <b>srcFile</b>.
+ *  @param applyEdits true to reference only the samples within the edits.
+ *  @param dstHintTrackReferenceTrack id of the media track a new hint
+ *      track refers to.
+ *
+ *  @return On success, the id of the new track.
+ *      On error, #MP4_INVALID_TRACK_ID.
+ *
+ *  @see MP4ReferenceSample().
+ */
+MP4V2_EXPORT
+MP4TrackId MP4ReferenceTrack(
+    MP4FileHandle srcFile,
+    MP4TrackId    srcTrackId,
+    MP4FileHandle dstFile,
+    bool          applyEdits DEFAULT(false),
+    MP4TrackId    dstHintTrackReferenceTrack DEFAULT(MP4_INVALID_TRACK_ID) );
+
 MP4V2_EXPORT
 bool MP4DeleteTrack(
     MP4FileHandle hFile,
@@ -10,6 +10,25 @@ namespace {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileProvider::writev( const Segment* segments, uint32_t count, Size& nout, Size maxChunkSize )
+{
+    nout = 0;
+
+    for( uint32_t i = 0; i < count; i++ ) {
+        Size n = 0;
+        if( write( segments[i].buffer, segments[i].size, n, maxChunkSize ))
+            return true;
+        nout += n;
+        if( n != segments[i].size )
+            break;
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 File::File( std::string name_, Mode mode_, FileProvider* provider_ )
     : _name     ( name_ )
     , _isOpen   ( false )
@@ -17,6 +36,16 @@ File::File( std::string name_, Mode mode_, FileProvider* provider_ )
     , _size     ( 0 )
     , _position ( 0 )
     , _provider ( provider_ ? *provider_ : standard() )
+    , _direct         ( false )
+    , _directAlloc    ( NULL )
+    , _directBuffer   ( NULL )
+    , _directCapacity ( 0 )
+    , _directAlign    ( 0 )
+    , _directStart    ( 0 )
+    , _directFill     ( 0 )
+    , _directValid    ( false )
+    , _directDirty    ( false )
+    , _directSeek     ( false )
     , name      ( _name )
     , isOpen    ( _isOpen )
     , mode      ( _mode )
@@ -31,6 +60,7 @@ File::~File()
 {
     close();
     delete &_provider;
+    delete[] _directAlloc;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -76,6 +106,13 @@ File::seek( Size pos )
     if( !_isOpen )
         return true;
 
+    // staying put keeps appending to the direct staging buffer cheap
+    if( _direct && _directValid && pos == _position )
+        return false;
+
+    if( syncDirect( false ))
+        return true;
+
     if( _provider.seek( pos ))
         return true;
     _position = pos;
@@ -90,6 +127,9 @@ File::read( void* buffer, Size size, Size& nin, Size maxChunkSize )
     if( !_isOpen )
         return true;
 
+    if( syncDirect( false ))
+        return true;
+
     if( _provider.read( buffer, size, nin, maxChunkSize ))
         return true;
 
@@ -108,6 +148,9 @@ File::write( const void* buffer, Size size, Size& nout, Size maxChunkSize )
     if( !_isOpen )
         return true;
 
+    if( syncDirect( true ))
+        return true;
+
     if( _provider.write( buffer, size, nout, maxChunkSize ))
         return true;
 
@@ -118,11 +161,34 @@ File::write( const void* buffer, Size size, Size& nout, Size maxChunkSize )
     return false;
 }
 
+bool
+File::writev( const Segment* segments, uint32_t count, Size& nout, Size maxChunkSize )
+{
+    nout = 0;
+
+    if( !_isOpen )
+        return true;
+
+    if( _direct )
+        return writevDirect( segments, count, nout );
+
+    if( _provider.writev( segments, count, nout, maxChunkSize ))
+        return true;
+
+    _position += nout;
+    if( _position > _size )
+        _size = _position;
+
+    return false;
+}
+
 bool
 File::close()
 {
     if( !_isOpen )
         return false;
+    if( syncDirect( true ))
+        return true;
     if( _provider.close() )
         return true;
 
@@ -132,6 +198,9 @@ File::close()
 
 int64_t File::getSize()
 {
+   if( syncDirect( false ))
+       return 0;
+
    int64_t retSize = 0;
    FileSystem::getFileSize( _name, retSize );
    return retSize;
@@ -139,6 +208,150 @@ int64_t File::getSize()
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+File::enableDirect( Size capacity )
+{
+    if( !_isOpen || _direct )
+        return true;
+
+    if( !( _provider.capabilities() & CAP_DIRECT_WRITE ))
+        return true;
+
+    const Size align = _provider.directAlignment();
+    if( align <= 0 )
+        return true;
+
+    // an empty write tells whether the filesystem goes along with it
+    Size probe = 0;
+    if( _provider.writeDirect( 0, NULL, 0, probe ))
+        return true;
+
+    capacity = ( capacity + align - 1 ) / align * align;
+    if( capacity < align )
+        capacity = align;
+
+    // new[] has no alignment guarantee beyond max_align_t, align by hand
+    _directAlloc    = new uint8_t[capacity + align];
+    _directBuffer   = _directAlloc + ( align - (uintptr_t)_directAlloc % align ) % align;
+    _directCapacity = capacity;
+    _directAlign    = align;
+    _directValid    = false;
+    _directDirty    = false;
+    _directSeek     = false;
+    _direct         = true;
+
+    return false;
+}
+
+bool
+File::writevDirect( const Segment* segments, uint32_t count, Size& nout )
+{
+    // (re)start staging at the block holding the current position,
+    // whatever precedes us in that block is already in the file
+    if( !_directValid || _position != _directStart + _directFill ) {
+        if( syncDirect( true ))
+            return true;
+
+        _directStart = _position / _directAlign * _directAlign;
+        _directFill  = _position - _directStart;
+        _directValid = true;
+        _directDirty = false;
+
+        if( _directFill ) {
+            _directSeek = true;
+            Size nin = 0;
+            if( _provider.seek( _directStart ))
+                return true;
+            if( _provider.read( _directBuffer, _directFill, nin, 0 ) || nin != _directFill ) {
+                _directValid = false;
+                return true;
+            }
+        }
+    }
+
+    for( uint32_t i = 0; i < count; i++ ) {
+        const uint8_t* p = (const uint8_t*)segments[i].buffer;
+        Size remaining = segments[i].size;
+
+        while( remaining ) {
+            Size n = _directCapacity - _directFill;
+            if( n > remaining )
+                n = remaining;
+
+            memcpy( _directBuffer + _directFill, p, n );
+            _directFill  += n;
+            _directDirty  = true;
+            p            += n;
+            remaining    -= n;
+            nout         += n;
+
+            if( _directFill == _directCapacity ) {
+                Size written = 0;
+                if( _provider.writeDirect( _directStart, _directBuffer, _directCapacity, written ) || written != _directCapacity ) {
+                    _directValid = false;
+                    return true;
+                }
+                _directSeek   = true;
+                _directStart += _directCapacity;
+                _directFill   = 0;
+                _directDirty  = false;
+            }
+        }
+    }
+
+    _position += nout;
+    if( _position > _size )
+        _size = _position;
+
+    return false;
+}
+
+bool
+File::syncDirect( bool invalidate )
+{
+    if( !_direct )
+        return false;
+
+    if( _directDirty ) {
+        // whole blocks still go out directly, only the tail is cached
+        const Size blocks = _directFill / _directAlign * _directAlign;
+        if( blocks ) {
+            Size written = 0;
+            if( _provider.writeDirect( _directStart, _directBuffer, blocks, written ) || written != blocks )
+                return true;
+
+            _directFill -= blocks;
+            memmove( _directBuffer, _directBuffer + blocks, _directFill );
+            _directStart += blocks;
+        }
+
+        if( _directFill ) {
+            Size written = 0;
+            if( _provider.seek( _directStart ))
+                return true;
+            if( _provider.write( _directBuffer, _directFill, written, 0 ) || written != _directFill )
+                return true;
+        }
+
+        _directSeek  = true;
+        _directDirty = false;
+    }
+
+    if( _directSeek ) {
+        if( _provider.seek( _position ))
+            return true;
+        _directSeek = false;
+    }
+
+    // normal writes may land inside the staged block
+    if( invalidate )
+        _directValid = false;
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 CustomFileProvider::CustomFileProvider( const MP4FileProvider& provider )
     : _handle( NULL )
 {
@@ -22,6 +22,17 @@ public:
     //! type used to represent all file sizes and offsets
     typedef int64_t Size;
 
+    //! one buffer of a gather write
+    struct Segment {
+        const void* buffer; //!< data to be written
+        Size        size;   //!< number of bytes in buffer
+    };
+
+    //! optional provider capabilities, see capabilities()
+    enum Capability {
+        CAP_DIRECT_WRITE = 0x01, //!< writeDirect() bypasses the OS cache
+    };
+
 public:
     virtual ~FileProvider() { }
 
@@ -29,9 +40,17 @@ public:
     virtual bool seek( Size pos ) = 0;
     virtual bool read( void* buffer, Size size, Size& nin, Size maxChunkSize ) = 0;
     virtual bool write( const void* buffer, Size size, Size& nout, Size maxChunkSize ) = 0;
+    virtual bool writev( const Segment* segments, uint32_t count, Size& nout, Size maxChunkSize );
     virtual bool close() = 0;
 
     virtual int64_t getSize() = 0;
+
+    // direct writes: pos and size are multiples of directAlignment(),
+    // buffer is aligned alike; size 0 only checks availability
+    virtual uint32_t capabilities() { return 0; }
+    virtual Size directAlignment() { return 0; }
+    virtual bool writeDirect( Size pos, const void* buffer, Size size, Size& nout ) { return true; }
+
 protected:
     FileProvider() { }
 };
@@ -164,8 +183,53 @@ public:
 
     bool write( const void* buffer, Size size, Size& nout, Size maxChunkSize = 0 );
 
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Binary stream gather write.
+    //!
+    //! The function writes the <b>count</b> buffers described by
+    //! <b>segments</b> to file, in order, as if they were one contiguous
+    //! buffer. The number of bytes actually written are returned in
+    //! <b>nout</b>. Providers without native support fall back to one
+    //! write() per segment.
+    //!
+    //! @param segments buffers to be written out to file.
+    //! @param count number of entries in <b>segments</b>.
+    //! @param nout output indicating number of bytes written to file.
+    //! @param maxChunkSize maximum chunk size for writes issued to operating
+    //!     system or 0 for default.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+
+    bool writev( const Segment* segments, uint32_t count, Size& nout, Size maxChunkSize = 0 );
+
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Enable direct writes.
+    //!
+    //! Once enabled, data given to writev() is staged in an aligned buffer
+    //! of <b>capacity</b> bytes and goes out in whole blocks through the
+    //! provider's writeDirect(), bypassing the OS cache. A partial block at
+    //! the end is written with normal I/O whenever the file is otherwise
+    //! accessed. write() is not affected, it is meant for headers.
+    //!
+    //! @param capacity size of the staging buffer, rounded up to the
+    //!     provider's alignment.
+    //!
+    //! @return true on failure (provider without #CAP_DIRECT_WRITE),
+    //!     false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+
+    bool enableDirect( Size capacity = 1024*1024 );
+
     int64_t getSize();
 
+private:
+    bool writevDirect( const Segment* segments, uint32_t count, Size& nout );
+    bool syncDirect( bool invalidate );
 
 private:
     std::string   _name;
@@ -175,6 +239,19 @@ private:
     Size          _position;
     FileProvider& _provider;
 
+    // direct writes: _directBuffer mirrors the file from _directStart on,
+    // _directDirty if some of it has not been written out at all yet
+    bool          _direct;
+    uint8_t*      _directAlloc;
+    uint8_t*      _directBuffer;
+    Size          _directCapacity;
+    Size          _directAlign;
+    Size          _directStart;
+    Size          _directFill;
+    bool          _directValid;
+    bool          _directDirty;
+    bool          _directSeek;  // provider position is not _position
+
 public:
     const std::string& name;      //!< read-only: file pathname or empty-string if not applicable
     const bool&        isOpen;    //!< read-only: true if file is open
@@ -104,6 +104,27 @@ public:
 
     static bool rename( std::string oldname, std::string newname );
 
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! List directory entries.
+    //!
+    //! The names of all entries in <b>name</b>, excluding "." and "..",
+    //! are appended to <b>entries</b> without the directory component and
+    //! in no particular order.
+    //!
+    //! @param name directory to list.
+    //!     On Windows, this should be a UTF-8 encoded string.
+    //!     On other platforms, it should be an 8-bit encoding that is
+    //!     appropriate for the platform, locale, file system, etc.
+    //!     (prefer to use UTF-8 when possible).
+    //! @param entries output receiving entry names.
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+
+    static bool listDirectory( std::string name, std::vector<std::string>& entries );
+
     ///////////////////////////////////////////////////////////////////////////
     //!
     //! Generate temporary pathname.
@@ -132,6 +153,26 @@ public:
 
     static void pathnameCleanup( string& name );
 
+    ///////////////////////////////////////////////////////////////////////////
+    //!
+    //! Make pathname absolute.
+    //!
+    //! A relative pathname is resolved against the current directory; no
+    //! symbolic links are followed. A pathname cleanup is always performed.
+    //! See pathnameCleanup().
+    //!
+    //! @param name pathname to modify.
+    //!     On Windows, this should be a UTF-8 encoded string.
+    //!     On other platforms, it should be an 8-bit encoding that is
+    //!     appropriate for the platform, locale, file system, etc.
+    //!     (prefer to use UTF-8 when possible).
+    //!
+    //! @return true on failure, false on success.
+    //!
+    ///////////////////////////////////////////////////////////////////////////
+
+    static bool pathnameAbsolute( string& name );
+
 #if 0
 TODO-KB: implement
     ///////////////////////////////////////////////////////////////////////////
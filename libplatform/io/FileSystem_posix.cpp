@@ -1,5 +1,8 @@
 #include "libplatform/impl.h"
 #include <sys/stat.h>
+#include <dirent.h>
+#include <limits.h>
+#include <unistd.h>
 
 namespace mp4v2 { namespace platform { namespace io {
 
@@ -57,6 +60,44 @@ FileSystem::rename( string from, string to )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileSystem::listDirectory( string path_, vector<string>& entries )
+{
+    DIR* dir = opendir( path_.c_str() );
+    if( !dir )
+        return true;
+
+    while( struct dirent* ent = readdir( dir )) {
+        if( !strcmp( ent->d_name, "." ) || !strcmp( ent->d_name, ".." ))
+            continue;
+        entries.push_back( ent->d_name );
+    }
+
+    closedir( dir );
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+FileSystem::pathnameAbsolute( string& name )
+{
+    if( name.empty() )
+        return true;
+
+    if( name[0] != '/' ) {
+        char cwd[PATH_MAX];
+        if( !getcwd( cwd, sizeof( cwd )))
+            return true;
+        name = string( cwd ) + DIR_SEPARATOR + name;
+    }
+
+    pathnameCleanup( name );
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 string FileSystem::DIR_SEPARATOR  = "/";
 string FileSystem::PATH_SEPARATOR = ":";
 
@@ -138,6 +138,93 @@ FileSystem::rename( string from, string to )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+FileSystem::listDirectory( string path_, vector<string>& entries )
+{
+    win32::Utf8ToFilename filename( path_ + "\\*" );
+
+    if (!filename.IsUTF16Valid())
+    {
+        return true;
+    }
+
+    WIN32_FIND_DATAW data;
+    HANDLE find = ::FindFirstFileW( filename, &data );
+    if( find == INVALID_HANDLE_VALUE )
+    {
+        log.errorf("%s: FindFirstFileW(%s) failed (%d)",__FUNCTION__,filename.utf8.c_str(),
+                   GetLastError());
+        return true;
+    }
+
+    do {
+        if( !wcscmp( data.cFileName, L"." ) || !wcscmp( data.cFileName, L".." ))
+            continue;
+
+        int size = ::WideCharToMultiByte( CP_UTF8, 0, data.cFileName, -1, NULL, 0, NULL, NULL );
+        if( size <= 0 )
+            continue;
+
+        string name( size, '\0' );
+        ::WideCharToMultiByte( CP_UTF8, 0, data.cFileName, -1, &name[0], size, NULL, NULL );
+        name.resize( size - 1 );
+        entries.push_back( name );
+    } while( ::FindNextFileW( find, &data ));
+
+    ::FindClose( find );
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+FileSystem::pathnameAbsolute( string& name )
+{
+    win32::Utf8ToFilename filename( name );
+
+    if (!filename.IsUTF16Valid())
+    {
+        return true;
+    }
+
+    DWORD size = ::GetFullPathNameW( filename, 0, NULL, NULL );
+    if( size == 0 )
+    {
+        log.errorf("%s: GetFullPathNameW(%s) failed (%d)",__FUNCTION__,filename.utf8.c_str(),
+                   GetLastError());
+        return true;
+    }
+
+    vector<wchar_t> full( size );
+    size = ::GetFullPathNameW( filename, size, &full[0], NULL );
+    if( size == 0 || size >= full.size() )
+        return true;
+
+    // drop the \\?\ prefix Utf8ToFilename may have added, \\?\UNC\ stands
+    // for the leading \\ of a network path
+    wchar_t* path = &full[0];
+    if( !wcsncmp( path, L"\\\\?\\UNC\\", 8 )) {
+        path += 6;
+        path[0] = L'\\';
+    }
+    else if( !wcsncmp( path, L"\\\\?\\", 4 )) {
+        path += 4;
+    }
+
+    int length = ::WideCharToMultiByte( CP_UTF8, 0, path, -1, NULL, 0, NULL, NULL );
+    if( length <= 0 )
+        return true;
+
+    name.assign( length, '\0' );
+    ::WideCharToMultiByte( CP_UTF8, 0, path, -1, &name[0], length, NULL, NULL );
+    name.resize( length - 1 );
+
+    pathnameCleanup( name );
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 string FileSystem::DIR_SEPARATOR  = "\\";
 string FileSystem::PATH_SEPARATOR = ";";
 
@@ -17,18 +17,24 @@ public:
 
     int64_t getSize();
 
+    uint32_t capabilities();
+    Size directAlignment();
+    bool writeDirect( Size pos, const void* buffer, Size size, Size& nout );
+
 private:
     bool         _seekg;
     bool         _seekp;
     std::fstream _fstream;
     std::string  _name;
+    int          _directFd; // second descriptor, opened on first writeDirect()
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 
 StandardFileProvider::StandardFileProvider()
-    : _seekg ( false )
-    , _seekp ( false )
+    : _seekg    ( false )
+    , _seekp    ( false )
+    , _directFd ( -1 )
 {
 }
 
@@ -96,6 +102,11 @@ StandardFileProvider::write( const void* buffer, Size size, Size& nout, Size max
 bool
 StandardFileProvider::close()
 {
+    if( _directFd != -1 ) {
+        ::close( _directFd );
+        _directFd = -1;
+    }
+
     _fstream.close();
     return _fstream.fail();
 }
@@ -107,6 +118,62 @@ int64_t StandardFileProvider::getSize()
    return retSize;
 }
 
+uint32_t
+StandardFileProvider::capabilities()
+{
+#if defined( O_DIRECT ) || defined( F_NOCACHE )
+    return _seekp ? CAP_DIRECT_WRITE : 0;
+#else
+    return 0;
+#endif
+}
+
+FileProvider::Size
+StandardFileProvider::directAlignment()
+{
+    // logical block sizes up to 4K are the norm, larger is always fine
+    return 4096;
+}
+
+bool
+StandardFileProvider::writeDirect( Size pos, const void* buffer, Size size, Size& nout )
+{
+    nout = 0;
+
+    if( _directFd == -1 ) {
+#if defined( O_DIRECT )
+        _directFd = ::open( _name.c_str(), O_WRONLY | O_BINARY | O_DIRECT );
+#elif defined( F_NOCACHE )
+        _directFd = ::open( _name.c_str(), O_WRONLY | O_BINARY );
+        if( _directFd != -1 && ::fcntl( _directFd, F_NOCACHE, 1 ) == -1 ) {
+            ::close( _directFd );
+            _directFd = -1;
+        }
+#endif
+        if( _directFd == -1 )
+            return true;
+    }
+
+    // anything still buffered in the stream must reach the kernel first
+    _fstream.flush();
+    if( _fstream.fail() )
+        return true;
+
+    while( nout < size ) {
+        const ssize_t n = ::pwrite( _directFd, (const char*)buffer + nout, size - nout, pos + nout );
+        if( n == -1 ) {
+            if( errno == EINTR )
+                continue;
+            return true;
+        }
+        if( n == 0 )
+            break;
+        nout += n;
+    }
+
+    return false;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 FileProvider&
@@ -3,6 +3,10 @@
 
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
@@ -10,9 +14,12 @@
 #include <list>
 #include <locale>
 #include <map>
+#include <mutex>
+#include <queue>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <cassert>
@@ -4,6 +4,15 @@ namespace mp4v2 { namespace platform { namespace time {
 
 ///////////////////////////////////////////////////////////////////////////////
 
+microseconds_t
+getMonotonicMicroseconds()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 seconds_t
 getLocalTimeSeconds()
 {
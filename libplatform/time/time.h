@@ -5,6 +5,9 @@
 /// <b>WARNING: THIS IS A PRIVATE NAMESPACE. NOT FOR PUBLIC CONSUMPTION.</b>
 namespace mp4v2 { namespace platform { namespace time {
 
+//! type used to represent microseconds
+typedef int64_t microseconds_t;
+
 //! type used to represent milliseconds
 typedef int64_t milliseconds_t;
 
@@ -39,6 +42,19 @@ MP4V2_EXPORT milliseconds_t getLocalTimeMilliseconds();
 ///////////////////////////////////////////////////////////////////////////////
 MP4V2_EXPORT seconds_t getLocalTimeSeconds();
 
+///////////////////////////////////////////////////////////////////////////////
+//!
+//! Get monotonic time in microseconds.
+//!
+//! getMonotonicMicroseconds reads a clock which is not affected by changes
+//! to the system time. Its epoch is unspecified, so the value is only of
+//! use to measure the time elapsed between two calls.
+//!
+//! @return monotonic time in microseconds.
+//!
+///////////////////////////////////////////////////////////////////////////////
+MP4V2_EXPORT microseconds_t getMonotonicMicroseconds();
+
 ///////////////////////////////////////////////////////////////////////////////
 //! @}
 ///////////////////////////////////////////////////////////////////////////////
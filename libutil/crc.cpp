@@ -29,77 +29,262 @@
 
 #include "libutil/impl.h"
 
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#   define MP4V2_CRC_X86 1
+#   include <tmmintrin.h>
+#   include <wmmintrin.h>
+#   if defined( _MSC_VER )
+#       include <intrin.h>
+#       define MP4V2_TARGET_PCLMUL
+#   else
+#       include <cpuid.h>
+#       define MP4V2_TARGET_PCLMUL __attribute__(( target( "pclmul,ssse3" )))
+#   endif
+#endif
+
 namespace mp4v2 { namespace util {
+    using namespace mp4v2::impl;
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::atomic<int> Crc32::_kernel( -1 );
+
+namespace {
+
+const uint32_t crctab[256] = {
+    0x0,
+    0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
+    0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6,
+    0x2b4bcb61, 0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
+    0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9, 0x5f15adac,
+    0x5bd4b01b, 0x569796c2, 0x52568b75, 0x6a1936c8, 0x6ed82b7f,
+    0x639b0da6, 0x675a1011, 0x791d4014, 0x7ddc5da3, 0x709f7b7a,
+    0x745e66cd, 0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039,
+    0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5, 0xbe2b5b58,
+    0xbaea46ef, 0xb7a96036, 0xb3687d81, 0xad2f2d84, 0xa9ee3033,
+    0xa4ad16ea, 0xa06c0b5d, 0xd4326d90, 0xd0f37027, 0xddb056fe,
+    0xd9714b49, 0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
+    0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1, 0xe13ef6f4,
+    0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d, 0x34867077, 0x30476dc0,
+    0x3d044b19, 0x39c556ae, 0x278206ab, 0x23431b1c, 0x2e003dc5,
+    0x2ac12072, 0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16,
+    0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca, 0x7897ab07,
+    0x7c56b6b0, 0x71159069, 0x75d48dde, 0x6b93dddb, 0x6f52c06c,
+    0x6211e6b5, 0x66d0fb02, 0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1,
+    0x53dc6066, 0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
+    0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e, 0xbfa1b04b,
+    0xbb60adfc, 0xb6238b25, 0xb2e29692, 0x8aad2b2f, 0x8e6c3698,
+    0x832f1041, 0x87ee0df6, 0x99a95df3, 0x9d684044, 0x902b669d,
+    0x94ea7b2a, 0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e,
+    0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2, 0xc6bcf05f,
+    0xc27dede8, 0xcf3ecb31, 0xcbffd686, 0xd5b88683, 0xd1799b34,
+    0xdc3abded, 0xd8fba05a, 0x690ce0ee, 0x6dcdfd59, 0x608edb80,
+    0x644fc637, 0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
+    0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f, 0x5c007b8a,
+    0x58c1663d, 0x558240e4, 0x51435d53, 0x251d3b9e, 0x21dc2629,
+    0x2c9f00f0, 0x285e1d47, 0x36194d42, 0x32d850f5, 0x3f9b762c,
+    0x3b5a6b9b, 0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff,
+    0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623, 0xf12f560e,
+    0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7, 0xe22b20d2, 0xe6ea3d65,
+    0xeba91bbc, 0xef68060b, 0xd727bbb6, 0xd3e6a601, 0xdea580d8,
+    0xda649d6f, 0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
+    0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7, 0xae3afba2,
+    0xaafbe615, 0xa7b8c0cc, 0xa379dd7b, 0x9b3660c6, 0x9ff77d71,
+    0x92b45ba8, 0x9675461f, 0x8832161a, 0x8cf30bad, 0x81b02d74,
+    0x857130c3, 0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640,
+    0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c, 0x7b827d21,
+    0x7f436096, 0x7200464f, 0x76c15bf8, 0x68860bfd, 0x6c47164a,
+    0x61043093, 0x65c52d24, 0x119b4be9, 0x155a565e, 0x18197087,
+    0x1cd86d30, 0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
+    0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088, 0x2497d08d,
+    0x2056cd3a, 0x2d15ebe3, 0x29d4f654, 0xc5a92679, 0xc1683bce,
+    0xcc2b1d17, 0xc8ea00a0, 0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb,
+    0xdbee767c, 0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18,
+    0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4, 0x89b8fd09,
+    0x8d79e0be, 0x803ac667, 0x84fbdbd0, 0x9abc8bd5, 0x9e7d9662,
+    0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf,
+    0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4,
+};
+
+#define COMPUTE(var,ch) (var) = (var) << 8 ^ crctab[(var) >> 24 ^ (ch)]
+
+// slice[k][b] is the crc of byte b followed by k zero bytes
+struct SliceTables {
+    uint32_t slice[8][256];
+
+    SliceTables() {
+        for( int b = 0; b < 256; b++ ) {
+            uint32_t crc = crctab[b];
+            slice[0][b] = crc;
+            for( int k = 1; k < 8; k++ ) {
+                COMPUTE( crc, 0 );
+                slice[k][b] = crc;
+            }
+        }
+    }
+};
+
+const SliceTables sliceTables;
 
 ///////////////////////////////////////////////////////////////////////////////
 
 uint32_t
-crc32( const unsigned char* data, uint32_t size )
+updateTable( uint32_t crc, const unsigned char* data, uint32_t size )
 {
-    static const uint32_t __crctab[256] = {
-        0x0,
-        0x04c11db7, 0x09823b6e, 0x0d4326d9, 0x130476dc, 0x17c56b6b,
-        0x1a864db2, 0x1e475005, 0x2608edb8, 0x22c9f00f, 0x2f8ad6d6,
-        0x2b4bcb61, 0x350c9b64, 0x31cd86d3, 0x3c8ea00a, 0x384fbdbd,
-        0x4c11db70, 0x48d0c6c7, 0x4593e01e, 0x4152fda9, 0x5f15adac,
-        0x5bd4b01b, 0x569796c2, 0x52568b75, 0x6a1936c8, 0x6ed82b7f,
-        0x639b0da6, 0x675a1011, 0x791d4014, 0x7ddc5da3, 0x709f7b7a,
-        0x745e66cd, 0x9823b6e0, 0x9ce2ab57, 0x91a18d8e, 0x95609039,
-        0x8b27c03c, 0x8fe6dd8b, 0x82a5fb52, 0x8664e6e5, 0xbe2b5b58,
-        0xbaea46ef, 0xb7a96036, 0xb3687d81, 0xad2f2d84, 0xa9ee3033,
-        0xa4ad16ea, 0xa06c0b5d, 0xd4326d90, 0xd0f37027, 0xddb056fe,
-        0xd9714b49, 0xc7361b4c, 0xc3f706fb, 0xceb42022, 0xca753d95,
-        0xf23a8028, 0xf6fb9d9f, 0xfbb8bb46, 0xff79a6f1, 0xe13ef6f4,
-        0xe5ffeb43, 0xe8bccd9a, 0xec7dd02d, 0x34867077, 0x30476dc0,
-        0x3d044b19, 0x39c556ae, 0x278206ab, 0x23431b1c, 0x2e003dc5,
-        0x2ac12072, 0x128e9dcf, 0x164f8078, 0x1b0ca6a1, 0x1fcdbb16,
-        0x018aeb13, 0x054bf6a4, 0x0808d07d, 0x0cc9cdca, 0x7897ab07,
-        0x7c56b6b0, 0x71159069, 0x75d48dde, 0x6b93dddb, 0x6f52c06c,
-        0x6211e6b5, 0x66d0fb02, 0x5e9f46bf, 0x5a5e5b08, 0x571d7dd1,
-        0x53dc6066, 0x4d9b3063, 0x495a2dd4, 0x44190b0d, 0x40d816ba,
-        0xaca5c697, 0xa864db20, 0xa527fdf9, 0xa1e6e04e, 0xbfa1b04b,
-        0xbb60adfc, 0xb6238b25, 0xb2e29692, 0x8aad2b2f, 0x8e6c3698,
-        0x832f1041, 0x87ee0df6, 0x99a95df3, 0x9d684044, 0x902b669d,
-        0x94ea7b2a, 0xe0b41de7, 0xe4750050, 0xe9362689, 0xedf73b3e,
-        0xf3b06b3b, 0xf771768c, 0xfa325055, 0xfef34de2, 0xc6bcf05f,
-        0xc27dede8, 0xcf3ecb31, 0xcbffd686, 0xd5b88683, 0xd1799b34,
-        0xdc3abded, 0xd8fba05a, 0x690ce0ee, 0x6dcdfd59, 0x608edb80,
-        0x644fc637, 0x7a089632, 0x7ec98b85, 0x738aad5c, 0x774bb0eb,
-        0x4f040d56, 0x4bc510e1, 0x46863638, 0x42472b8f, 0x5c007b8a,
-        0x58c1663d, 0x558240e4, 0x51435d53, 0x251d3b9e, 0x21dc2629,
-        0x2c9f00f0, 0x285e1d47, 0x36194d42, 0x32d850f5, 0x3f9b762c,
-        0x3b5a6b9b, 0x0315d626, 0x07d4cb91, 0x0a97ed48, 0x0e56f0ff,
-        0x1011a0fa, 0x14d0bd4d, 0x19939b94, 0x1d528623, 0xf12f560e,
-        0xf5ee4bb9, 0xf8ad6d60, 0xfc6c70d7, 0xe22b20d2, 0xe6ea3d65,
-        0xeba91bbc, 0xef68060b, 0xd727bbb6, 0xd3e6a601, 0xdea580d8,
-        0xda649d6f, 0xc423cd6a, 0xc0e2d0dd, 0xcda1f604, 0xc960ebb3,
-        0xbd3e8d7e, 0xb9ff90c9, 0xb4bcb610, 0xb07daba7, 0xae3afba2,
-        0xaafbe615, 0xa7b8c0cc, 0xa379dd7b, 0x9b3660c6, 0x9ff77d71,
-        0x92b45ba8, 0x9675461f, 0x8832161a, 0x8cf30bad, 0x81b02d74,
-        0x857130c3, 0x5d8a9099, 0x594b8d2e, 0x5408abf7, 0x50c9b640,
-        0x4e8ee645, 0x4a4ffbf2, 0x470cdd2b, 0x43cdc09c, 0x7b827d21,
-        0x7f436096, 0x7200464f, 0x76c15bf8, 0x68860bfd, 0x6c47164a,
-        0x61043093, 0x65c52d24, 0x119b4be9, 0x155a565e, 0x18197087,
-        0x1cd86d30, 0x029f3d35, 0x065e2082, 0x0b1d065b, 0x0fdc1bec,
-        0x3793a651, 0x3352bbe6, 0x3e119d3f, 0x3ad08088, 0x2497d08d,
-        0x2056cd3a, 0x2d15ebe3, 0x29d4f654, 0xc5a92679, 0xc1683bce,
-        0xcc2b1d17, 0xc8ea00a0, 0xd6ad50a5, 0xd26c4d12, 0xdf2f6bcb,
-        0xdbee767c, 0xe3a1cbc1, 0xe760d676, 0xea23f0af, 0xeee2ed18,
-        0xf0a5bd1d, 0xf464a0aa, 0xf9278673, 0xfde69bc4, 0x89b8fd09,
-        0x8d79e0be, 0x803ac667, 0x84fbdbd0, 0x9abc8bd5, 0x9e7d9662,
-        0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf,
-        0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4,
-    };
-
-#define COMPUTE(var,ch) (var) = (var) << 8 ^ __crctab[(var) >> 24 ^ (ch)]
-
-    uint32_t crc = 0;
     const unsigned char* const max = data + size;
 
     for (const unsigned char* p = data; p < max; p++)
         COMPUTE( crc, *p );
 
-    for( ; size != 0; size >>= 8 )
+    return crc;
+}
+
+uint32_t
+updateSlice8( uint32_t crc, const unsigned char* p, uint32_t size )
+{
+    const uint32_t (* const t)[256] = sliceTables.slice;
+
+    for( ; size >= 8; size -= 8, p += 8 ) {
+        const uint32_t c = crc ^ ( uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3] );
+        crc = t[7][c >> 24] ^ t[6][(c >> 16) & 0xff] ^ t[5][(c >> 8) & 0xff] ^ t[4][c & 0xff]
+            ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+
+    return updateTable( crc, p, size );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined( MP4V2_CRC_X86 )
+
+bool
+cpuHasPclmul()
+{
+#if defined( _MSC_VER )
+    int info[4];
+    __cpuid( info, 1 );
+    return ( info[2] & ( 1 << 1 )) && ( info[2] & ( 1 << 9 ));
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ))
+        return false;
+    return ( ecx & bit_PCLMUL ) && ( ecx & bit_SSSE3 );
+#endif
+}
+
+// 16 bytes as one polynomial, the first byte holds the highest terms
+MP4V2_TARGET_PCLMUL inline __m128i
+loadBlock( const unsigned char* p )
+{
+    const __m128i reverse = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+    return _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i*)p ), reverse );
+}
+
+// a * x^n + b, reduced to 96 bits; k holds x^(n+64) and x^n mod P
+MP4V2_TARGET_PCLMUL inline __m128i
+fold( __m128i a, __m128i k, __m128i b )
+{
+    return _mm_xor_si128( _mm_xor_si128( _mm_clmulepi64_si128( a, k, 0x11 ),
+                                         _mm_clmulepi64_si128( a, k, 0x00 )), b );
+}
+
+MP4V2_TARGET_PCLMUL uint32_t
+updatePclmul( uint32_t crc, const unsigned char* p, uint32_t size )
+{
+    if( size < 64 )
+        return updateSlice8( crc, p, size );
+
+    const __m128i k512 = _mm_set_epi64x( 0x8833794c, 0xe6228b11 ); // x^576, x^512 mod P
+    const __m128i k128 = _mm_set_epi64x( 0xc5b9cd4c, 0xe8a45605 ); // x^192, x^128 mod P
+
+    // four independent accumulators, the register goes into the first bytes
+    __m128i a0 = _mm_xor_si128( loadBlock( p ), _mm_set_epi32( int( crc ), 0, 0, 0 ));
+    __m128i a1 = loadBlock( p + 16 );
+    __m128i a2 = loadBlock( p + 32 );
+    __m128i a3 = loadBlock( p + 48 );
+
+    for( size -= 64, p += 64; size >= 64; size -= 64, p += 64 ) {
+        a0 = fold( a0, k512, loadBlock( p ));
+        a1 = fold( a1, k512, loadBlock( p + 16 ));
+        a2 = fold( a2, k512, loadBlock( p + 32 ));
+        a3 = fold( a3, k512, loadBlock( p + 48 ));
+    }
+
+    a1 = fold( a0, k128, a1 );
+    a2 = fold( a1, k128, a2 );
+    a3 = fold( a2, k128, a3 );
+
+    for( ; size >= 16; size -= 16, p += 16 )
+        a3 = fold( a3, k128, loadBlock( p ));
+
+    // what is left is congruent to the data folded so far
+    unsigned char rest[16];
+    const __m128i reverse = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+    _mm_storeu_si128( (__m128i*)rest, _mm_shuffle_epi8( a3, reverse ));
+
+    crc = updateSlice8( 0, rest, sizeof( rest ));
+    return updateSlice8( crc, p, size );
+}
+
+#endif // MP4V2_CRC_X86
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+crc32( const unsigned char* data, uint32_t size )
+{
+    Crc32 crc;
+    crc.update( data, size );
+    return crc.value();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+Crc32::Crc32()
+    : _crc  ( 0 )
+    , _size ( 0 )
+{
+}
+
+void
+Crc32::reset()
+{
+    _crc  = 0;
+    _size = 0;
+}
+
+void
+Crc32::update( const unsigned char* data, uint32_t size )
+{
+    switch( getKernel() ) {
+#if defined( MP4V2_CRC_X86 )
+        case KERNEL_PCLMUL:
+            _crc = updatePclmul( _crc, data, size );
+            break;
+#endif
+
+        case KERNEL_SLICE8:
+            _crc = updateSlice8( _crc, data, size );
+            break;
+
+        default:
+            _crc = updateTable( _crc, data, size );
+            break;
+    }
+
+    _size += size;
+}
+
+uint32_t
+Crc32::value() const
+{
+    uint32_t crc = _crc;
+
+    for( uint64_t size = _size; size != 0; size >>= 8 )
         COMPUTE( crc, size & 0xff );
 
     return ~crc;
@@ -107,4 +292,93 @@ crc32( const unsigned char* data, uint32_t size )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+Crc32::Kernel
+Crc32::getKernel()
+{
+    int kernel = _kernel.load( std::memory_order_relaxed );
+    if( kernel < 0 ) {
+        kernel = KERNEL_SLICE8;
+        if( isSupported( KERNEL_PCLMUL ))
+            kernel = KERNEL_PCLMUL;
+        _kernel.store( kernel, std::memory_order_relaxed );
+    }
+    return Kernel( kernel );
+}
+
+bool
+Crc32::setKernel( Kernel kernel )
+{
+    if( !isSupported( kernel ))
+        return false;
+    _kernel.store( kernel, std::memory_order_relaxed );
+    return true;
+}
+
+bool
+Crc32::isSupported( Kernel kernel )
+{
+    switch( kernel ) {
+        case KERNEL_TABLE:
+        case KERNEL_SLICE8:
+            return true;
+
+#if defined( MP4V2_CRC_X86 )
+        case KERNEL_PCLMUL:
+        {
+            static const bool pclmul = cpuHasPclmul();
+            return pclmul;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+const char*
+Crc32::kernelName( Kernel kernel )
+{
+    switch( kernel ) {
+        case KERNEL_TABLE:  return "table";
+        case KERNEL_SLICE8: return "slice8";
+        case KERNEL_PCLMUL: return "pclmul";
+        default:            return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+crc32Track( MP4FileHandle file, MP4TrackId trackId, uint32_t& crc )
+{
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return true;
+    MP4File& mp4 = *((MP4File*)file);
+
+    try {
+        MP4Track& track = *mp4.GetTrack( trackId );
+
+        Crc32 sum;
+        const uint32_t numChunks = track.GetNumberOfChunks();
+        for( MP4ChunkId chunkId = 1; chunkId <= numChunks; chunkId++ ) {
+            uint8_t* chunk = NULL;
+            uint32_t chunkSize = 0;
+            track.ReadChunk( chunkId, &chunk, &chunkSize );
+            sum.update( chunk, chunkSize );
+            MP4Free( chunk );
+        }
+
+        crc = sum.value();
+    }
+    catch( Exception* x ) {
+        LogOfFile( file ).errorf(*x);
+        delete x;
+        return true;
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }} // namespace mp4v2::util
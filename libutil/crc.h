@@ -31,6 +31,62 @@ namespace mp4v2 { namespace util {
 MP4V2_EXPORT
 uint32_t crc32( const unsigned char*, uint32_t ); // ISO/IEC 8802-3:1989
 
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Incremental crc32().
+///
+/// Feeding data in pieces through update() and calling value() gives the
+/// same result as crc32() on the concatenated data, so large payloads can
+/// be checked without holding them in memory. The fastest kernel the CPU
+/// supports is picked on first use; all kernels give identical results.
+///
+class MP4V2_EXPORT Crc32
+{
+public:
+    enum Kernel {
+        KERNEL_TABLE,   // one table lookup per byte
+        KERNEL_SLICE8,  // eight tables, 8 bytes per step
+        KERNEL_PCLMUL,  // x86 carry-less multiply folding, 64 bytes per step
+
+        KERNEL_MAX
+    };
+
+public:
+    Crc32();
+
+    void     reset  ();
+    void     update ( const unsigned char* data, uint32_t size );
+    uint32_t value  () const; // checksum of all data so far, length included
+    uint64_t size   () const { return _size; }
+
+    static Kernel      getKernel   ();
+    static bool        setKernel   ( Kernel kernel ); // false if not supported
+    static bool        isSupported ( Kernel kernel );
+    static const char* kernelName  ( Kernel kernel );
+
+private:
+    uint32_t _crc;
+    uint64_t _size;
+
+    static std::atomic<int> _kernel; // -1 until first use
+};
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Checksum the sample data of a track.
+///
+/// The result equals crc32() of all samples concatenated in decoding order.
+/// Data is read chunk by chunk, only one chunk is held in memory at a time.
+///
+/// @param file on which to operate.
+/// @param trackId of track to checksum.
+/// @param crc on success, the checksum.
+///
+/// @return <b>true</b> on failure, <b>false</b> on success.
+///
+MP4V2_EXPORT
+bool crc32Track( MP4FileHandle file, MP4TrackId trackId, uint32_t& crc );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} // namespace mp4v2::util
@@ -47,6 +47,17 @@ MP4DataAtom::Read()
 {
     // calculate size of the metadata from the atom size
     metadata.SetValueSize( m_size - 8 );
+
+    // cover art is left in the file until somebody asks for it
+    if( m_File.IsDeferringArtwork() && m_pParentAtom &&
+        ATOMID( m_pParentAtom->GetType() ) == ATOMID( "covr" ))
+    {
+        ReadProperties( 0, 4 );
+        metadata.Defer( m_File.GetPosition() );
+        Skip();
+        return;
+    }
+
     MP4Atom::Read();
 }
 
@@ -73,6 +84,120 @@ MP4ItemAtom::MP4ItemAtom( MP4File &file, const char* type )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+MP4ItemListAtom::MP4ItemListAtom( MP4File &file )
+    : MP4StandardAtom    ( file, "ilst" )
+    , m_codeIndexValid    ( false )
+    , m_meaningIndexValid ( false )
+{
+}
+
+void
+MP4ItemListAtom::AddChildAtom( MP4Atom* pChildAtom )
+{
+    MP4StandardAtom::AddChildAtom( pChildAtom );
+
+    // appended items go last in their code
+    if( m_codeIndexValid )
+        m_codeIndex[ATOMID( pChildAtom->GetType() )].push_back( static_cast<MP4ItemAtom*>( pChildAtom ));
+
+    // the mean-atom of a new item is usually added after the item
+    if( ATOMID( pChildAtom->GetType() ) == ATOMID( "----" ))
+        m_meaningIndexValid = false;
+}
+
+void
+MP4ItemListAtom::InsertChildAtom( MP4Atom* pChildAtom, uint32_t index )
+{
+    MP4StandardAtom::InsertChildAtom( pChildAtom, index );
+
+    // only the first item of a code can be placed without a scan
+    if( m_codeIndexValid ) {
+        ItemList& items = m_codeIndex[ATOMID( pChildAtom->GetType() )];
+        if( items.empty() )
+            items.push_back( static_cast<MP4ItemAtom*>( pChildAtom ));
+        else
+            m_codeIndexValid = false;
+    }
+
+    if( ATOMID( pChildAtom->GetType() ) == ATOMID( "----" ))
+        m_meaningIndexValid = false;
+}
+
+void
+MP4ItemListAtom::DeleteChildAtom( MP4Atom* pChildAtom )
+{
+    MP4StandardAtom::DeleteChildAtom( pChildAtom );
+
+    if( m_codeIndexValid ) {
+        ItemList& items = m_codeIndex[ATOMID( pChildAtom->GetType() )];
+        ItemList::iterator it = find( items.begin(), items.end(), static_cast<MP4ItemAtom*>( pChildAtom ));
+        if( it != items.end() )
+            items.erase( it );
+    }
+
+    if( ATOMID( pChildAtom->GetType() ) == ATOMID( "----" ))
+        m_meaningIndexValid = false;
+}
+
+const MP4ItemListAtom::ItemList&
+MP4ItemListAtom::FindItems( const char* code )
+{
+    if( !m_codeIndexValid )
+        BuildCodeIndex();
+
+    static const ItemList none;
+    CodeIndex::const_iterator found = m_codeIndex.find( ATOMID( code ));
+    return found == m_codeIndex.end() ? none : found->second;
+}
+
+const MP4ItemListAtom::ItemList&
+MP4ItemListAtom::FindFreeformItems( const string& meaning )
+{
+    if( !m_meaningIndexValid )
+        BuildMeaningIndex();
+
+    static const ItemList none;
+    MeaningIndex::const_iterator found = m_meaningIndex.find( meaning );
+    return found == m_meaningIndex.end() ? none : found->second;
+}
+
+void
+MP4ItemListAtom::BuildCodeIndex()
+{
+    m_codeIndex.clear();
+
+    const uint32_t childCount = GetNumberOfChildAtoms();
+    for( uint32_t i = 0; i < childCount; i++ ) {
+        MP4Atom* atom = GetChildAtom( i );
+        m_codeIndex[ATOMID( atom->GetType() )].push_back( static_cast<MP4ItemAtom*>( atom ));
+    }
+
+    m_codeIndexValid = true;
+}
+
+void
+MP4ItemListAtom::BuildMeaningIndex()
+{
+    m_meaningIndex.clear();
+
+    const ItemList& freeform = FindItems( "----" );
+    for( ItemList::const_iterator it = freeform.begin(); it != freeform.end(); ++it ) {
+        // meaning is mandatory
+        MP4MeanAtom* mean = (MP4MeanAtom*)(*it)->FindAtom( "----.mean" );
+        if( !mean )
+            continue;
+
+        // UTF-8 value, not NULL-terminated
+        char* const value = mean->value.GetValueStringAlloc();
+        m_meaningIndex[string( value, mean->value.GetValueSize() )].push_back( *it );
+        MP4Free( value );
+    }
+
+    m_meaningIndexValid = true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 MP4ItmfHdlrAtom::MP4ItmfHdlrAtom(MP4File &file)
     : MP4FullAtom ( file, "hdlr" )
     , reserved1   ( *new MP4Integer32Property( *this, "reserved1" ))
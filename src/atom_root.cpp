@@ -103,31 +103,9 @@ void MP4RootAtom::BeginOptimalWrite()
 void MP4RootAtom::FinishOptimalWrite()
 {
     // finish writing mdat
+    // moov was written with the final chunk offsets already in place,
+    // see MP4File::LayoutMdat()
     m_pChildAtoms[GetLastMdatIndex()]->FinishWrite(m_File.Use64Bits("mdat"));
-
-    // find moov atom
-    uint32_t size = m_pChildAtoms.Size();
-    MP4Atom* pMoovAtom = NULL;
-
-    uint32_t i;
-    for (i = 0; i < size; i++) {
-        if (!strcmp("moov", m_pChildAtoms[i]->GetType())) {
-            pMoovAtom = m_pChildAtoms[i];
-            break;
-        }
-    }
-    ASSERT(i < size);
-    ASSERT(pMoovAtom != NULL);
-
-    // rewrite moov so that updated chunkOffsets are written to disk
-    m_File.SetPosition(pMoovAtom->GetStart());
-    uint64_t oldSize = pMoovAtom->GetSize();
-
-    pMoovAtom->Write();
-
-    // sanity check
-    uint64_t newSize = pMoovAtom->GetSize();
-    ASSERT(oldSize == newSize);
 }
 
 uint32_t MP4RootAtom::GetLastMdatIndex()
@@ -789,6 +789,46 @@ private:
     MP4ItemAtom &operator= ( const MP4ItemAtom &src );
 };
 
+/// iTMF item-list-atom.
+/// Item atoms are indexed by code and freeform items by meaning, both
+/// indexes are built on first lookup and kept up to date as items are
+/// added and removed. Changing the mean-atom of an item in place is not
+/// tracked.
+class MP4ItemListAtom : public MP4StandardAtom
+{
+public:
+    typedef vector<MP4ItemAtom*> ItemList;
+
+    MP4ItemListAtom( MP4File &file );
+
+    void AddChildAtom( MP4Atom* pChildAtom );
+    void InsertChildAtom( MP4Atom* pChildAtom, uint32_t index );
+    void DeleteChildAtom( MP4Atom* pChildAtom );
+
+    /// Items of code in ilst order.
+    const ItemList& FindItems( const char* code );
+
+    /// Freeform items of meaning in ilst order, any name.
+    const ItemList& FindFreeformItems( const string& meaning );
+
+private:
+    void BuildCodeIndex();
+    void BuildMeaningIndex();
+
+    typedef map<uint32_t,ItemList> CodeIndex;
+    typedef map<string,ItemList>   MeaningIndex;
+
+    CodeIndex    m_codeIndex;
+    bool         m_codeIndexValid;
+    MeaningIndex m_meaningIndex;
+    bool         m_meaningIndexValid;
+
+private:
+    MP4ItemListAtom();
+    MP4ItemListAtom( const MP4ItemListAtom &src );
+    MP4ItemListAtom &operator= ( const MP4ItemListAtom &src );
+};
+
 /// iTMF meaning-atom.
 class MP4MeanAtom : public MP4FullAtom
 {
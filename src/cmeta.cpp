@@ -134,11 +134,141 @@ MP4TagsFetch( const MP4Tags* tags, MP4FileHandle hFile )
         return true;
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed",__FUNCTION__);
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+MP4TagsFetchWithoutArtwork( const MP4Tags* tags, MP4FileHandle hFile )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return false;
+
+    if( !tags || !tags->__handle )
+        return false;
+
+    itmf::Tags* cpp = static_cast<itmf::Tags*>(tags->__handle);
+    MP4Tags* c = const_cast<MP4Tags*>(tags);
+
+    try {
+        cpp->c_fetch( c, hFile, false );
+        return true;
+    }
+    catch( Exception* x ) {
+        LogOfFile( hFile ).errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+MP4GetArtworkCount( MP4FileHandle hFile )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return 0;
+
+    try {
+        return itmf::CoverArtBox::count( hFile );
+    }
+    catch( Exception* x ) {
+        LogOfFile( hFile ).errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
+    }
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+MP4GetArtworkInfo( MP4FileHandle hFile, uint32_t index, MP4TagArtwork* artwork )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return false;
+
+    if( !artwork )
+        return false;
+
+    try {
+        itmf::CoverArtBox::Item item;
+        if( itmf::CoverArtBox::info( hFile, item, index ))
+            return false;
+
+        artwork->data = NULL;
+        artwork->size = item.size;
+
+        switch( item.type ) {
+            case itmf::BT_BMP:
+                artwork->type = MP4_ART_BMP;
+                break;
+
+            case itmf::BT_GIF:
+                artwork->type = MP4_ART_GIF;
+                break;
+
+            case itmf::BT_JPEG:
+                artwork->type = MP4_ART_JPEG;
+                break;
+
+            case itmf::BT_PNG:
+                artwork->type = MP4_ART_PNG;
+                break;
+
+            default:
+                artwork->type = MP4_ART_UNDEFINED;
+                break;
+        }
+
+        return true;
+    }
+    catch( Exception* x ) {
+        LogOfFile( hFile ).errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+MP4ReadArtwork( MP4FileHandle hFile, uint32_t index, uint32_t offset, void* buffer, uint32_t size )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return false;
+
+    if( !buffer && size )
+        return false;
+
+    try {
+        return !itmf::CoverArtBox::read( hFile, index, offset, (uint8_t*)buffer, size );
+    }
+    catch( Exception* x ) {
+        LogOfFile( hFile ).errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
     }
 
     return false;
@@ -216,6 +346,17 @@ MP4TagsSetArtwork( const MP4Tags* tags, uint32_t index, MP4TagArtwork* artwork )
 bool
 MP4TagsStore( const MP4Tags* tags, MP4FileHandle hFile )
 {
+    return MP4TagsStoreChanges( tags, hFile, NULL );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+MP4TagsStoreChanges( const MP4Tags* tags, MP4FileHandle hFile, bool* changed )
+{
+    if( changed )
+        *changed = false;
+
     if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
         return false;
 
@@ -226,15 +367,17 @@ MP4TagsStore( const MP4Tags* tags, MP4FileHandle hFile )
     MP4Tags* c = const_cast<MP4Tags*>(tags);
 
     try {
-        cpp->c_store( c, hFile );
+        const bool stored = cpp->c_store( c, hFile );
+        if( changed )
+            *changed = stored;
         return true;
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile( hFile ).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -1430,11 +1573,11 @@ MP4ItmfGetItems( MP4FileHandle hFile )
         return itmf::genericGetItems( *(MP4File*)hFile );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed",__FUNCTION__);
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
     }
 
     return NULL;
@@ -1452,11 +1595,11 @@ MP4ItmfGetItemsByCode( MP4FileHandle hFile, const char* code )
         return itmf::genericGetItemsByCode( *(MP4File*)hFile, code );
     }   
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed",__FUNCTION__);
+        LogOfFile( hFile ).errorf("%s: failed",__FUNCTION__);
     }
 
     return NULL;
@@ -1477,11 +1620,11 @@ MP4ItmfGetItemsByMeaning( MP4FileHandle hFile, const char* meaning, const char*
         return itmf::genericGetItemsByMeaning( *(MP4File*)hFile, meaning, name ? name : "" );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile( hFile ).errorf("%s: failed", __FUNCTION__ );
     }
 
     return NULL;
@@ -1499,11 +1642,11 @@ MP4ItmfAddItem( MP4FileHandle hFile, const MP4ItmfItem* item )
         return itmf::genericAddItem( *(MP4File*)hFile, item );
     }
     catch( Exception* x) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile( hFile ).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -1521,11 +1664,11 @@ MP4ItmfSetItem( MP4FileHandle hFile, const MP4ItmfItem* item )
         return itmf::genericSetItem( *(MP4File*)hFile, item );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile( hFile ).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -1543,11 +1686,11 @@ MP4ItmfRemoveItem( MP4FileHandle hFile, const MP4ItmfItem* item )
         return itmf::genericRemoveItem( *(MP4File*)hFile, item );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile( hFile ).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile( hFile ).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -136,6 +136,35 @@ CoverArtBox::add( MP4FileHandle hFile, const Item& item )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+uint32_t
+CoverArtBox::count( MP4FileHandle hFile )
+{
+    MP4File& file = *((MP4File*)hFile);
+
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
+        return 0;
+
+    return covr->GetNumberOfChildAtoms();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+MP4DataAtom*
+CoverArtBox::findData( MP4Atom& covr, uint32_t index )
+{
+    if( !(index < covr.GetNumberOfChildAtoms()) )
+        return NULL;
+
+    MP4Atom* atom = covr.GetChildAtom( index );
+    if( !atom || ATOMID( atom->GetType() ) != ATOMID( "data" ))
+        return NULL;
+
+    return static_cast<MP4DataAtom*>( atom );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool
 CoverArtBox::get( MP4FileHandle hFile, Item& item, uint32_t index )
 {
@@ -146,19 +175,34 @@ CoverArtBox::get( MP4FileHandle hFile, Item& item, uint32_t index )
     if( !covr )
         return true;
 
-    if( !(index < covr->GetNumberOfChildAtoms()) )
+    MP4DataAtom* data = findData( *covr, index );
+    if( !data )
         return true;
 
-    MP4DataAtom* data = static_cast<MP4DataAtom*>( covr->GetChildAtom( index ));
-    if( !data )
+    data->metadata.GetValue( &item.buffer, &item.size );
+    item.autofree = true;
+    item.type = data->typeCode.GetValue();
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+CoverArtBox::info( MP4FileHandle hFile, Item& item, uint32_t index )
+{
+    item.reset();
+    MP4File& file = *((MP4File*)hFile);
+
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
         return true;
 
-    MP4BytesProperty* metadata = NULL;
-    if ( !data->FindProperty( "data.metadata", (MP4Property**)&metadata ))
+    MP4DataAtom* data = findData( *covr, index );
+    if( !data )
         return true;
 
-    metadata->GetValue( &item.buffer, &item.size );
-    item.autofree = true;
+    item.size = data->metadata.GetValueSize();
     item.type = data->typeCode.GetValue();
 
     return false;
@@ -166,21 +210,54 @@ CoverArtBox::get( MP4FileHandle hFile, Item& item, uint32_t index )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+CoverArtBox::read( MP4FileHandle hFile, uint32_t index, uint32_t offset, uint8_t* buffer, uint32_t size )
+{
+    MP4File& file = *((MP4File*)hFile);
+
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
+        return true;
+
+    MP4DataAtom* data = findData( *covr, index );
+    if( !data )
+        return true;
+
+    const uint32_t valueSize = data->metadata.GetValueSize();
+    if( offset > valueSize || size > valueSize - offset )
+        return true;
+
+    data->metadata.CopyValueRange( buffer, offset, size );
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 bool
 CoverArtBox::list( MP4FileHandle hFile, ItemList& out )
 {
     out.clear();
     MP4File& file = *((MP4File*)hFile);
-    MP4ItmfItemList* itemList = genericGetItemsByCode( file, "covr" ); // alloc
 
-    if( itemList->size ) {
-        MP4ItmfDataList& dataList = itemList->elements[0].dataList;
-        out.resize( dataList.size );
-        for( uint32_t i = 0; i < dataList.size; i++ )
-            get( hFile, out[i], i );
+    MP4Atom* covr = file.FindAtom( "moov.udta.meta.ilst.covr" );
+    if( !covr )
+        return false;
+
+    const uint32_t atomc = covr->GetNumberOfChildAtoms();
+    out.reserve( atomc );
+    for( uint32_t i = 0; i < atomc; i++ ) {
+        MP4DataAtom* data = findData( *covr, i );
+        if( !data )
+            continue;
+
+        // append first and fill in place, copying an Item copies its buffer
+        out.push_back( Item() );
+        Item& item = out.back();
+        data->metadata.GetValue( &item.buffer, &item.size );
+        item.autofree = true;
+        item.type = data->typeCode.GetValue();
     }
 
-    genericItemListFree( itemList ); // free
     return false;
 }
 
@@ -103,6 +103,39 @@ public:
     ///
     static bool get( MP4FileHandle hFile, Item& item, uint32_t index );
 
+    /// Count covr-box items in file.
+    ///
+    /// @param hFile on which to operate.
+    ///
+    /// @return number of images.
+    ///
+    static uint32_t count( MP4FileHandle hFile );
+
+    /// Fetch type and size of covr-box item without its data.
+    /// <b>item.buffer</b> is left NULL, use read() for the image bytes.
+    ///
+    /// @param hFile on which to operate.
+    /// @param item covr-box object populated with type and size.
+    /// @param index 0-based index of image.
+    ///
+    /// @return <b>true</b> on failure, <b>false</b> on success.
+    ///
+    static bool info( MP4FileHandle hFile, Item& item, uint32_t index );
+
+    /// Read part of covr-box item data into a caller supplied buffer.
+    /// For files opened with MP4Read() the bytes come straight from the
+    /// file and the image is not kept in memory.
+    ///
+    /// @param hFile on which to operate.
+    /// @param index 0-based index of image.
+    /// @param offset of first byte to read within the image.
+    /// @param buffer receiving <b>size</b> bytes.
+    /// @param size number of bytes to read.
+    ///
+    /// @return <b>true</b> on failure, <b>false</b> on success.
+    ///
+    static bool read( MP4FileHandle hFile, uint32_t index, uint32_t offset, uint8_t* buffer, uint32_t size );
+
     /// Remove covr-box item from file.
     ///
     /// @param hFile on which to operate.
@@ -112,6 +145,9 @@ public:
     /// @return <b>true</b> on failure, <b>false</b> on success.
     ///
     static bool remove( MP4FileHandle hFile, uint32_t index = numeric_limits<uint32_t>::max() );
+
+private:
+    static MP4DataAtom* findData( MP4Atom& covr, uint32_t index );
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -32,6 +32,7 @@ namespace mp4v2 { namespace impl { namespace itmf {
 
 Tags::Tags()
     : hasMetadata(false)
+    , artworkFetched(true)
 {
 }
 
@@ -64,14 +65,15 @@ Tags::c_alloc( MP4Tags*& tags )
 ///////////////////////////////////////////////////////////////////////////////
 
 void
-Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile )
+Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile, bool fetchArtwork )
 {
     MP4Tags& c = *tags;
     MP4File& file = *static_cast<MP4File*>(hFile);
 
-    MP4ItmfItemList* itemList = genericGetItems( file ); // alloc
+    // cover art is fetched below with CoverArtBox, if at all
+    MP4ItmfItemList* itemList = genericGetItems( file, false ); // alloc
 
-    hasMetadata = (itemList->size > 0);
+    hasMetadata = (itemList->size > 0) || CoverArtBox::count( hFile ) > 0;
 
     /* create code -> item map.
      * map will only be used for items which do not repeat; we do not care if
@@ -147,11 +149,12 @@ Tags::c_fetch( MP4Tags*& tags, MP4FileHandle hFile )
     // fetch full list and overwrite our copy, otherwise clear
     {
         CoverArtBox::ItemList items;
-        if( CoverArtBox::list( hFile, items ))
+        if( !fetchArtwork || CoverArtBox::list( hFile, items ))
             artwork.clear();
         else
-            artwork = items;
+            artwork.swap( items );
 
+        artworkFetched = fetchArtwork;
         updateArtworkShadow( tags );
     }
 }
@@ -333,12 +336,15 @@ Tags::c_setDisk( const MP4TagDisk* value, MP4TagDisk& cpp, const MP4TagDisk*& c
 
 ///////////////////////////////////////////////////////////////////////////////
 
-void
+bool
 Tags::c_store( MP4Tags*& tags, MP4FileHandle hFile )
 {
     MP4Tags& c = *tags;
     MP4File& file = *static_cast<MP4File*>(hFile);
-   
+
+    // the store* calls only collect what differs from the file
+    changes.clear();
+
     storeString(  file, CODE_NAME,              name,              c.name );
     storeString(  file, CODE_ARTIST,            artist,            c.artist );
     storeString(  file, CODE_ALBUMARTIST,       albumArtist,       c.albumArtist );
@@ -398,13 +404,17 @@ Tags::c_store( MP4Tags*& tags, MP4FileHandle hFile )
     storeInteger( file, CODE_COMPOSERID,        composerID,        c.composerID );
     storeString(  file, CODE_XID,               xid,               c.xid );
 
-    // destroy all cover-art then add each
-    {
-        CoverArtBox::remove( hFile );
-        const CoverArtBox::ItemList::size_type max = artwork.size();
-        for( CoverArtBox::ItemList::size_type i = 0; i < max; i++ )
-            CoverArtBox::add( hFile, artwork[i] );
+    bool changed = applyChanges( file );
+    if( storeArtwork( hFile ))
+        changed = true;
+
+    // images added after a fetch without artwork are in the file now
+    if( !artworkFetched && !artwork.empty() ) {
+        artwork.clear();
+        updateArtworkShadow( tags );
     }
+
+    return changed;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -606,12 +616,15 @@ Tags::fetchString( const CodeItemMap& cim, const string& code, string& cpp, cons
 void
 Tags::remove( MP4File& file, const string& code )
 {
-    MP4ItmfItemList* itemList = genericGetItemsByCode( file, code ); // alloc
-
-    if( itemList->size )
-        genericRemoveItem( file, &itemList->elements[0] );
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
+    if( !ilst || ilst->FindItems( code.c_str() ).empty() )
+        return;
 
-    genericItemListFree( itemList ); // free
+    ItemChange change;
+    change.code      = code;
+    change.remove    = true;
+    change.basicType = MP4_ITMF_BT_IMPLICIT;
+    changes.push_back( change );
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -619,20 +632,168 @@ Tags::remove( MP4File& file, const string& code )
 void
 Tags::store( MP4File& file, const string& code, MP4ItmfBasicType basicType, const void* buffer, uint32_t size )
 {
-    // remove existing item
-    remove( file, code );
+    // nothing to do if the file holds just this value
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
+    if( ilst ) {
+        const MP4ItemListAtom::ItemList& items = ilst->FindItems( code.c_str() );
+        if( items.size() == 1 && isItemValue( *items[0], basicType, buffer, size ))
+            return;
+    }
+
+    ItemChange change;
+    change.code      = code;
+    change.remove    = false;
+    change.basicType = basicType;
+    change.value.assign( static_cast<const char*>( buffer ), size );
+    changes.push_back( change );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+Tags::applyChanges( MP4File& file )
+{
+    if( changes.empty() )
+        return false;
+
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
+
+    const ItemChangeList::size_type max = changes.size();
+    for( ItemChangeList::size_type i = 0; i < max; i++ ) {
+        const ItemChange& change = changes[i];
+
+        MP4ItemAtom* item = NULL;
+        if( ilst ) {
+            const MP4ItemListAtom::ItemList& items = ilst->FindItems( change.code.c_str() );
+            if( !items.empty() )
+                item = items.front();
+        }
+
+        if( change.remove ) {
+            if( item ) {
+                ilst->DeleteChildAtom( item );
+                delete item;
+            }
+            continue;
+        }
+
+        // a plain item gets the new value where it is
+        if( item && item->GetNumberOfChildAtoms() == 1 &&
+            ATOMID( item->GetChildAtom( 0 )->GetType() ) == ATOMID( "data" ))
+        {
+            MP4DataAtom& data = *static_cast<MP4DataAtom*>( item->GetChildAtom( 0 ));
+            data.typeSetIdentifier.SetValue( 0 );
+            data.typeCode.SetValue( static_cast<BasicType>( change.basicType ));
+            data.locale.SetValue( 0 );
+            data.metadata.SetValue( reinterpret_cast<const uint8_t*>( change.value.data() ), (uint32_t)change.value.size() );
+            continue;
+        }
+
+        // anything else is replaced
+        if( item ) {
+            ilst->DeleteChildAtom( item );
+            delete item;
+        }
+
+        MP4ItmfItem& model = *genericItemAlloc( change.code, 1 ); // alloc
+        MP4ItmfData& data = model.dataList.elements[0];
+
+        data.typeCode = change.basicType;
+        data.valueSize = (uint32_t)change.value.size();
+        data.value = (uint8_t*)malloc( data.valueSize );
+        memcpy( data.value, change.value.data(), data.valueSize );
+
+        genericAddItem( file, &model );
+        genericItemFree( &model ); // free
+
+        // the first item added creates ilst
+        if( !ilst )
+            ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
+    }
+
+    changes.clear();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+Tags::storeArtwork( MP4FileHandle hFile )
+{
+    const CoverArtBox::ItemList::size_type max = artwork.size();
+
+    // without a fetch of the artwork the list only holds images to add
+    if( artworkFetched ) {
+        bool same = ( CoverArtBox::count( hFile ) == max );
+        for( CoverArtBox::ItemList::size_type i = 0; same && i < max; i++ )
+            same = isArtwork( hFile, (uint32_t)i, artwork[i] );
+
+        if( same )
+            return false;
+
+        // destroy all cover-art then add each
+        CoverArtBox::remove( hFile );
+    }
 
-    // add item
-    MP4ItmfItem& item = *genericItemAlloc( code, 1 ); // alloc
-    MP4ItmfData& data = item.dataList.elements[0];
+    for( CoverArtBox::ItemList::size_type i = 0; i < max; i++ )
+        CoverArtBox::add( hFile, artwork[i] );
 
-    data.typeCode = basicType;
-    data.valueSize = size;
-    data.value = (uint8_t*)malloc( data.valueSize );
-    memcpy( data.value, buffer, data.valueSize );
+    return max > 0 || artworkFetched;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+Tags::isItemValue( MP4ItemAtom& item, MP4ItmfBasicType basicType, const void* buffer, uint32_t size )
+{
+    // store() writes a single data atom with no type set or locale
+    if( item.GetNumberOfChildAtoms() != 1 )
+        return false;
+
+    MP4Atom* const atom = item.GetChildAtom( 0 );
+    if( ATOMID( atom->GetType() ) != ATOMID( "data" ))
+        return false;
+
+    MP4DataAtom& data = *static_cast<MP4DataAtom*>( atom );
+    if( data.typeSetIdentifier.GetValue() != 0 ||
+        data.typeCode.GetValue() != static_cast<BasicType>( basicType ) ||
+        data.locale.GetValue() != 0 ||
+        data.metadata.GetValueSize() != size )
+    {
+        return false;
+    }
+
+    return !data.metadata.CompareToString( string( static_cast<const char*>( buffer ), size ));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+Tags::isArtwork( MP4FileHandle hFile, uint32_t index, const CoverArtBox::Item& item )
+{
+    CoverArtBox::Item stored;
+    if( CoverArtBox::info( hFile, stored, index ))
+        return false;
+
+    // CoverArtBox::set() detects undefined types
+    const BasicType type = ( item.type == BT_UNDEFINED )
+        ? computeBasicType( item.buffer, item.size )
+        : item.type;
+
+    if( stored.type != type || stored.size != item.size )
+        return false;
+
+    // compare in pieces, the stored image may not be in memory
+    uint8_t buffer[16384];
+    for( uint32_t offset = 0; offset < item.size; offset += sizeof( buffer )) {
+        const uint32_t size = min( item.size - offset, (uint32_t)sizeof( buffer ));
+        if( CoverArtBox::read( hFile, index, offset, buffer, size ))
+            return false;
+        if( memcmp( buffer, item.buffer + offset, size ))
+            return false;
+    }
 
-    genericAddItem( file, &item );
-    genericItemFree( &item ); // free
+    return true;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -151,13 +151,17 @@ public:
 
     bool     hasMetadata;
 
+    // false after a fetch without artwork, artwork then only holds images
+    // added since and c_store() keeps those already in the file
+    bool     artworkFetched;
+
 public:
     Tags();
     ~Tags();
 
     void c_alloc ( MP4Tags*& );
-    void c_fetch ( MP4Tags*&, MP4FileHandle );
-    void c_store ( MP4Tags*&, MP4FileHandle );
+    void c_fetch ( MP4Tags*&, MP4FileHandle, bool fetchArtwork = true );
+    bool c_store ( MP4Tags*&, MP4FileHandle );
     void c_free  ( MP4Tags*& );
 
     void c_addArtwork    ( MP4Tags*&, MP4TagArtwork& );
@@ -176,6 +180,19 @@ public:
 private:
     typedef map<string,MP4ItmfItem*> CodeItemMap;
 
+    // an item to store, or to remove when remove is true
+    struct ItemChange {
+        string           code;
+        bool             remove;
+        MP4ItmfBasicType basicType;
+        string           value;
+    };
+
+    typedef vector<ItemChange> ItemChangeList;
+
+    // items c_store() found to differ from the file, applied in one go
+    ItemChangeList changes;
+
 private:
     void fetchString  ( const CodeItemMap&, const string&, string&, const char*& );
     void fetchInteger ( const CodeItemMap&, const string&, uint8_t&,  const uint8_t*& );
@@ -200,6 +217,12 @@ private:
     void remove ( MP4File&, const string& );
     void store  ( MP4File&, const string&, MP4ItmfBasicType, const void*, uint32_t );
 
+    bool applyChanges  ( MP4File& );
+    bool storeArtwork  ( MP4FileHandle );
+
+    static bool isItemValue ( MP4ItemAtom&, MP4ItmfBasicType, const void*, uint32_t );
+    static bool isArtwork   ( MP4FileHandle, uint32_t, const CoverArtBox::Item& );
+
     void updateArtworkShadow( MP4Tags*& );
 };
 
@@ -291,21 +291,31 @@ genericItemListFree( MP4ItmfItemList* list )
 ///////////////////////////////////////////////////////////////////////////////
 
 MP4ItmfItemList*
-genericGetItems( MP4File& file )
+genericGetItems( MP4File& file, bool artwork )
 {
     MP4Atom* ilst = file.FindAtom( "moov.udta.meta.ilst" );
     if( !ilst )
         return __itemListAlloc();
 
-    const uint32_t itemCount = ilst->GetNumberOfChildAtoms();
+    const uint32_t childCount = ilst->GetNumberOfChildAtoms();
+    uint32_t itemCount = 0;
+    for( uint32_t i = 0; i < childCount; i++ ) {
+        if( artwork || ATOMID( ilst->GetChildAtom( i )->GetType() ) != ATOMID( "covr" ))
+            itemCount++;
+    }
+
     if( itemCount < 1 )
         return __itemListAlloc();
 
     MP4ItmfItemList& list = *__itemListAlloc();
     __itemListResize( list, itemCount );
 
-    for( uint32_t i = 0; i < list.size; i++ )
-        __itemAtomToModel( *(MP4ItemAtom*)ilst->GetChildAtom( i ), list.elements[i] );
+    for( uint32_t i = 0, iitem = 0; i < childCount; i++ ) {
+        MP4ItemAtom& item_atom = *(MP4ItemAtom*)ilst->GetChildAtom( i );
+        if( !artwork && ATOMID( item_atom.GetType() ) == ATOMID( "covr" ))
+            continue;
+        __itemAtomToModel( item_atom, list.elements[iitem++] );
+    }
 
     return &list;
 }
@@ -315,31 +325,19 @@ genericGetItems( MP4File& file )
 MP4ItmfItemList*
 genericGetItemsByCode( MP4File& file, const string& code )
 {
-    MP4Atom* ilst = file.FindAtom( "moov.udta.meta.ilst" );
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
     if( !ilst )
         return __itemListAlloc();
 
-    // pass 1: filter by code and populate indexList
-    const uint32_t childCount = ilst->GetNumberOfChildAtoms();
-    vector<uint32_t> indexList;
-    for( uint32_t i = 0; i < childCount; i++ ) {
-        if( ATOMID( ilst->GetChildAtom( i )->GetType() ) != ATOMID( code.c_str() ))
-            continue;
-        indexList.push_back( i );
-    }
-
-    if( indexList.size() < 1 )
+    const MP4ItemListAtom::ItemList& items = ilst->FindItems( code.c_str() );
+    if( items.size() < 1 )
         return __itemListAlloc();
 
     MP4ItmfItemList& list = *__itemListAlloc();
-    __itemListResize( list, (uint32_t)indexList.size() );
+    __itemListResize( list, (uint32_t)items.size() );
 
-    // pass 2: process each atom
-    const vector<uint32_t>::size_type max = indexList.size();
-    for( vector<uint32_t>::size_type i = 0; i < max; i++ ) {
-        uint32_t& aidx = indexList[i];
-        __itemAtomToModel( *(MP4ItemAtom*)ilst->GetChildAtom( aidx ), list.elements[i] );
-    }
+    for( uint32_t i = 0; i < list.size; i++ )
+        __itemAtomToModel( *items[i], list.elements[i] );
 
     return &list;
 }
@@ -349,49 +347,35 @@ genericGetItemsByCode( MP4File& file, const string& code )
 MP4ItmfItemList*
 genericGetItemsByMeaning( MP4File& file, const string& meaning, const string& name )
 {
-    MP4Atom* ilst = file.FindAtom( "moov.udta.meta.ilst" );
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
     if( !ilst )
         return __itemListAlloc();
 
-    // pass 1: filter by code and populate indexList
-    const uint32_t childCount = ilst->GetNumberOfChildAtoms();
-    vector<uint32_t> indexList;
-    for( uint32_t i = 0; i < childCount; i++ ) {
-        MP4Atom& atom = *ilst->GetChildAtom( i );
-        if( ATOMID( atom.GetType() ) != ATOMID( "----" ))
-            continue;
-
-        // filter-out meaning mismatch
-        MP4MeanAtom* meanAtom = (MP4MeanAtom*)atom.FindAtom( "----.mean" );
-        if( !meanAtom )
-            continue;
-        if( meanAtom->value.CompareToString( meaning ))
-            continue;
-
+    // pass 1: filter by name
+    const MP4ItemListAtom::ItemList& items = ilst->FindFreeformItems( meaning );
+    vector<MP4ItemAtom*> matches;
+    for( MP4ItemListAtom::ItemList::const_iterator it = items.begin(); it != items.end(); ++it ) {
         if( !name.empty() ) {
             // filter-out name mismatch
-            MP4MeanAtom* nameAtom = (MP4MeanAtom*)atom.FindAtom( "----.name" );
+            MP4NameAtom* nameAtom = (MP4NameAtom*)(*it)->FindAtom( "----.name" );
             if( !nameAtom )
                 continue;
             if( nameAtom->value.CompareToString( name ))
                 continue;
         }
 
-        indexList.push_back( i );
+        matches.push_back( *it );
     }
 
-    if( indexList.size() < 1 )
+    if( matches.size() < 1 )
         return __itemListAlloc();
 
     MP4ItmfItemList& list = *__itemListAlloc();
-    __itemListResize( list, (uint32_t)indexList.size() );
+    __itemListResize( list, (uint32_t)matches.size() );
 
     // pass 2: process each atom
-    const vector<uint32_t>::size_type max = indexList.size();
-    for( vector<uint32_t>::size_type i = 0; i < max; i++ ) {
-        uint32_t& aidx = indexList[i];
-        __itemAtomToModel( *(MP4ItemAtom*)ilst->GetChildAtom( aidx ), list.elements[i] );
-    }
+    for( uint32_t i = 0; i < list.size; i++ )
+        __itemAtomToModel( *matches[i], list.elements[i] );
 
     return &list;
 }
@@ -473,4 +457,24 @@ genericRemoveItem( MP4File& file, const MP4ItmfItem* item )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool
+genericRemoveItemByCode( MP4File& file, const string& code )
+{
+    MP4ItemListAtom* ilst = static_cast<MP4ItemListAtom*>( file.FindAtom( "moov.udta.meta.ilst" ));
+    if( !ilst )
+        return false;
+
+    const MP4ItemListAtom::ItemList& items = ilst->FindItems( code.c_str() );
+    if( items.empty() )
+        return false;
+
+    MP4ItemAtom* const old = items.front();
+    ilst->DeleteChildAtom( old );
+    delete old;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 }}} // namespace mp4v2::impl::itmf
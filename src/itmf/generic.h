@@ -39,8 +39,9 @@ genericItemListFree( MP4ItmfItemList* list );
 
 ///////////////////////////////////////////////////////////////////////////////
 
+// covr items are left out unless artwork is true
 MP4ItmfItemList*
-genericGetItems( MP4File& file );
+genericGetItems( MP4File& file, bool artwork = true );
 
 MP4ItmfItemList*
 genericGetItemsByCode( MP4File& file, const string& code );
@@ -59,6 +60,10 @@ genericSetItem( MP4File& file, const MP4ItmfItem* item );
 bool
 genericRemoveItem( MP4File& file, const MP4ItmfItem* item );
 
+// remove the first item of code, false if there is none
+bool
+genericRemoveItemByCode( MP4File& file, const string& code );
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }}} // namespace mp4v2::impl::itmf
@@ -41,6 +41,9 @@ Log log(MP4_LOG_ERROR);
  */
 Log::Log( MP4LogLevel verbosity_ /* = MP4_LOG_NONE */ )
     : _verbosity ( verbosity_ )
+    , _sink      ( NULL )
+    , _sinkData  ( NULL )
+    , _sinkFile  ( MP4_INVALID_FILE_HANDLE )
     , verbosity  ( _verbosity )
 {
 }
@@ -69,6 +72,31 @@ Log::setLogCallback( MP4LogCallback value )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Mutator for the record sink
+ *
+ * @param sink the function to pass records to, or NULL to log to the
+ * callback function or standard out again
+ *
+ * @param userData passed through to @p sink
+ *
+ * @param file the file this log is about, reported in each record
+ *
+ * The three values are stored without synchronization, so this must not be
+ * called while another thread may log through this object.
+ */
+void
+Log::setSink( MP4LogSink    sink,
+              void*         userData,
+              MP4FileHandle file /* = MP4_INVALID_FILE_HANDLE */ )
+{
+    _sink     = sink;
+    _sinkData = userData;
+    _sinkFile = file;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 /**
  * Mutator for the verbosity
  *
@@ -278,7 +306,7 @@ Log::vdump( uint8_t     indent,
         return;
     }
 
-    if (Log::_cb_func)
+    if (_sink || Log::_cb_func)
     {
         ostringstream   new_format;
 
@@ -288,11 +316,11 @@ Log::vdump( uint8_t     indent,
             // new_format << setw(indent) << setfill(' ') << "" << setw(0);
             // new_format << format;
             new_format << indent_str << format;
-            Log::_cb_func(verbosity_,new_format.str().c_str(),ap);
+            this->vprintf(verbosity_,new_format.str().c_str(),ap);
             return;
         }
 
-        Log::_cb_func(verbosity_,format,ap);
+        this->vprintf(verbosity_,format,ap);
         return;
     }
 
@@ -359,6 +387,13 @@ Log::vprintf( MP4LogLevel       verbosity_,
         return;
     }
 
+    if (_sink)
+    {
+        this->vrecord(verbosity_,MP4_LOG_CODE_NONE,MP4_INVALID_TRACK_ID,
+                      MP4_INVALID_SAMPLE_ID,format,ap);
+        return;
+    }
+
     if (Log::_cb_func)
     {
         Log::_cb_func(verbosity_,format,ap);
@@ -372,6 +407,117 @@ Log::vprintf( MP4LogLevel       verbosity_,
 
 ///////////////////////////////////////////////////////////////////////////////
 
+/**
+ * Log a message along with what it is about
+ *
+ * @param verbosity the level of detail the message contains
+ *
+ * @param code the kind of message
+ *
+ * @param trackId the track the message is about, or MP4_INVALID_TRACK_ID
+ *
+ * @param sampleId the sample the message is about, or MP4_INVALID_SAMPLE_ID
+ *
+ * @param format the format string to use to process the
+ * remaining arguments.  @p format should not contain a
+ * newline.
+ */
+void
+Log::recordf( MP4LogLevel       verbosity_,
+              MP4LogCode        code,
+              MP4TrackId        trackId,
+              MP4SampleId       sampleId,
+              const char*       format,
+              ... )
+{
+    va_list     ap;
+
+    va_start(ap,format);
+    this->vrecord(verbosity_,code,trackId,sampleId,format,ap);
+    va_end(ap);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Pass a message as a record to the sink if it has appropriate
+ * verbosity.  Without a sink only the message is logged, as
+ * by vprintf.
+ *
+ * The message is formatted on the stack of the calling thread
+ * (the heap is only used for long ones) and the sink is called
+ * right away, so logs of different files share no state.
+ *
+ * @param verbosity the level of detail the message contains
+ *
+ * @param code the kind of message
+ *
+ * @param trackId the track the message is about, or MP4_INVALID_TRACK_ID
+ *
+ * @param sampleId the sample the message is about, or MP4_INVALID_SAMPLE_ID
+ *
+ * @param format the format string to use to process @p ap.
+ * @p format should not contain a newline.
+ *
+ * @param ap varargs to build the message
+ */
+void
+Log::vrecord( MP4LogLevel       verbosity_,
+              MP4LogCode        code,
+              MP4TrackId        trackId,
+              MP4SampleId       sampleId,
+              const char*       format,
+              va_list           ap )
+{
+    ASSERT(verbosity_ != MP4_LOG_NONE);
+    ASSERT(format);
+
+    if (verbosity_ > this->_verbosity)
+    {
+        // We're not set verbose enough to log this
+        return;
+    }
+
+    if (!_sink)
+    {
+        this->vprintf(verbosity_,format,ap);
+        return;
+    }
+
+    char        buffer[512];
+    char*       message = buffer;
+    va_list     ap2;
+
+    va_copy(ap2,ap);
+    int len = ::vsnprintf(buffer,sizeof(buffer),format,ap);
+    if (len < 0)
+    {
+        buffer[0] = '\0';
+    }
+    else if ((size_t)len >= sizeof(buffer))
+    {
+        message = (char*)MP4Malloc(len + 1);
+        ::vsnprintf(message,len + 1,format,ap2);
+    }
+    va_end(ap2);
+
+    MP4LogRecord record;
+    record.level    = verbosity_;
+    record.code     = code;
+    record.file     = _sinkFile;
+    record.trackId  = trackId;
+    record.sampleId = sampleId;
+    record.message  = message;
+    _sink(&record,_sinkData);
+
+    if (message != buffer)
+    {
+        MP4Free(message);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 /**
  * Log a buffer as ascii-hex
  *
@@ -495,7 +641,8 @@ Log::hexDump( uint8_t           indent,
 void
 Log::errorf ( const Exception&      x )
 {
-    this->printf(MP4_LOG_ERROR,"%s",x.msg().c_str());
+    this->recordf(MP4_LOG_ERROR,MP4_LOG_CODE_EXCEPTION,MP4_INVALID_TRACK_ID,
+                  MP4_INVALID_SAMPLE_ID,"%s",x.msg().c_str());
 }
 
 ///////////////////////////////////////////////////////////////////////////////
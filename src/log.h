@@ -37,6 +37,11 @@ private:
     MP4LogLevel                 _verbosity;
     static MP4LogCallback       _cb_func;
 
+    // records go to _sink instead of _cb_func or stdout if set
+    MP4LogSink                  _sink;
+    void*                       _sinkData;
+    MP4FileHandle               _sinkFile;
+
 public:
     const MP4LogLevel&          verbosity;
 
@@ -48,6 +53,12 @@ public:
 
     void setVerbosity   ( MP4LogLevel );
 
+    bool isEnabled ( MP4LogLevel verbosity_ ) const { return verbosity_ <= _verbosity; }
+
+    void setSink ( MP4LogSink     sink,
+                   void*          userData,
+                   MP4FileHandle  file = MP4_INVALID_FILE_HANDLE );
+
     void errorf ( const char* format, ... ) MP4V2_WFORMAT_PRINTF(2,3);
     void warningf ( const char* format, ... ) MP4V2_WFORMAT_PRINTF(2,3);
     void infof ( const char* format, ... ) MP4V2_WFORMAT_PRINTF(2,3);
@@ -67,6 +78,17 @@ public:
     void vprintf ( MP4LogLevel  verbosity_,
                    const char*  format, va_list ap );
 
+    void recordf ( MP4LogLevel  verbosity_,
+                   MP4LogCode   code,
+                   MP4TrackId   trackId,
+                   MP4SampleId  sampleId,
+                   const char*  format, ... ) MP4V2_WFORMAT_PRINTF(6,7);
+    void vrecord ( MP4LogLevel  verbosity_,
+                   MP4LogCode   code,
+                   MP4TrackId   trackId,
+                   MP4SampleId  sampleId,
+                   const char*  format, va_list ap );
+
     void hexDump ( uint8_t              indent,
                    MP4LogLevel          verbosity_,
                    const uint8_t*       pBytes,
@@ -86,6 +108,36 @@ private:
  * to one
  */
 extern Log log;
+
+///////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Level-guarded logging for per-sample and per-chunk code paths.
+ *
+ * The arguments are only evaluated, and the variadic call is only made,
+ * once the level is known to be enabled. Levels beyond
+ * MP4V2_LOG_MAX_LEVEL are compiled out entirely.
+ */
+#ifndef MP4V2_LOG_MAX_LEVEL
+#   define MP4V2_LOG_MAX_LEVEL MP4_LOG_VERBOSE4
+#endif
+
+#define MP4V2_LOG_ENABLED(lg,level) \
+    ( (level) <= MP4V2_LOG_MAX_LEVEL && (lg).isEnabled( level ))
+
+#define MP4V2_LOG_VERBOSE1F(lg,...) \
+    do { if( MP4V2_LOG_ENABLED( lg, MP4_LOG_VERBOSE1 )) (lg).verbose1f( __VA_ARGS__ ); } while( 0 )
+#define MP4V2_LOG_VERBOSE2F(lg,...) \
+    do { if( MP4V2_LOG_ENABLED( lg, MP4_LOG_VERBOSE2 )) (lg).verbose2f( __VA_ARGS__ ); } while( 0 )
+#define MP4V2_LOG_VERBOSE3F(lg,...) \
+    do { if( MP4V2_LOG_ENABLED( lg, MP4_LOG_VERBOSE3 )) (lg).verbose3f( __VA_ARGS__ ); } while( 0 )
+#define MP4V2_LOG_VERBOSE4F(lg,...) \
+    do { if( MP4V2_LOG_ENABLED( lg, MP4_LOG_VERBOSE4 )) (lg).verbose4f( __VA_ARGS__ ); } while( 0 )
+
+// arguments after level: code, trackId, sampleId, format, ...
+#define MP4V2_LOG_RECORDF(lg,level,...) \
+    do { if( MP4V2_LOG_ENABLED( lg, level )) (lg).recordf( level, __VA_ARGS__ ); } while( 0 )
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} // namespace mp4v2::impl
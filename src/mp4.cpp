@@ -74,11 +74,11 @@ const char* MP4GetFilename( MP4FileHandle hFile )
         return file.GetFilename().c_str();
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: unknown exception accessing MP4File "
+        LogOfFile(hFile).errorf("%s: unknown exception accessing MP4File "
                                 "filename", __FUNCTION__ );
     }
 
@@ -87,6 +87,56 @@ const char* MP4GetFilename( MP4FileHandle hFile )
 
 ///////////////////////////////////////////////////////////////////////////////
 
+bool MP4GetFileStats( MP4FileHandle hFile, MP4FileStats* stats )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ) || !stats )
+        return false;
+
+    *stats = ((MP4File*)hFile)->GetStats();
+    return true;
+}
+
+bool MP4SetFileStatsTiming( MP4FileHandle hFile, bool enable )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return false;
+
+    ((MP4File*)hFile)->SetStatsTiming( enable );
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MP4SetLogSink(
+    MP4FileHandle hFile,
+    MP4LogSink    sink,
+    void*         userData,
+    MP4LogLevel   verbosity )
+{
+    try
+    {
+        if( !MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            mp4v2::impl::log.setSink( sink, userData );
+            mp4v2::impl::log.setVerbosity( verbosity );
+            return true;
+        }
+
+        ((MP4File*)hFile)->SetLogSink( sink, userData, verbosity );
+        return true;
+    }
+    catch( Exception* x ) {
+        mp4v2::impl::log.errorf(*x);
+        delete x;
+    }
+    catch( ... ) {
+        mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 MP4FileHandle MP4Read( const char* fileName, ShouldParseAtomCallback cb/*=nullptr*/ )
 {
     if (!fileName)
@@ -206,7 +256,7 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         try {
             ASSERT(pFile);
             // LATER useExtensibleFormat, moov first, then mvex's
-            if (pFile->Modify(fileName))
+            if (pFile->Modify(fileName, flags))
                 return (MP4FileHandle)pFile;
         }
         catch( Exception* x ) {
@@ -265,11 +315,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             f.Close(flags);
         }
         catch( Exception* x ) {
-            mp4v2::impl::log.errorf(*x);
+            LogOfFile(hFile).errorf(*x);
             delete x;
         }
         catch( ... ) {
-            mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+            LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
         }
 
         delete &f;
@@ -285,11 +335,46 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    uint64_t MP4EstimateMoovSize(MP4FileHandle hFile)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                return ((MP4File*)hFile)->EstimateMoovSize();
+            }
+            catch( Exception* x ) {
+                LogOfFile(hFile).errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return 0;
+    }
+
+    bool MP4SetMoovPadding(MP4FileHandle hFile, uint32_t padding)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                ((MP4File*)hFile)->SetMoovPadding(padding);
+                return true;
+            }
+            catch( Exception* x ) {
+                LogOfFile(hFile).errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -302,11 +387,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetDuration();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -319,11 +404,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTimeScale();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -337,11 +422,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -354,11 +439,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetODProfileLevel();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -372,11 +457,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -389,11 +474,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetSceneProfileLevel();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -407,11 +492,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -425,11 +510,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetVideoProfileLevel();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
             if (MP4_IS_VALID_TRACK_ID(trackId)) {
                 uint8_t *foo;
@@ -470,11 +555,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return ;
@@ -487,11 +572,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetAudioProfileLevel();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -504,11 +589,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 ((MP4File*)hFile)->SetAudioProfileLevel(value);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -520,11 +605,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetGraphicsProfileLevel();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -538,11 +623,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -556,11 +641,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             try {
                 return ((MP4File *)hFile)->FindAtom(atomName) != NULL;
             } catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -575,11 +660,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -594,11 +679,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -614,11 +699,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -634,11 +719,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *ppValue = NULL;
@@ -655,11 +740,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -674,11 +759,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -693,11 +778,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -713,11 +798,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -733,11 +818,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddSystemsTrack(type, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -751,11 +836,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddSystemsTrack(type);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -768,11 +853,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddODTrack();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -785,11 +870,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddSceneTrack();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -805,11 +890,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        AddULawAudioTrack(timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -825,11 +910,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        AddALawAudioTrack(timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -847,11 +932,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        AddAudioTrack(timeScale, sampleDuration, audioType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -888,11 +973,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                     AddAC3AudioTrack(samplingRate, fscod, bsid, bsmod, acmod, lfeon, bit_rate_code);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -920,11 +1005,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                             icPp->selective_enc, icPp->kms_uri, true);
                 }
             } catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -943,11 +1028,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        AddAmrAudioTrack(timeScale, modeSet, modeChangePeriod, framesPerSample, isAmrWB);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -964,11 +1049,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetAmrVendor(trackId, vendor);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -984,11 +1069,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetAmrDecoderVersion(trackId, decoderVersion);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1004,11 +1089,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetAmrModeSet(trackId, modeSet);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1023,11 +1108,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        GetAmrModeSet(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -1047,11 +1132,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                            base_url);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1066,11 +1151,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                         "mdia.minf.stbl.stsd.href.burl.base_url");
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return NULL;
@@ -1095,11 +1180,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                                videoType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1122,11 +1207,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                                 height);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1160,11 +1245,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                                oFormat);
 
             } catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1178,11 +1263,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddColr(refTrackId, pri, tran, mat);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1213,11 +1298,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                                 sampleLenFieldSizeMinusOne);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1256,11 +1341,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                                    icPp);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1281,11 +1366,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return;
@@ -1305,11 +1390,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return;
@@ -1332,11 +1417,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        AddH263VideoTrack(timeScale, sampleDuration, width, height, h263Level, h263Profile, avgBitrate, maxBitrate);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
 
@@ -1354,11 +1439,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetH263Vendor(trackId, vendor);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1375,11 +1460,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetH263DecoderVersion(trackId, decoderVersion);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1397,11 +1482,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 SetH263Bitrates(trackId, avgBitrate, maxBitrate);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1414,11 +1499,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddHintTrack(refTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1432,11 +1517,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddTextTrack(refTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1452,11 +1537,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddSubtitleTrack(timescale, width, height);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1472,11 +1557,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddSubpicTrack(timescale, width, height);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1490,11 +1575,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddChapterTextTrack(refTrackId, timescale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1508,11 +1593,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->AddPixelAspectRatio(refTrackId, hSpacing, vSpacing);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -1526,15 +1611,34 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 ((MP4File*)hFile)->AddChapter(chapterTrackId, chapterDuration, chapterTitle);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
 
+    bool MP4AddChapters(
+        MP4FileHandle hFile, MP4TrackId chapterTrackId, const MP4Chapter_t *chapterList, uint32_t chapterCount)
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                ((MP4File*)hFile)->AddChapters(chapterTrackId, chapterList, chapterCount);
+                return true;
+            }
+            catch( Exception* x ) {
+                LogOfFile(hFile).errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
     void MP4AddNeroChapter(
         MP4FileHandle hFile, MP4Timestamp chapterStart, const char *chapterTitle)
     {
@@ -1543,11 +1647,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 ((MP4File*)hFile)->AddNeroChapter(chapterStart, chapterTitle);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1561,11 +1665,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->ConvertChapters(toChapterType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4ChapterTypeNone;
@@ -1579,11 +1683,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->DeleteChapters(fromChapterType, chapterTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4ChapterTypeNone;
@@ -1597,11 +1701,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetChapters(chapterList, chapterCount, fromChapterType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4ChapterTypeNone;
@@ -1615,11 +1719,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->SetChapters(chapterList, chapterCount, toChapterType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4ChapterTypeNone;
@@ -1633,11 +1737,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 ((MP4File*)hFile)->ChangeMovieTimeScale(value);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
     }
@@ -1783,13 +1887,13 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             // copy track ES configuration
             uint8_t* pConfig = NULL;
             uint32_t configSize = 0;
-            MP4LogLevel verb = mp4v2::impl::log.verbosity;
-            mp4v2::impl::log.setVerbosity(MP4_LOG_NONE);
+            MP4LogLevel verb = LogOfFile(srcFile).verbosity;
+            LogOfFile(srcFile).setVerbosity(MP4_LOG_NONE);
             bool haveEs = MP4GetTrackESConfiguration(srcFile,
                           srcTrackId,
                           &pConfig,
                           &configSize);
-            mp4v2::impl::log.setVerbosity(verb);
+            LogOfFile(srcFile).setVerbosity(verb);
             if (haveEs &&
                     pConfig != NULL && configSize != 0) {
                 if (!MP4SetTrackESConfiguration(
@@ -1991,14 +2095,15 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         return dstTrackId;
     }
 
-    MP4TrackId MP4CopyTrack(MP4FileHandle srcFile,
-                            MP4TrackId srcTrackId,
-                            MP4FileHandle dstFile,
-                            bool applyEdits,
-                            MP4TrackId dstHintTrackReferenceTrack)
+// Copy or reference the samples of a track, see MP4CopyTrack()
+// and MP4ReferenceTrack()
+    static MP4TrackId CopyOrReferenceTrack(MP4FileHandle srcFile,
+                                           MP4TrackId srcTrackId,
+                                           MP4FileHandle dstFile,
+                                           bool applyEdits,
+                                           MP4TrackId dstHintTrackReferenceTrack,
+                                           bool copySamples)
     {
-        bool copySamples = true;  // LATER allow false => reference samples
-
         MP4TrackId dstTrackId =
             MP4CloneTrack(srcFile, srcTrackId, dstFile, dstHintTrackReferenceTrack);
 
@@ -2009,41 +2114,46 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         bool viaEdits =
             applyEdits && MP4GetTrackNumberOfEdits(srcFile, srcTrackId);
 
-        MP4SampleId sampleId = 0;
-        MP4SampleId numSamples =
-            MP4GetTrackNumberOfSamples(srcFile, srcTrackId);
-
-        MP4Timestamp when = 0;
-        MP4Duration editsDuration =
-            MP4GetTrackEditTotalDuration(srcFile, srcTrackId);
-
-        while (true) {
-            MP4Duration sampleDuration = MP4_INVALID_DURATION;
+        // without edits whole chunks can be copied, along with the
+        // sample tables, if the tracks allow for it
+        if (copySamples && !viaEdits) {
+            try {
+                if (MP4File::CopyTrackChunks(
+                            (MP4File*)srcFile,
+                            srcTrackId,
+                            (MP4File*)dstFile,
+                            dstTrackId)) {
+                    return dstTrackId;
+                }
+            }
+            catch( Exception* x ) {
+                mp4v2::impl::log.errorf(*x);
+                delete x;
+                MP4DeleteTrack(dstFile, dstTrackId);
+                return MP4_INVALID_TRACK_ID;
+            }
+            catch( ... ) {
+                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                MP4DeleteTrack(dstFile, dstTrackId);
+                return MP4_INVALID_TRACK_ID;
+            }
+        }
 
-            if (viaEdits) {
-                sampleId = MP4GetSampleIdFromEditTime(
-                               srcFile,
-                               srcTrackId,
-                               when,
-                               NULL,
-                               &sampleDuration);
+        // one pass over edits and samples, in presentation order
+        MP4SampleCursorHandle cursor =
+            MP4CreateSampleCursor(srcFile, srcTrackId, viaEdits);
 
-                // in theory, this shouldn't happen
-                if (sampleId == MP4_INVALID_SAMPLE_ID) {
-                    MP4DeleteTrack(dstFile, dstTrackId);
-                    return MP4_INVALID_TRACK_ID;
-                }
+        if (cursor == MP4_INVALID_SAMPLE_CURSOR) {
+            MP4DeleteTrack(dstFile, dstTrackId);
+            return MP4_INVALID_TRACK_ID;
+        }
 
-                when += sampleDuration;
+        MP4SampleId sampleId;
+        MP4Duration sampleDuration;
 
-                if (when >= editsDuration) {
-                    break;
-                }
-            } else {
-                sampleId++;
-                if (sampleId > numSamples) {
-                    break;
-                }
+        while (MP4NextSampleCursor(cursor, &sampleId, NULL, &sampleDuration)) {
+            if (!viaEdits) {
+                sampleDuration = MP4_INVALID_DURATION;
             }
 
             bool rc = false;
@@ -2068,14 +2178,37 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             }
 
             if (!rc) {
+                MP4FreeSampleCursor(cursor);
                 MP4DeleteTrack(dstFile, dstTrackId);
                 return MP4_INVALID_TRACK_ID;
             }
         }
 
+        MP4FreeSampleCursor(cursor);
+
         return dstTrackId;
     }
 
+    MP4TrackId MP4CopyTrack(MP4FileHandle srcFile,
+                            MP4TrackId srcTrackId,
+                            MP4FileHandle dstFile,
+                            bool applyEdits,
+                            MP4TrackId dstHintTrackReferenceTrack)
+    {
+        return CopyOrReferenceTrack(srcFile, srcTrackId, dstFile,
+                                    applyEdits, dstHintTrackReferenceTrack, true);
+    }
+
+    MP4TrackId MP4ReferenceTrack(MP4FileHandle srcFile,
+                                 MP4TrackId srcTrackId,
+                                 MP4FileHandle dstFile,
+                                 bool applyEdits,
+                                 MP4TrackId dstHintTrackReferenceTrack)
+    {
+        return CopyOrReferenceTrack(srcFile, srcTrackId, dstFile,
+                                    applyEdits, dstHintTrackReferenceTrack, false);
+    }
+
 // Given a source track in a source file, make an encrypted copy of
 // the track in the destination file, including sample encryption
     MP4TrackId MP4EncAndCopyTrack(MP4FileHandle srcFile,
@@ -2088,8 +2221,6 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                                   MP4TrackId dstHintTrackReferenceTrack
                                  )
     {
-        bool copySamples = true;  // LATER allow false => reference samples
-
         MP4TrackId dstTrackId =
             MP4EncAndCloneTrack(srcFile, srcTrackId,
                                 icPp,
@@ -2102,71 +2233,42 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         bool viaEdits =
             applyEdits && MP4GetTrackNumberOfEdits(srcFile, srcTrackId);
 
-        MP4SampleId sampleId = 0;
-        MP4SampleId numSamples =
-            MP4GetTrackNumberOfSamples(srcFile, srcTrackId);
-
-        MP4Timestamp when = 0;
-        MP4Duration editsDuration =
-            MP4GetTrackEditTotalDuration(srcFile, srcTrackId);
-
-        while (true) {
-            MP4Duration sampleDuration = MP4_INVALID_DURATION;
-
-            if (viaEdits) {
-                sampleId = MP4GetSampleIdFromEditTime(srcFile,
-                                                      srcTrackId,
-                                                      when,
-                                                      NULL,
-                                                      &sampleDuration);
+        // one pass over edits and samples, in presentation order
+        MP4SampleCursorHandle cursor =
+            MP4CreateSampleCursor(srcFile, srcTrackId, viaEdits);
 
-                // in theory, this shouldn't happen
-                if (sampleId == MP4_INVALID_SAMPLE_ID) {
-                    MP4DeleteTrack(dstFile, dstTrackId);
-                    return MP4_INVALID_TRACK_ID;
-                }
+        if (cursor == MP4_INVALID_SAMPLE_CURSOR) {
+            MP4DeleteTrack(dstFile, dstTrackId);
+            return MP4_INVALID_TRACK_ID;
+        }
 
-                when += sampleDuration;
+        MP4SampleId sampleId;
+        MP4Duration sampleDuration;
 
-                if (when >= editsDuration) {
-                    break;
-                }
-            } else {
-                sampleId++;
-                if (sampleId > numSamples) {
-                    break;
-                }
+        while (MP4NextSampleCursor(cursor, &sampleId, NULL, &sampleDuration)) {
+            if (!viaEdits) {
+                sampleDuration = MP4_INVALID_DURATION;
             }
 
-            bool rc = false;
-
-            if (copySamples) {
-                // encrypt and copy
-                rc = MP4EncAndCopySample(srcFile,
-                                         srcTrackId,
-                                         sampleId,
-                                         encfcnp,
-                                         encfcnparam1,
-                                         dstFile,
-                                         dstTrackId,
-                                         sampleDuration);
-
-            } else {
-                // not sure what these are - encrypt?
-                rc = MP4ReferenceSample(srcFile,
-                                        srcTrackId,
-                                        sampleId,
-                                        dstFile,
-                                        dstTrackId,
-                                        sampleDuration);
-            }
+            // samples can't be referenced, they are encrypted on the way
+            bool rc = MP4EncAndCopySample(srcFile,
+                                          srcTrackId,
+                                          sampleId,
+                                          encfcnp,
+                                          encfcnparam1,
+                                          dstFile,
+                                          dstTrackId,
+                                          sampleDuration);
 
             if (!rc) {
+                MP4FreeSampleCursor(cursor);
                 MP4DeleteTrack(dstFile, dstTrackId);
                 return MP4_INVALID_TRACK_ID;
             }
         }
 
+        MP4FreeSampleCursor(cursor);
+
         return dstTrackId;
     }
 
@@ -2180,11 +2282,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2200,11 +2302,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetNumberOfTracks(type, subType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2221,11 +2323,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->FindTrackId(index, type, subType);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -2239,11 +2341,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->FindTrackIndex(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return (uint16_t)-1;
@@ -2259,11 +2361,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackType(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return NULL;
@@ -2276,11 +2378,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackMediaDataName(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return NULL;
@@ -2297,11 +2399,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                         originalFormat, buflen);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2315,11 +2417,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackDuration(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -2333,11 +2435,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackTimeScale(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2352,11 +2454,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2370,11 +2472,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackAudioMpeg4Type(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_MPEG4_INVALID_AUDIO_TYPE;
@@ -2393,11 +2495,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackEsdsObjectTypeId(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_AUDIO_TYPE;
@@ -2411,11 +2513,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackFixedSampleDuration(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -2434,11 +2536,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 }
             }
             catch( Exception* x ) {
-                //mp4v2::impl::log.errorf(*x);  we don't really need to print this.
+                //LogOfFile(hFile).errorf(*x);  we don't really need to print this.
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
             // if we're here, we can't get the bitrate from above -
             // lets calculate it
@@ -2457,11 +2559,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return (uint32_t)bytes;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2478,11 +2580,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *ppConfig = NULL;
@@ -2500,11 +2602,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *ppConfig = NULL;
@@ -2523,11 +2625,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2550,11 +2652,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2597,11 +2699,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2618,11 +2720,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2636,11 +2738,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackNumberOfSamples(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2664,7 +2766,7 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                         "mdia.minf.stbl.stsd.*.width");
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 bool missingProperty = ( x->what.substr( 0, 16 ) == "no such property" );
                 delete x;
                 if ( missingProperty )
@@ -2675,17 +2777,17 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                    }
                    catch ( Exception *xx )
                    {
-                      mp4v2::impl::log.errorf( *xx );
+                      LogOfFile(hFile).errorf( *xx );
                       delete xx;
                    }
                    catch ( ... )
                    {
-                      mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                      LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
                    }
                 }
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2700,7 +2802,7 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                         "mdia.minf.stbl.stsd.*.height");
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 bool missingProperty = ( x->what.substr( 0, 16 ) == "no such property" );
                 delete x;
 
@@ -2713,17 +2815,17 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                    }
                    catch ( Exception *xx )
                    {
-                      mp4v2::impl::log.errorf( *xx );
+                      LogOfFile(hFile).errorf( *xx );
                       delete xx;
                    }
                    catch ( ... )
                    {
-                      mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                      LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
                    }
                 }
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -2737,11 +2839,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackVideoFrameRate(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0.0;
@@ -2755,11 +2857,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackAudioChannels(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return -1;
@@ -2770,22 +2872,22 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         MP4FileHandle hFile, MP4TrackId trackId)
     {
         bool retval = false;
-        MP4LogLevel verb = mp4v2::impl::log.verbosity;
-        mp4v2::impl::log.setVerbosity(MP4_LOG_NONE);
+        MP4LogLevel verb = LogOfFile(hFile).verbosity;
+        LogOfFile(hFile).setVerbosity(MP4_LOG_NONE);
 
         if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
             try {
                 retval = ((MP4File*)hFile)->IsIsmaCrypMediaTrack(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
-        mp4v2::impl::log.setVerbosity(verb);
+        LogOfFile(hFile).setVerbosity(verb);
         return retval;
     }
 
@@ -2801,11 +2903,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->FindTrackAtom(trackId, atomName) != NULL;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2817,11 +2919,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             try {
                 return ((MP4File *)hFile)->GetTrackAtomData(trackId, atomName, outAtomData, outDataSize);
             } catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2846,11 +2948,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2867,11 +2969,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2888,11 +2990,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2909,11 +3011,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *ppValue = NULL;
@@ -2932,11 +3034,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2952,11 +3054,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2972,11 +3074,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -2993,11 +3095,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3032,11 +3134,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *pNumBytes = 0;
@@ -3075,11 +3177,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         *pNumBytes = 0;
@@ -3107,13 +3209,52 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
+            }
+        }
+        return false;
+    }
+
+    bool MP4WriteSampleRef(
+        MP4FileHandle        hFile,
+        MP4TrackId           trackId,
+        const uint8_t*       pBytes,
+        uint32_t             numBytes,
+        MP4SampleReleaseFunc release,
+        void*                userData,
+        MP4Duration          duration,
+        MP4Duration          renderingOffset,
+        bool                 isSyncSample )
+    {
+        if( MP4_IS_VALID_FILE_HANDLE( hFile )) {
+            try {
+                ((MP4File*)hFile)->WriteSampleRef(
+                    trackId,
+                    pBytes,
+                    numBytes,
+                    release,
+                    userData,
+                    duration,
+                    renderingOffset,
+                    isSyncSample );
+                return true;
+            }
+            catch( Exception* x ) {
+                LogOfFile(hFile).errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
+            return false;
         }
+
+        if( release )
+            release( userData, pBytes );
         return false;
     }
 
@@ -3140,11 +3281,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3226,7 +3367,27 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         MP4TrackId dstTrackId,
         MP4Duration dstSampleDuration)
     {
-        // LATER Not yet implemented
+        if( !MP4_IS_VALID_FILE_HANDLE( srcFile ) || !MP4_IS_VALID_FILE_HANDLE( dstFile ))
+            return false;
+
+        try {
+            MP4File::ReferenceSample(
+                (MP4File*)srcFile,
+                srcTrackId,
+                srcSampleId,
+                (MP4File*)dstFile,
+                dstTrackId,
+                dstSampleDuration );
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+        }
+
         return false;
     }
 
@@ -3241,11 +3402,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -3262,11 +3423,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -3282,11 +3443,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackMaxSampleSize(trackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -3304,11 +3465,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, when, wantSyncSample);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_SAMPLE_ID;
@@ -3325,11 +3486,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TIMESTAMP;
@@ -3346,11 +3507,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -3367,11 +3528,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -3390,11 +3551,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3411,11 +3572,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, sampleId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return -1;
@@ -3433,11 +3594,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            duration, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return (uint64_t)MP4_INVALID_DURATION;
@@ -3455,11 +3616,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, timeStamp, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return (uint64_t)MP4_INVALID_TIMESTAMP;
@@ -3477,11 +3638,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, timeStamp, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TIMESTAMP;
@@ -3499,11 +3660,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, duration, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return (uint64_t)MP4_INVALID_DURATION;
@@ -3521,11 +3682,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, duration, timeScale);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -3547,11 +3708,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3575,11 +3736,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3593,11 +3754,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetSessionSdp();
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return NULL;
@@ -3613,11 +3774,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3633,11 +3794,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3652,11 +3813,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetHintTrackSdp(hintTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return NULL;
@@ -3673,11 +3834,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3694,11 +3855,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3714,11 +3875,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        GetHintTrackReferenceTrackId(hintTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TRACK_ID;
@@ -3737,11 +3898,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3756,11 +3917,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetRtpHintNumberOfPackets(hintTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -3777,11 +3938,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        GetRtpPacketBFrame(hintTrackId, packetIndex);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return -1;
@@ -3798,11 +3959,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                        GetRtpPacketTransmitOffset(hintTrackId, packetIndex);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -3827,11 +3988,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3846,11 +4007,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetRtpTimestampStart(hintTrackId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TIMESTAMP;
@@ -3868,11 +4029,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3898,11 +4059,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3921,11 +4082,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3944,11 +4105,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3968,11 +4129,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -3988,11 +4149,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4011,11 +4172,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf( "%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf( "%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4180,11 +4341,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return newEditId;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_EDIT_ID;
@@ -4201,11 +4362,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4220,11 +4381,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackNumberOfEdits(trackId);
             }
             catch( Exception* x ) {
-                //mp4v2::impl::log.errorf(*x);
+                //LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return 0;
@@ -4241,11 +4402,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, editId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_TIMESTAMP;
@@ -4262,11 +4423,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, editId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -4285,11 +4446,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4305,11 +4466,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackEditDuration(trackId, editId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_DURATION;
@@ -4327,11 +4488,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4347,11 +4508,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return ((MP4File*)hFile)->GetTrackEditDwell(trackId, editId);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return -1;
@@ -4369,11 +4530,11 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                 return true;
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return false;
@@ -4425,16 +4586,74 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
                            trackId, when, pStartTime, pDuration);
             }
             catch( Exception* x ) {
-                mp4v2::impl::log.errorf(*x);
+                LogOfFile(hFile).errorf(*x);
                 delete x;
             }
             catch( ... ) {
-                mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             }
         }
         return MP4_INVALID_SAMPLE_ID;
     }
 
+    MP4SampleCursorHandle MP4CreateSampleCursor(
+        MP4FileHandle hFile,
+        MP4TrackId    trackId,
+        bool          applyEdits )
+    {
+        if (MP4_IS_VALID_FILE_HANDLE(hFile)) {
+            try {
+                return (MP4SampleCursorHandle)((MP4File*)hFile)->CreateSampleCursor(
+                           trackId, applyEdits);
+            }
+            catch( Exception* x ) {
+                LogOfFile(hFile).errorf(*x);
+                delete x;
+            }
+            catch( ... ) {
+                LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
+            }
+        }
+        return MP4_INVALID_SAMPLE_CURSOR;
+    }
+
+    bool MP4NextSampleCursor(
+        MP4SampleCursorHandle cursor,
+        MP4SampleId*          pSampleId,
+        MP4Timestamp*         pStartTime,
+        MP4Duration*          pDuration )
+    {
+        if (cursor == MP4_INVALID_SAMPLE_CURSOR || pSampleId == NULL)
+            return false;
+
+        try {
+            MP4Timestamp startTime;
+            MP4Duration duration;
+            if (!((MP4SampleCursor*)cursor)->Next(*pSampleId, startTime, duration))
+                return false;
+
+            if (pStartTime)
+                *pStartTime = startTime;
+            if (pDuration)
+                *pDuration = duration;
+            return true;
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf(*x);
+            delete x;
+        }
+        catch( ... ) {
+            mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        }
+        return false;
+    }
+
+    void MP4FreeSampleCursor(
+        MP4SampleCursorHandle cursor )
+    {
+        delete (MP4SampleCursor*)cursor;
+    }
+
     /* Utlities */
 
     char* MP4BinaryToBase16(
@@ -4496,12 +4715,12 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             avc1 = track->GetTrakAtom().FindChildAtom("mdia.minf.stbl.stsd.avc1");
         }
         catch( Exception* x ) {
-            mp4v2::impl::log.errorf(*x);
+            LogOfFile(hFile).errorf(*x);
             delete x;
             return false;
         }
         catch( ... ) {
-            mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+            LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
             return false;
         }
 
@@ -4511,15 +4730,15 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
             ipod_uuid = new IPodUUIDAtom(*(MP4File*)hFile);
         }
         catch( std::bad_alloc ) {
-            mp4v2::impl::log.errorf("%s: unable to allocate IPodUUIDAtom", __FUNCTION__);
+            LogOfFile(hFile).errorf("%s: unable to allocate IPodUUIDAtom", __FUNCTION__);
         }
         catch( Exception* x ) {
-            mp4v2::impl::log.errorf(*x);
+            LogOfFile(hFile).errorf(*x);
             delete x;
             return false;
         }
         catch( ... ) {
-            mp4v2::impl::log.errorf("%s: unknown exception constructing IPodUUIDAtom", __FUNCTION__ );
+            LogOfFile(hFile).errorf("%s: unknown exception constructing IPodUUIDAtom", __FUNCTION__ );
             return false;
         }
 
@@ -4533,14 +4752,14 @@ MP4FileHandle MP4ReadProvider( const char* fileName, const MP4FileProvider* file
         catch( Exception* x ) {
             delete ipod_uuid;
             ipod_uuid = NULL;
-            mp4v2::impl::log.errorf(*x);
+            LogOfFile(hFile).errorf(*x);
             delete x;
             return false;
         }
         catch( ... ) {
             delete ipod_uuid;
             ipod_uuid = NULL;
-            mp4v2::impl::log.errorf("%s: unknown exception adding IPodUUIDAtom", __FUNCTION__ );
+            LogOfFile(hFile).errorf("%s: unknown exception adding IPodUUIDAtom", __FUNCTION__ );
             return false;
         }
 
@@ -4561,11 +4780,11 @@ bool MP4GetTrackLanguage(
         return ((MP4File*)hFile)->GetTrackLanguage( trackId, code );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -4585,11 +4804,11 @@ bool MP4SetTrackLanguage(
         return ((MP4File*)hFile)->SetTrackLanguage( trackId, code );
     }   
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -4609,11 +4828,11 @@ bool MP4GetTrackName(
         return ((MP4File*)hFile)->GetTrackName( trackId, name );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -4639,11 +4858,11 @@ bool MP4SetTrackName(
         return ((MP4File*)hFile)->SetTrackName( trackId, code );
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -4667,11 +4886,11 @@ bool MP4GetTrackDurationPerChunk(
         return true;
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -4692,11 +4911,11 @@ bool MP4SetTrackDurationPerChunk(
         return true;
     }
     catch( Exception* x ) {
-        mp4v2::impl::log.errorf(*x);
+        LogOfFile(hFile).errorf(*x);
         delete x;
     }
     catch( ... ) {
-        mp4v2::impl::log.errorf("%s: failed", __FUNCTION__ );
+        LogOfFile(hFile).errorf("%s: failed", __FUNCTION__ );
     }
 
     return false;
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "src/impl.h"
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+
+MP4AsyncWriter::MP4AsyncWriter( File& file, uint64_t maxPending )
+    : m_file       ( file )
+    , m_maxPending ( maxPending )
+    , m_pending    ( 0 )
+    , m_busy       ( false )
+    , m_stop       ( false )
+    , m_failed     ( false )
+    , m_errno      ( 0 )
+{
+    m_thread = std::thread( &MP4AsyncWriter::Run, this );
+}
+
+MP4AsyncWriter::~MP4AsyncWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_wakeWriter.notify_one();
+
+    // the writer works off the queue before it honors m_stop
+    m_thread.join();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MP4AsyncWriter::Submit( Job* job )
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    // always accept at least one job, however large
+    while( !m_failed && m_pending && m_pending + job->size > m_maxPending )
+        m_wakeCaller.wait( lock );
+
+    if( m_failed ) {
+        lock.unlock();
+        Dispose( job );
+        Rethrow();
+    }
+
+    m_jobs.push_back( job );
+    m_pending += job->size;
+    lock.unlock();
+
+    m_wakeWriter.notify_one();
+}
+
+void MP4AsyncWriter::Drain()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+
+    while( !m_jobs.empty() || m_busy )
+        m_wakeCaller.wait( lock );
+
+    if( m_failed ) {
+        lock.unlock();
+        Rethrow();
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MP4AsyncWriter::Run()
+{
+    for( ;; ) {
+        Job* job;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock( m_mutex );
+            while( !m_stop && m_jobs.empty() )
+                m_wakeWriter.wait( lock );
+            if( m_jobs.empty() )
+                return;
+
+            job = m_jobs.front();
+            m_jobs.pop_front();
+            m_busy = true;
+            failed = m_failed;
+        }
+
+        string error;
+        int    errcode = 0;
+        if( !failed ) {
+            File::Size nout = 0;
+            if( m_file.seek( job->offset )) {
+                error = "seek failed";
+                errcode = sys::getLastError();
+            }
+            else if( m_file.writev( &job->segments[0], (uint32_t)job->segments.size(), nout )) {
+                error = "write failed";
+                errcode = sys::getLastError();
+            }
+            else if( (uint64_t)nout != job->size ) {
+                error = "not all bytes written";
+            }
+        }
+
+        const uint64_t size = job->size;
+        Dispose( job );
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if( !error.empty() && !m_failed ) {
+                m_failed = true;
+                m_error  = error;
+                m_errno  = errcode;
+            }
+            m_pending -= size;
+            m_busy = false;
+        }
+        m_wakeCaller.notify_all();
+    }
+}
+
+void MP4AsyncWriter::Rethrow()
+{
+    if( m_errno )
+        throw new PlatformException( m_error, m_errno, __FILE__, __LINE__, __FUNCTION__ );
+    throw new Exception( m_error, __FILE__, __LINE__, __FUNCTION__ );
+}
+
+void MP4AsyncWriter::Dispose( Job* job )
+{
+    const vector<Release>::size_type max = job->releases.size();
+    for( vector<Release>::size_type i = 0; i < max; i++ )
+        job->releases[i].func( job->releases[i].userData, job->releases[i].pBytes );
+
+    MP4Free( job->pBuffer );
+    delete job;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MP4V2_IMPL_MP4ASYNCWRITER_H
+#define MP4V2_IMPL_MP4ASYNCWRITER_H
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Write-behind queue for chunk data.
+///
+/// MP4Track hands over complete chunks and the writer stores them on a
+/// background thread, in submission order, at the offsets assigned by the
+/// caller. All sample table bookkeeping stays on the caller's thread; the
+/// owning MP4File must not touch the file itself until Drain() returned.
+///
+/// The amount of data in flight is bounded, Submit() blocks while the
+/// limit is exceeded. A failed write is reported by the next Submit() or
+/// Drain() on the caller's thread; later jobs are then only disposed of.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+class MP4AsyncWriter
+{
+public:
+    //! default limit for bytes queued but not yet written
+    static const uint64_t DEFAULT_MAX_PENDING = 64 * 1024 * 1024;
+
+    //! sample buffer to hand back once written
+    struct Release {
+        MP4SampleReleaseFunc func;
+        void*                userData;
+        const uint8_t*       pBytes;
+    };
+
+    //! one chunk, owned by the writer once submitted
+    struct Job {
+        uint64_t              offset;
+        uint64_t              size;
+        uint8_t*              pBuffer;  //!< MP4Malloc'd, freed after writing
+        vector<File::Segment> segments;
+        vector<Release>       releases;
+    };
+
+public:
+    MP4AsyncWriter( File& file, uint64_t maxPending = DEFAULT_MAX_PENDING );
+    ~MP4AsyncWriter();
+
+    void Submit( Job* job );
+    void Drain();
+
+private:
+    void Run();
+    void Rethrow();
+
+    static void Dispose( Job* job );
+
+private:
+    File&                   m_file;
+    const uint64_t          m_maxPending;
+
+    std::mutex              m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_wakeCaller;
+    list<Job*>              m_jobs;
+    uint64_t                m_pending;  // bytes queued or being written
+    bool                    m_busy;     // a job is being written
+    bool                    m_stop;
+
+    bool                    m_failed;
+    string                  m_error;
+    int                     m_errno;
+
+    std::thread             m_thread;
+
+private:
+    MP4AsyncWriter();
+    MP4AsyncWriter( const MP4AsyncWriter &src );
+    MP4AsyncWriter &operator= ( const MP4AsyncWriter &src );
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
+
+#endif // MP4V2_IMPL_MP4ASYNCWRITER_H
@@ -56,6 +56,7 @@ MP4Atom::MP4Atom(MP4File& file, const char* type)
     m_size = 0;
     m_pParentAtom = NULL;
     m_depth = 0xFF;
+    m_modified = true;
 }
 
 MP4Atom::~MP4Atom()
@@ -115,8 +116,9 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
     uint8_t extendedType[16];
 
     uint64_t pos = file.GetPosition();
+    file.GetStats().atomsParsed++;
 
-    log.verbose1f("\"%s\": pos = 0x%" PRIx64, file.GetFilename().c_str(), pos);
+    file.GetLog().verbose1f("\"%s\": pos = 0x%" PRIx64, file.GetFilename().c_str(), pos);
 
     uint64_t dataSize = file.ReadUInt32();
 
@@ -124,6 +126,10 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
     file.ReadBytes((uint8_t*)&type[0], 4);
     type[4] = '\0';
 
+    // one span per top-level atom, children are too many to be of use
+    TraceSpan span("parse", type, (MP4FileHandle)&file,
+                   pParentAtom && !pParentAtom->GetParentAtom());
+
     // extended size
     const bool largesizeMode = (dataSize == 1);
     if (dataSize == 1) {
@@ -147,26 +153,26 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
     if ( dataSize < hdrSize ) {
        ostringstream oss;
        oss << "Invalid atom size in '" << type << "' atom, dataSize = " << dataSize << " cannot be less than hdrSize = " << static_cast<unsigned>( hdrSize );
-       log.errorf( "%s: \"%s\": %s", __FUNCTION__, file.GetFilename().c_str(), oss.str().c_str() );
+       file.GetLog().errorf( "%s: \"%s\": %s", __FUNCTION__, file.GetFilename().c_str(), oss.str().c_str() );
        throw new Exception( oss.str().c_str(), __FILE__, __LINE__, __FUNCTION__ );
     }
     dataSize -= hdrSize;
 
-    log.verbose1f("\"%s\": type = \"%s\" data-size = %" PRIu64 " (0x%" PRIx64 ") hdr %u",
-                  file.GetFilename().c_str(), type, dataSize, dataSize, hdrSize);
+    file.GetLog().verbose1f("\"%s\": type = \"%s\" data-size = %" PRIu64 " (0x%" PRIx64 ") hdr %u",
+                            file.GetFilename().c_str(), type, dataSize, dataSize, hdrSize);
 
     if (pos + hdrSize + dataSize > pParentAtom->GetEnd()) {
-        log.errorf("%s: \"%s\": invalid atom size, extends outside parent atom - skipping to end of \"%s\" \"%s\" %" PRIu64 " vs %" PRIu64,
-                   __FUNCTION__, file.GetFilename().c_str(), pParentAtom->GetType(), type,
-                   pos + hdrSize + dataSize,
-                   pParentAtom->GetEnd());
-        log.verbose1f("\"%s\": parent %s (%" PRIu64 ") pos %" PRIu64 " hdr %d data %" PRIu64 " sum %" PRIu64,
-                      file.GetFilename().c_str(), pParentAtom->GetType(),
-                      pParentAtom->GetEnd(),
-                      pos,
-                      hdrSize,
-                      dataSize,
-                      pos + hdrSize + dataSize);
+        file.GetLog().errorf("%s: \"%s\": invalid atom size, extends outside parent atom - skipping to end of \"%s\" \"%s\" %" PRIu64 " vs %" PRIu64,
+                             __FUNCTION__, file.GetFilename().c_str(), pParentAtom->GetType(), type,
+                             pos + hdrSize + dataSize,
+                             pParentAtom->GetEnd());
+        file.GetLog().verbose1f("\"%s\": parent %s (%" PRIu64 ") pos %" PRIu64 " hdr %d data %" PRIu64 " sum %" PRIu64,
+                                file.GetFilename().c_str(), pParentAtom->GetType(),
+                                pParentAtom->GetEnd(),
+                                pos,
+                                hdrSize,
+                                dataSize,
+                                pos + hdrSize + dataSize);
 
         // skip to end of atom
         dataSize = pParentAtom->GetEnd() - pos - hdrSize;
@@ -183,11 +189,11 @@ MP4Atom* MP4Atom::ReadAtom(MP4File& file, MP4Atom* pParentAtom)
     }
     if (pAtom->IsUnknownType()) {
         if (!IsReasonableType(pAtom->GetType())) {
-            log.warningf("%s: \"%s\": atom type %s is suspect", __FUNCTION__, file.GetFilename().c_str(),
-                         pAtom->GetType());
+            file.GetLog().warningf("%s: \"%s\": atom type %s is suspect", __FUNCTION__, file.GetFilename().c_str(),
+                                   pAtom->GetType());
         } else {
-            log.verbose1f("\"%s\": Info: atom type %s is unknown", file.GetFilename().c_str(),
-                          pAtom->GetType());
+            file.GetLog().verbose1f("\"%s\": Info: atom type %s is unknown", file.GetFilename().c_str(),
+                                    pAtom->GetType());
         }
 
         if (dataSize > 0) {
@@ -231,8 +237,8 @@ bool MP4Atom::IsReasonableType(const char* type)
 void MP4Atom::Read()
 {
     if (ATOMID(m_type) != 0 && m_size > 1000000) {
-        log.verbose1f("%s: \"%s\": %s atom size %" PRIu64 " is suspect", __FUNCTION__,
-                     m_File.GetFilename().c_str(), m_type, m_size);
+        m_File.GetLog().verbose1f("%s: \"%s\": %s atom size %" PRIu64 " is suspect", __FUNCTION__,
+                                 m_File.GetFilename().c_str(), m_type, m_size);
     }
 
     // skip parsing of certain atoms
@@ -254,8 +260,8 @@ void MP4Atom::Read()
 void MP4Atom::Skip()
 {
     if (m_File.GetPosition() != m_end) {
-        log.verbose1f("\"%s\": Skip: %" PRIu64 " bytes",
-                      m_File.GetFilename().c_str(), m_end - m_File.GetPosition());
+        m_File.GetLog().verbose1f("\"%s\": Skip: %" PRIu64 " bytes",
+                                  m_File.GetFilename().c_str(), m_end - m_File.GetPosition());
     }
     m_File.SetPosition(m_end);
 }
@@ -267,8 +273,8 @@ MP4Atom* MP4Atom::FindAtom(const char* name)
     }
 
     if (!IsRootAtom()) {
-        log.verbose1f("\"%s\": FindAtom: matched %s", 
-                      GetFile().GetFilename().c_str(), name);
+        m_File.GetLog().verbose1f("\"%s\": FindAtom: matched %s", 
+                                  GetFile().GetFilename().c_str(), name);
 
         name = MP4NameAfterFirst(name);
 
@@ -290,8 +296,8 @@ bool MP4Atom::FindProperty(const char *name,
     }
 
     if (!IsRootAtom()) {
-        log.verbose1f("\"%s\": FindProperty: matched %s", 
-                      GetFile().GetFilename().c_str(), name);
+        m_File.GetLog().verbose1f("\"%s\": FindProperty: matched %s", 
+                                  GetFile().GetFilename().c_str(), name);
 
         name = MP4NameAfterFirst(name);
 
@@ -375,8 +381,8 @@ bool MP4Atom::FindContainedProperty(const char *name,
         }
     }
 
-    log.verbose1f("\"%s\": FindProperty: no match for %s", 
-                  GetFile().GetFilename().c_str(), name);
+    m_File.GetLog().verbose1f("\"%s\": FindProperty: no match for %s", 
+                              GetFile().GetFilename().c_str(), name);
     return false;
 }
 
@@ -390,9 +396,9 @@ void MP4Atom::ReadProperties(uint32_t startIndex, uint32_t count)
         m_pProperties[i]->Read(m_File);
 
         if (m_File.GetPosition() > m_end) {
-            log.verbose1f("ReadProperties: insufficient data for property: %s pos 0x%" PRIx64 " atom end 0x%" PRIx64,
-                          m_pProperties[i]->GetName(),
-                          m_File.GetPosition(), m_end);
+            m_File.GetLog().verbose1f("ReadProperties: insufficient data for property: %s pos 0x%" PRIx64 " atom end 0x%" PRIx64,
+                                      m_pProperties[i]->GetName(),
+                                      m_File.GetPosition(), m_end);
 
             ostringstream oss;
             const char* propName = nullptr;
@@ -404,7 +410,7 @@ void MP4Atom::ReadProperties(uint32_t startIndex, uint32_t count)
             else
                oss << "atom '" << GetType() << "' is too small; overrun reading property";
 
-            log.verbose1f( "%s", oss.str().c_str() );
+            m_File.GetLog().verbose1f( "%s", oss.str().c_str() );
             return;
         }
 
@@ -412,7 +418,7 @@ void MP4Atom::ReadProperties(uint32_t startIndex, uint32_t count)
             (m_pProperties[i]->GetType() == TableProperty) ?
             MP4_LOG_VERBOSE2 : MP4_LOG_VERBOSE1;
 
-        if (log.verbosity >= thisVerbosity) {
+        if (m_File.GetLog().verbosity >= thisVerbosity) {
             // log.printf(thisVerbosity,"Read: ");
             m_pProperties[i]->Dump(0, true);
         }
@@ -423,7 +429,7 @@ void MP4Atom::ReadChildAtoms()
 {
     bool this_is_udta = ATOMID(m_type) == ATOMID("udta");
 
-    log.verbose1f("\"%s\": of %s", m_File.GetFilename().c_str(), m_type[0] ? m_type : "root");
+    m_File.GetLog().verbose1f("\"%s\": of %s", m_File.GetFilename().c_str(), m_type[0] ? m_type : "root");
     for (uint64_t position = m_File.GetPosition();
             position < m_end;
             position = m_File.GetPosition()) {
@@ -435,14 +441,14 @@ void MP4Atom::ReadChildAtoms()
                     m_end - position == sizeof(uint32_t)) {
                 uint32_t mbz = m_File.ReadUInt32();
                 if (mbz != 0) {
-                    log.warningf("%s: \"%s\": In udta atom, end value is not zero %x", __FUNCTION__, 
-                                 m_File.GetFilename().c_str(), mbz);
+                    m_File.GetLog().warningf("%s: \"%s\": In udta atom, end value is not zero %x", __FUNCTION__, 
+                                             m_File.GetFilename().c_str(), mbz);
                 }
                 continue;
             }
             // otherwise, output a warning, but don't care
-            log.warningf("%s: \"%s\": In %s atom, extra %" PRId64 " bytes at end of atom", __FUNCTION__, 
-                         m_File.GetFilename().c_str(), m_type, (m_end - position));
+            m_File.GetLog().warningf("%s: \"%s\": In %s atom, extra %" PRId64 " bytes at end of atom", __FUNCTION__, 
+                                     m_File.GetFilename().c_str(), m_type, (m_end - position));
             for (uint64_t ix = 0; ix < m_end - position; ix++) {
                 (void)m_File.ReadUInt8();
             }
@@ -457,8 +463,8 @@ void MP4Atom::ReadChildAtoms()
         // if child atom is of known type
         // but not expected here print warning
         if (pChildAtomInfo == NULL && !pChildAtom->IsUnknownType()) {
-            log.verbose1f("%s: \"%s\": In atom %s unexpected child atom %s", __FUNCTION__,
-                          m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
+            m_File.GetLog().verbose1f("%s: \"%s\": In atom %s unexpected child atom %s", __FUNCTION__,
+                                      m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
         }
 
         // if child atoms should have just one instance
@@ -467,8 +473,8 @@ void MP4Atom::ReadChildAtoms()
             pChildAtomInfo->m_count++;
 
             if (pChildAtomInfo->m_onlyOne && pChildAtomInfo->m_count > 1) {
-                log.warningf("%s: \"%s\": In atom %s multiple child atoms %s", __FUNCTION__,
-                             m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
+                m_File.GetLog().warningf("%s: \"%s\": In atom %s multiple child atoms %s", __FUNCTION__,
+                                         m_File.GetFilename().c_str(), GetType(), pChildAtom->GetType());
             }
         }
 
@@ -479,12 +485,12 @@ void MP4Atom::ReadChildAtoms()
     for (uint32_t i = 0; i < numAtomInfo; i++) {
         if (m_pChildAtomInfos[i]->m_mandatory
                 && m_pChildAtomInfos[i]->m_count == 0) {
-            log.warningf("%s: \"%s\": In atom %s missing child atom %s", __FUNCTION__,
-                         m_File.GetFilename().c_str(), GetType(), m_pChildAtomInfos[i]->m_name);
+            m_File.GetLog().warningf("%s: \"%s\": In atom %s missing child atom %s", __FUNCTION__,
+                                     m_File.GetFilename().c_str(), GetType(), m_pChildAtomInfos[i]->m_name);
         }
     }
 
-    log.verbose1f("\"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
+    m_File.GetLog().verbose1f("\"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
 }
 
 MP4AtomInfo* MP4Atom::FindAtomInfo(const char* name)
@@ -523,6 +529,27 @@ void MP4Atom::Rewrite()
     m_File.SetPosition(fPos);
 }
 
+bool MP4Atom::IsSubtreeModified()
+{
+    if (m_modified) {
+        return true;
+    }
+    for (uint32_t i = 0; i < m_pChildAtoms.Size(); i++) {
+        if (m_pChildAtoms[i]->IsSubtreeModified()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MP4Atom::ClearModified()
+{
+    m_modified = false;
+    for (uint32_t i = 0; i < m_pChildAtoms.Size(); i++) {
+        m_pChildAtoms[i]->ClearModified();
+    }
+}
+
 void MP4Atom::BeginWrite(bool use64)
 {
     m_start = m_File.GetPosition();
@@ -546,8 +573,8 @@ void MP4Atom::FinishWrite(bool use64)
     m_end = m_File.GetPosition();
     m_size = (m_end - m_start);
 
-    log.verbose1f("end: type %s %" PRIu64 " %" PRIu64 " size %" PRIu64,
-                       m_type,m_start, m_end, m_size);
+    m_File.GetLog().verbose1f("end: type %s %" PRIu64 " %" PRIu64 " size %" PRIu64,
+                                   m_type,m_start, m_end, m_size);
     //use64 = m_File.Use64Bits();
     if (use64) {
         m_File.SetPosition(m_start + 8);
@@ -570,7 +597,7 @@ void MP4Atom::WriteProperties(uint32_t startIndex, uint32_t count)
 {
     uint32_t numProperties = min(count, m_pProperties.Size() - startIndex);
 
-    log.verbose1f("Write: \"%s\": type %s", m_File.GetFilename().c_str(), m_type);
+    m_File.GetLog().verbose1f("Write: \"%s\": type %s", m_File.GetFilename().c_str(), m_type);
 
     for (uint32_t i = startIndex; i < startIndex + numProperties; i++) {
         m_pProperties[i]->Write(m_File);
@@ -579,8 +606,8 @@ void MP4Atom::WriteProperties(uint32_t startIndex, uint32_t count)
             (m_pProperties[i]->GetType() == TableProperty) ?
             MP4_LOG_VERBOSE2 : MP4_LOG_VERBOSE1;
 
-        if (log.verbosity >= thisVerbosity) {
-            log.printf(thisVerbosity,"Write: ");
+        if (m_File.GetLog().verbosity >= thisVerbosity) {
+            m_File.GetLog().printf(thisVerbosity,"Write: ");
             m_pProperties[i]->Dump(0, false);
         }
     }
@@ -593,7 +620,7 @@ void MP4Atom::WriteChildAtoms()
         m_pChildAtoms[i]->Write();
     }
 
-    log.verbose1f("Write: \"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
+    m_File.GetLog().verbose1f("Write: \"%s\": finished %s", m_File.GetFilename().c_str(), m_type);
 }
 
 void MP4Atom::AddProperty(MP4Property* pProperty)
@@ -671,9 +698,9 @@ void MP4Atom::Dump(uint8_t indent, bool dumpImplicits)
         if( can.length() )
             can.resize( can.length() - 1 );
 
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": type %s (%s)",
-                 GetFile().GetFilename().c_str(),
-                 m_type, can.c_str() );
+        m_File.GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": type %s (%s)",
+                             GetFile().GetFilename().c_str(),
+                             m_type, can.c_str() );
     }
 
     uint32_t i;
@@ -685,9 +712,9 @@ void MP4Atom::Dump(uint8_t indent, bool dumpImplicits)
 
         /* skip details of tables unless we're told to be verbose */
         if (m_pProperties[i]->GetType() == TableProperty
-                && (log.verbosity < MP4_LOG_VERBOSE2)) {
-            log.dump(indent + 1, MP4_LOG_VERBOSE1, "\"%s\": <table entries suppressed>",
-                     GetFile().GetFilename().c_str() );
+                && (m_File.GetLog().verbosity < MP4_LOG_VERBOSE2)) {
+            m_File.GetLog().dump(indent + 1, MP4_LOG_VERBOSE1, "\"%s\": <table entries suppressed>",
+                                 GetFile().GetFilename().c_str() );
             continue;
         }
 
@@ -911,6 +938,8 @@ MP4Atom::factory( MP4File &file, MP4Atom* parent, const char* type )
             break;
 
         case 'i':
+            if( ATOMID(type) == ATOMID("ilst") )
+                return new MP4ItemListAtom(file);
             if( ATOMID(type) == ATOMID("ipir") )
                 return new MP4TrefTypeAtom( file, type );
             if( ATOMID(type) == ATOMID("ima4") )
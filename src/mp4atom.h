@@ -136,25 +136,40 @@ public:
         m_pParentAtom = pParentAtom;
     }
 
-    void AddChildAtom(MP4Atom* pChildAtom) {
+    virtual void AddChildAtom(MP4Atom* pChildAtom) {
         pChildAtom->SetParentAtom(this);
         m_pChildAtoms.Add(pChildAtom);
+        m_modified = true;
     }
 
-    void InsertChildAtom(MP4Atom* pChildAtom, uint32_t index) {
+    virtual void InsertChildAtom(MP4Atom* pChildAtom, uint32_t index) {
         pChildAtom->SetParentAtom(this);
         m_pChildAtoms.Insert(pChildAtom, index);
+        m_modified = true;
     }
 
-    void DeleteChildAtom(MP4Atom* pChildAtom) {
+    virtual void DeleteChildAtom(MP4Atom* pChildAtom) {
         for (MP4ArrayIndex i = 0; i < m_pChildAtoms.Size(); i++) {
             if (m_pChildAtoms[i] == pChildAtom) {
                 m_pChildAtoms.Delete(i);
+                m_modified = true;
                 return;
             }
         }
     }
 
+    // whether the atom may differ from its bytes in the file; atoms not
+    // read from the file always do, reading sets it as a side effect and
+    // only ClearModified() resets it
+    bool IsModified() {
+        return m_modified;
+    }
+    void SetModified() {
+        m_modified = true;
+    }
+    bool IsSubtreeModified();
+    void ClearModified();
+
     uint32_t GetNumberOfChildAtoms() {
         return m_pChildAtoms.Size();
     }
@@ -237,6 +252,7 @@ protected:
 
     MP4Atom*    m_pParentAtom;
     uint8_t m_depth;
+    bool        m_modified;
 
     MP4PropertyArray    m_pProperties;
     MP4AtomInfoArray    m_pChildAtomInfos;
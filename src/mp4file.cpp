@@ -60,6 +60,28 @@ void MP4File::Init()
     m_memoryBufferSize = 0;
     m_memoryBufferPosition = 0;
 
+    m_measureMode = false;
+    m_measurePosition = 0;
+    m_measureSize = 0;
+
+    m_asyncWriter = NULL;
+    m_asyncPending = false;
+    m_asyncPosition = 0;
+
+    m_modifyInPlace = false;
+    m_moovSlotStart = 0;
+    m_moovSlotSize = 0;
+    m_moovPadding = MP4_DEFAULT_MOOV_PADDING;
+    m_frontSlotStart = 0;
+    m_frontSlotSize = 0;
+    m_deferArtwork = false;
+
+    m_pLog = NULL;
+
+    memset( &m_stats, 0, sizeof( m_stats ));
+    m_statsTiming = false;
+    m_statsTimingEnabled = false;
+
     m_numReadBits = 0;
     m_bufReadBits = 0;
     m_numWriteBits = 0;
@@ -72,12 +94,15 @@ void MP4File::Init()
 
 MP4File::~MP4File()
 {
+    // lets the writer thread finish the queue, errors are lost at this point
+    delete m_asyncWriter;
     delete m_pRootAtom;
     for( uint32_t i = 0; i < m_pTracks.Size(); i++ )
         delete m_pTracks[i];
     MP4Free( m_memoryBuffer ); // just in case
     CHECK_AND_FREE( m_editName );
     delete m_file;
+    delete m_pLog;
 }
 
 const std::string &
@@ -92,9 +117,38 @@ MP4File::GetFilename() const
     return m_file->name;
 }
 
+void MP4File::SetLogSink( MP4LogSink sink, void* userData, MP4LogLevel verbosity )
+{
+    if( !sink ) {
+        delete m_pLog;
+        m_pLog = NULL;
+        return;
+    }
+
+    if( !m_pLog )
+        m_pLog = new Log( verbosity );
+
+    m_pLog->setVerbosity( verbosity );
+    m_pLog->setSink( sink, userData, (MP4FileHandle)this );
+}
+
+void MP4File::StatsTimer::Start( uint64_t& total )
+{
+    m_file.m_statsTiming = true;
+    m_total = &total;
+    m_start = time::getMonotonicMicroseconds();
+}
+
+void MP4File::StatsTimer::Stop()
+{
+    *m_total += time::getMonotonicMicroseconds() - m_start;
+    m_file.m_statsTiming = false;
+}
+
 void MP4File::Read( const char* name, const MP4FileProvider* provider )
 {
     Open( name, File::MODE_READ, provider );
+    m_deferArtwork = true;
     ReadFromFile();
     CacheProperties();
 }
@@ -131,6 +185,13 @@ void MP4File::Create( const char* fileName,
     if (add_iods != 0) {
         (void)AddChildAtom("moov", "iods");
     }
+
+    if( (m_createFlags & MP4_CREATE_DIRECT_IO) && m_file->enableDirect() )
+        GetLog().warningf( "%s: \"%s\": direct I/O not available, using buffered writes",
+                           __FUNCTION__, GetFilename().c_str() );
+
+    if( m_createFlags & MP4_CREATE_ASYNC_WRITE )
+        StartAsyncWrite();
 }
 
 bool MP4File::Use64Bits (const char *atomName)
@@ -161,7 +222,7 @@ void MP4File::Check64BitStatus (const char *atomName)
 }
 
 
-bool MP4File::Modify( const char* fileName )
+bool MP4File::Modify( const char* fileName, uint32_t flags )
 {
     Open( fileName, File::MODE_MODIFY, NULL );
     ReadFromFile();
@@ -172,10 +233,15 @@ bool MP4File::Modify( const char* fileName )
 
     if (pMoovAtom == NULL) {
         // there isn't one, odd but we can still proceed
-        log.warningf("%s: \"%s\": no moov atom, can't modify",
-                     __FUNCTION__, GetFilename().c_str());
+        GetLog().warningf("%s: \"%s\": no moov atom, can't modify",
+                          __FUNCTION__, GetFilename().c_str());
         return false;
         //pMoovAtom = AddChildAtom(m_pRootAtom, "moov");
+    } else if (flags & MP4_MODIFY_IN_PLACE) {
+        // moov stays where it is until FinishWrite() knows its new size
+        BeginModifyInPlace(pMoovAtom);
+        CacheProperties();
+        return true;
     } else {
         numAtoms = m_pRootAtom->GetNumberOfChildAtoms();
 
@@ -254,6 +320,8 @@ bool MP4File::Modify( const char* fileName )
 
 void MP4File::Optimize( const char* srcFileName, const char* dstFileName )
 {
+    TraceSpan span( "optimize", "Optimize", (MP4FileHandle)this );
+
     File* src = NULL;
     File* dst = NULL;
 
@@ -293,11 +361,17 @@ void MP4File::Optimize( const char* srcFileName, const char* dstFileName )
 
         SetIntegerProperty( "moov.mvhd.modificationTime", MP4GetAbsTimestamp() );
 
+        // decide the chunk order and final chunk offsets up front
+        // so that moov only needs to be written once
+        vector<MdatChunk> chunks;
+        PlanMdat( chunks );
+        LayoutMdat( chunks );
+
         // writing meta info in the optimal order
         ((MP4RootAtom*)m_pRootAtom)->BeginOptimalWrite();
 
         // write data in optimal order
-        RewriteMdat( *src, *dst );
+        RewriteMdat( *src, *dst, chunks );
 
         // finish writing
         ((MP4RootAtom*)m_pRootAtom)->FinishOptimalWrite();
@@ -324,7 +398,7 @@ void MP4File::Optimize( const char* srcFileName, const char* dstFileName )
         Rename( dname.c_str(), srcFileName );
 }
 
-void MP4File::RewriteMdat( File& src, File& dst )
+void MP4File::PlanMdat( vector<MdatChunk>& chunks )
 {
     uint32_t numTracks = m_pTracks.Size();
 
@@ -332,11 +406,15 @@ void MP4File::RewriteMdat( File& src, File& dst )
     MP4ChunkId* maxChunkIds = new MP4ChunkId[numTracks];
     MP4Timestamp* nextChunkTimes = new MP4Timestamp[numTracks];
 
+    vector<MdatChunk>::size_type numChunks = 0;
     for( uint32_t i = 0; i < numTracks; i++ ) {
         chunkIds[i] = 1;
-        maxChunkIds[i] = m_pTracks[i]->GetNumberOfChunks();
+        // chunks in another file are left alone
+        maxChunkIds[i] = m_pTracks[i]->HasExternalSamples() ? 0 : m_pTracks[i]->GetNumberOfChunks();
         nextChunkTimes[i] = MP4_INVALID_TIMESTAMP;
+        numChunks += maxChunkIds[i];
     }
+    chunks.reserve( numChunks );
 
     for( ;; ) {
         uint32_t nextTrackIndex = (uint32_t)-1;
@@ -367,18 +445,14 @@ void MP4File::RewriteMdat( File& src, File& dst )
         if( nextTrackIndex == (uint32_t)-1 )
             break;
 
-        uint8_t* pChunk;
-        uint32_t chunkSize;
-
-        // point into original mp4 file for read chunk call
-        m_file = &src;
-        m_pTracks[nextTrackIndex]->ReadChunk( chunkIds[nextTrackIndex], &pChunk, &chunkSize );
-
-        // point back at the new mp4 file for write chunk
-        m_file = &dst;
-        m_pTracks[nextTrackIndex]->RewriteChunk( chunkIds[nextTrackIndex], pChunk, chunkSize );
-
-        MP4Free( pChunk );
+        // remember where the chunk lives in the source file, the offset
+        // property is about to be overwritten with the destination offset
+        MdatChunk chunk;
+        chunk.trackIndex = nextTrackIndex;
+        chunk.chunkId    = chunkIds[nextTrackIndex];
+        chunk.srcOffset  = m_pTracks[nextTrackIndex]->GetChunkOffset( chunk.chunkId );
+        chunk.size       = m_pTracks[nextTrackIndex]->GetChunkSize( chunk.chunkId );
+        chunks.push_back( chunk );
 
         chunkIds[nextTrackIndex]++;
         nextChunkTimes[nextTrackIndex] = MP4_INVALID_TIMESTAMP;
@@ -389,6 +463,83 @@ void MP4File::RewriteMdat( File& src, File& dst )
     delete [] nextChunkTimes;
 }
 
+void MP4File::LayoutMdat( const vector<MdatChunk>& chunks )
+{
+    const vector<MdatChunk>::size_type max = chunks.size();
+
+    // Everything ahead of the mdat payload is sized with a size-only write
+    // and the chunk offsets are derived from it. Promoting a track to co64
+    // grows moov, so repeat until the payload start no longer moves; each
+    // track can be promoted at most once.
+    uint64_t mdatStart = 0;
+    for( ;; ) {
+        EnableMeasureMode();
+        try {
+            ((MP4RootAtom*)m_pRootAtom)->BeginOptimalWrite();
+        }
+        catch( ... ) {
+            (void)DisableMeasureMode();
+            throw;
+        }
+        uint64_t start = DisableMeasureMode();
+
+        if( start == mdatStart )
+            break;
+        mdatStart = start;
+
+        uint64_t offset = mdatStart;
+        for( vector<MdatChunk>::size_type i = 0; i < max; i++ ) {
+            m_pTracks[chunks[i].trackIndex]->SetChunkOffset( chunks[i].chunkId, offset );
+            offset += chunks[i].size;
+        }
+    }
+}
+
+void MP4File::RewriteMdat( File& src, File& dst, const vector<MdatChunk>& chunks )
+{
+    TraceSpan span( "optimize", "RewriteMdat", (MP4FileHandle)this );
+
+    const vector<MdatChunk>::size_type max = chunks.size();
+
+    uint8_t* pChunk = NULL;
+    uint32_t bufSize = 0;
+
+    try {
+        for( vector<MdatChunk>::size_type i = 0; i < max; i++ ) {
+            const MdatChunk& chunk = chunks[i];
+
+            if( chunk.size > bufSize ) {
+                pChunk = (uint8_t*)MP4Realloc( pChunk, chunk.size );
+                bufSize = chunk.size;
+            }
+
+            // read from original mp4 file
+            m_file = &src;
+            SetPosition( chunk.srcOffset );
+            ReadBytes( pChunk, chunk.size );
+
+            // write to the new mp4 file, where LayoutMdat() said it would go
+            m_file = &dst;
+            ASSERT( GetPosition() ==
+                    m_pTracks[chunk.trackIndex]->GetChunkOffset( chunk.chunkId ));
+            WriteBytes( pChunk, chunk.size );
+
+            MP4V2_LOG_RECORDF(GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_CHUNK_WRITE,
+                              m_pTracks[chunk.trackIndex]->GetId(), MP4_INVALID_SAMPLE_ID,
+                              "\"%s\": RewriteMdat: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+                              GetFilename().c_str(), m_pTracks[chunk.trackIndex]->GetId(),
+                              chunk.chunkId, chunk.srcOffset, chunk.size, chunk.size);
+        }
+    }
+    catch( ... ) {
+        m_file = &dst;
+        MP4Free( pChunk );
+        throw;
+    }
+
+    MP4Free( pChunk );
+}
+
 void MP4File::Open( const char* name, File::Mode mode, const MP4FileProvider* provider )
 {
     ASSERT( !m_file );
@@ -415,6 +566,9 @@ void MP4File::Open( const char* name, File::Mode mode, const MP4FileProvider* pr
 
 void MP4File::ReadFromFile()
 {
+    TraceSpan span( "parse", "ReadFromFile", (MP4FileHandle)this );
+    StatsTimer timer( *this, m_stats.parseMicroseconds, true ); // once per file
+
     // ensure we start at beginning of file
     SetPosition(0);
 
@@ -436,6 +590,8 @@ void MP4File::ReadFromFile()
 
 void MP4File::GenerateTracks()
 {
+    TraceSpan span( "parse", "GenerateTracks", (MP4FileHandle)this );
+
     uint32_t trackIndex = 0;
 
     while (true) {
@@ -477,7 +633,7 @@ void MP4File::GenerateTracks()
                 m_pTracks.Add(pTrack);
             }
             catch( Exception* x ) {
-                log.errorf(*x);
+                GetLog().errorf(*x);
                 delete x;
             }
 
@@ -486,8 +642,8 @@ void MP4File::GenerateTracks()
                 if (m_odTrackId == MP4_INVALID_TRACK_ID) {
                     m_odTrackId = pTrackIdProperty->GetValue();
                 } else {
-                    log.warningf("%s: \"%s\": multiple OD tracks present",
-                                 __FUNCTION__, GetFilename().c_str() );
+                    GetLog().warningf("%s: \"%s\": multiple OD tracks present",
+                                      __FUNCTION__, GetFilename().c_str() );
                 }
             }
         } else {
@@ -500,6 +656,8 @@ void MP4File::GenerateTracks()
 
 void MP4File::CacheProperties()
 {
+    TraceSpan span( "parse", "CacheProperties", (MP4FileHandle)this );
+
     FindIntegerProperty("moov.mvhd.modificationTime",
                         (MP4Property**)&m_pModificationProperty);
 
@@ -517,6 +675,8 @@ void MP4File::BeginWrite()
 
 void MP4File::FinishWrite(uint32_t options)
 {
+    TraceSpan span( "write", "FinishWrite", (MP4FileHandle)this );
+
     // remove empty moov.udta.meta.ilst
     {
         MP4Atom* ilst = FindAtom( "moov.udta.meta.ilst" );
@@ -576,6 +736,11 @@ void MP4File::FinishWrite(uint32_t options)
         m_pTracks[i]->FinishWrite(options);
     }
 
+    if( m_modifyInPlace ) {
+        FinishModifyInPlace();
+        return;
+    }
+
     // ask root atom to write
     m_pRootAtom->FinishWrite();
 
@@ -600,6 +765,195 @@ void MP4File::FinishWrite(uint32_t options)
     }
 }
 
+void MP4File::BeginModifyInPlace( MP4Atom* pMoovAtom )
+{
+    // the slot moov may be rewritten into: moov itself and the
+    // free/skip atoms directly before and after it
+    const uint32_t numAtoms = m_pRootAtom->GetNumberOfChildAtoms();
+    uint32_t first = 0;
+    while( m_pRootAtom->GetChildAtom( first ) != pMoovAtom )
+        first++;
+    uint32_t last = first;
+
+    while( first > 0 ) {
+        const char* type = m_pRootAtom->GetChildAtom( first - 1 )->GetType();
+        if( strcmp( type, "free" ) && strcmp( type, "skip" ))
+            break;
+        first--;
+    }
+    while( last + 1 < numAtoms ) {
+        const char* type = m_pRootAtom->GetChildAtom( last + 1 )->GetType();
+        if( strcmp( type, "free" ) && strcmp( type, "skip" ))
+            break;
+        last++;
+    }
+
+    // a moov behind the media data may have left its first slot as free
+    // space ahead of it, the largest run of free/skip atoms there is it
+    uint64_t runStart = 0;
+    uint64_t runSize = 0;
+    uint64_t bestStart = 0;
+    uint64_t bestSize = 0;
+    for( uint32_t i = 0; i < first; i++ ) {
+        MP4Atom* pAtom = m_pRootAtom->GetChildAtom( i );
+        const char* type = pAtom->GetType();
+        if( !strcmp( type, "mdat" )) {
+            m_frontSlotStart = bestStart;
+            m_frontSlotSize  = bestSize;
+            break;
+        }
+        if( strcmp( type, "free" ) && strcmp( type, "skip" )) {
+            runSize = 0;
+            continue;
+        }
+        if( !runSize )
+            runStart = pAtom->GetStart();
+        runSize = pAtom->GetEnd() - runStart;
+        if( runSize > bestSize ) {
+            bestStart = runStart;
+            bestSize  = runSize;
+        }
+    }
+
+    // from here on only changes count, see FinishModifyInPlace()
+    pMoovAtom->ClearModified();
+
+    m_moovSlotStart = m_pRootAtom->GetChildAtom( first )->GetStart();
+    m_moovSlotSize  = m_pRootAtom->GetChildAtom( last )->GetEnd() - m_moovSlotStart;
+
+    // the padding is written anew by FinishModifyInPlace()
+    for( uint32_t i = last + 1; i-- > first; ) {
+        MP4Atom* pAtom = m_pRootAtom->GetChildAtom( i );
+        if( pAtom == pMoovAtom )
+            continue;
+        m_pRootAtom->DeleteChildAtom( pAtom );
+        delete pAtom;
+    }
+
+    m_modifyInPlace = true;
+}
+
+void MP4File::FinishModifyInPlace()
+{
+    MP4Atom* pMoovAtom = FindAtom( "moov" );
+    ASSERT( pMoovAtom );
+
+    // nothing changed since the file was opened, the file already holds it
+    if( !pMoovAtom->IsSubtreeModified() )
+        return;
+
+    // traks unchanged since they were read keep their bytes, so a tag edit
+    // does not serialize the sample tables again; everything else in moov
+    // is small and written as usual
+    struct Child {
+        MP4Atom* atom;
+        bool     reuse;
+        uint64_t size;
+    };
+
+    const uint32_t numChildren = pMoovAtom->GetNumberOfChildAtoms();
+    vector<Child> children( numChildren );
+    uint64_t moovSize = 8;
+    for( uint32_t i = 0; i < numChildren; i++ ) {
+        Child& child = children[i];
+        child.atom  = pMoovAtom->GetChildAtom( i );
+        child.reuse = ATOMID( child.atom->GetType() ) == ATOMID( "trak" ) && !child.atom->IsSubtreeModified();
+        child.size  = child.reuse ? child.atom->GetEnd() - child.atom->GetStart() : MeasureAtom( child.atom );
+        moovSize += child.size;
+    }
+
+    // a moov that moved behind the media data goes back to the front as
+    // soon as it fits there again, which restores fast start. moov at the
+    // end of the file can always grow, otherwise what is left over in a
+    // slot has to hold at least a free atom header
+    const uint64_t slotEnd = m_moovSlotStart + m_moovSlotSize;
+    const bool atEnd = slotEnd >= GetSize();
+    const bool toFront = m_frontSlotSize && ( moovSize == m_frontSlotSize || moovSize + 8 <= m_frontSlotSize );
+    const bool inPlace = !toFront && ( atEnd || moovSize == m_moovSlotSize || moovSize + 8 <= m_moovSlotSize );
+    const uint64_t moovStart = toFront ? m_frontSlotStart : inPlace ? m_moovSlotStart : GetSize();
+
+    // move the reused traks first, each only overlaps its own old bytes as
+    // long as those moving down go in file order and the others in reverse
+    vector<uint64_t> starts( numChildren );
+    uint64_t pos = moovStart + 8;
+    for( uint32_t i = 0; i < numChildren; i++ ) {
+        starts[i] = pos;
+        pos += children[i].size;
+    }
+    for( uint32_t i = 0; i < numChildren; i++ ) {
+        if( children[i].reuse && starts[i] < children[i].atom->GetStart() )
+            MoveAtom( children[i].atom, starts[i] );
+    }
+    for( uint32_t i = numChildren; i-- > 0; ) {
+        if( children[i].reuse && starts[i] > children[i].atom->GetStart() )
+            MoveAtom( children[i].atom, starts[i] );
+    }
+
+    SetPosition( moovStart );
+    pMoovAtom->BeginWrite();
+    for( uint32_t i = 0; i < numChildren; i++ ) {
+        if( children[i].reuse )
+            SetPosition( starts[i] + children[i].size );
+        else
+            children[i].atom->Write();
+    }
+    pMoovAtom->FinishWrite();
+
+    if( toFront ) {
+        if( GetPosition() < m_frontSlotStart + m_frontSlotSize )
+            WritePadding( m_frontSlotStart + m_frontSlotSize - GetPosition() );
+
+        // the old slot becomes free space, as below
+        SetPosition( m_moovSlotStart );
+        WritePadding( m_moovSlotSize, false );
+        return;
+    }
+
+    if( inPlace ) {
+        // at the end of the file a leftover too small for a free atom is
+        // padded up to one, which makes the file a few bytes longer
+        if( GetPosition() < slotEnd )
+            WritePadding( atEnd ? max( slotEnd - GetPosition(), (uint64_t)8 ) : slotEnd - GetPosition() );
+        return;
+    }
+
+    // moov has outgrown its slot and moved to the end with padding for the
+    // next edit; the old slot becomes free space, the old bytes need not be
+    // cleared, that would cost a write of the whole old moov
+    if( m_moovPadding )
+        WritePadding( max( (uint64_t)m_moovPadding, (uint64_t)8 ));
+
+    SetPosition( m_moovSlotStart );
+    WritePadding( m_moovSlotSize, false );
+}
+
+void MP4File::WritePadding( uint64_t size, bool fill )
+{
+    ASSERT( size >= 8 );
+
+    if( size > 0xFFFFFFFF ) {
+        WriteUInt32( 1 );
+        WriteBytes( (uint8_t*)"free", 4 );
+        WriteUInt64( size );
+        size -= 16;
+    }
+    else {
+        WriteUInt32( (uint32_t)size );
+        WriteBytes( (uint8_t*)"free", 4 );
+        size -= 8;
+    }
+
+    if( !fill )
+        return;
+
+    static const uint8_t zeros[4096] = { 0 };
+    while( size ) {
+        const uint32_t n = (uint32_t)min( size, (uint64_t)sizeof( zeros ));
+        WriteBytes( (uint8_t*)zeros, n );
+        size -= n;
+    }
+}
+
 void MP4File::UpdateDuration(MP4Duration duration)
 {
     MP4Duration currentDuration = GetDuration();
@@ -610,21 +964,139 @@ void MP4File::UpdateDuration(MP4Duration duration)
 
 void MP4File::Dump( bool dumpImplicits )
 {
-    log.dump(0, MP4_LOG_VERBOSE1, "\"%s\": Dumping meta-information...", m_file->name.c_str() );
+    GetLog().dump(0, MP4_LOG_VERBOSE1, "\"%s\": Dumping meta-information...", m_file->name.c_str() );
     m_pRootAtom->Dump( 0, dumpImplicits);
 }
 
 void MP4File::Close(uint32_t options)
 {
     if( IsWriteMode() ) {
-        SetIntegerProperty( "moov.mvhd.modificationTime", MP4GetAbsTimestamp() );
+        // a file modified in place and left untouched is not written at all
+        if( !m_modifyInPlace || FindAtom( "moov" )->IsSubtreeModified() )
+            SetIntegerProperty( "moov.mvhd.modificationTime", MP4GetAbsTimestamp() );
         FinishWrite(options);
     }
 
+    // everything has been drained by FinishWrite(), this only reports
+    // an error that was not surfaced yet
+    StopAsyncWrite();
+
     delete m_file;
     m_file = NULL;
 }
 
+// Atom placement as established by Read() or the last Write().
+// Measuring re-runs Write() so the placement must be put back afterwards,
+// otherwise Modify() and friends would be looking at a virtual layout.
+struct MP4AtomPlacement {
+    MP4Atom* atom;
+    uint64_t start;
+    uint64_t end;
+    uint64_t size;
+};
+
+static void SaveAtomPlacement( MP4Atom* pAtom, vector<MP4AtomPlacement>& saved )
+{
+    MP4AtomPlacement placement;
+    placement.atom  = pAtom;
+    placement.start = pAtom->GetStart();
+    placement.end   = pAtom->GetEnd();
+    placement.size  = pAtom->GetSize();
+    saved.push_back( placement );
+
+    const uint32_t numAtoms = pAtom->GetNumberOfChildAtoms();
+    for( uint32_t i = 0; i < numAtoms; i++ )
+        SaveAtomPlacement( pAtom->GetChildAtom( i ), saved );
+}
+
+static void RestoreAtomPlacement( vector<MP4AtomPlacement>& saved )
+{
+    const vector<MP4AtomPlacement>::size_type max = saved.size();
+    for( vector<MP4AtomPlacement>::size_type i = 0; i < max; i++ ) {
+        saved[i].atom->SetStart( saved[i].start );
+        saved[i].atom->SetEnd( saved[i].end );
+        saved[i].atom->SetSize( saved[i].size );
+    }
+}
+
+static void ShiftAtomPlacement( MP4Atom* pAtom, int64_t delta )
+{
+    pAtom->SetStart( pAtom->GetStart() + delta );
+    pAtom->SetEnd( pAtom->GetEnd() + delta );
+
+    const uint32_t numAtoms = pAtom->GetNumberOfChildAtoms();
+    for( uint32_t i = 0; i < numAtoms; i++ )
+        ShiftAtomPlacement( pAtom->GetChildAtom( i ), delta );
+}
+
+uint64_t MP4File::EstimateMoovSize()
+{
+    MP4Atom* pMoovAtom = FindAtom( "moov" );
+    if( !pMoovAtom )
+        throw new Exception( "no moov atom", __FILE__, __LINE__, __FUNCTION__ );
+
+    // add what closing the file adds to the tables, the pending chunks are
+    // written one after the other at the current position
+    uint64_t pending = 0;
+    uint64_t chunkOffset = GetPosition();
+    for( uint32_t i = 0; i < m_pTracks.Size(); i++ )
+        pending += m_pTracks[i]->GetPendingMoovBytes( chunkOffset );
+
+    return MeasureAtom( pMoovAtom ) + pending;
+}
+
+uint64_t MP4File::MeasureAtom( MP4Atom* pAtom )
+{
+    vector<MP4AtomPlacement> saved;
+    SaveAtomPlacement( pAtom, saved );
+
+    // serialize through the regular write path with size-only writes so the
+    // result is exact, including chunk offset tables that went 64-bit (co64)
+    EnableMeasureMode();
+    try {
+        pAtom->Write();
+    }
+    catch( ... ) {
+        (void)DisableMeasureMode();
+        RestoreAtomPlacement( saved );
+        throw;
+    }
+
+    const uint64_t size = DisableMeasureMode();
+    RestoreAtomPlacement( saved );
+
+    return size;
+}
+
+void MP4File::MoveAtom( MP4Atom* pAtom, uint64_t start )
+{
+    const uint64_t from = pAtom->GetStart();
+    const uint64_t size = pAtom->GetEnd() - from;
+
+    // like memmove(), copy from the end when moving towards the end
+    const uint32_t blockSize = 1 << 20;
+    uint8_t* buffer = (uint8_t*)MP4Malloc( (size_t)min( size, (uint64_t)blockSize ));
+    try {
+        for( uint64_t done = 0; done < size; ) {
+            const uint32_t n = (uint32_t)min( size - done, (uint64_t)blockSize );
+            const uint64_t offset = start > from ? size - done - n : done;
+
+            SetPosition( from + offset );
+            ReadBytes( buffer, n );
+            SetPosition( start + offset );
+            WriteBytes( buffer, n );
+            done += n;
+        }
+    }
+    catch( ... ) {
+        MP4Free( buffer );
+        throw;
+    }
+    MP4Free( buffer );
+
+    ShiftAtomPlacement( pAtom, (int64_t)( start - from ));
+}
+
 void MP4File::Rename(const char* oldFileName, const char* newFileName)
 {
     if( FileSystem::rename( oldFileName, newFileName ))
@@ -925,8 +1397,8 @@ MP4TrackId MP4File::AddTrack(const char* type, uint32_t timeScale)
 
     // sanity check for user defined types
     if (strlen(normType) > 4) {
-        log.warningf("%s: \"%s\": type truncated to four characters",
-                     __FUNCTION__, GetFilename().c_str());
+        GetLog().warningf("%s: \"%s\": type truncated to four characters",
+                          __FUNCTION__, GetFilename().c_str());
         // StringProperty::SetValue() will do the actual truncation
     }
 
@@ -1955,8 +2427,8 @@ void MP4File::AddH264SequenceParameterSet (MP4TrackId trackId,
                                     (MP4Property **)&pLength) == false) ||
             (avcCAtom->FindProperty("avcC.sequenceEntries.sequenceParameterSetNALUnit",
                                     (MP4Property **)&pUnit) == false)) {
-        log.errorf("%s: \"%s\": Could not find avcC properties",
-                   __FUNCTION__, GetFilename().c_str() );
+        GetLog().errorf("%s: \"%s\": Could not find avcC properties",
+                        __FUNCTION__, GetFilename().c_str() );
         return;
     }
     uint32_t count = pCount->GetValue();
@@ -1998,8 +2470,8 @@ void MP4File::AddH264PictureParameterSet (MP4TrackId trackId,
                                     (MP4Property **)&pLength) == false) ||
             (avcCAtom->FindProperty("avcC.pictureEntries.pictureParameterSetNALUnit",
                                     (MP4Property **)&pUnit) == false)) {
-        log.errorf("%s: \"%s\": Could not find avcC picture table properties",
-                   __FUNCTION__, GetFilename().c_str());
+        GetLog().errorf("%s: \"%s\": Could not find avcC picture table properties",
+                        __FUNCTION__, GetFilename().c_str());
         return;
     }
 
@@ -2014,8 +2486,8 @@ void MP4File::AddH264PictureParameterSet (MP4TrackId trackId,
                 uint32_t seqlen;
                 pUnit->GetValue(&seq, &seqlen, index);
                 if (memcmp(seq, pPict, pictLen) == 0) {
-                    log.verbose1f("\"%s\": picture matches %d", 
-                                  GetFilename().c_str(), index);
+                    GetLog().verbose1f("\"%s\": picture matches %d", 
+                                       GetFilename().c_str(), index);
                     free(seq);
                     return;
                 }
@@ -2026,8 +2498,8 @@ void MP4File::AddH264PictureParameterSet (MP4TrackId trackId,
     pLength->AddValue(pictLen);
     pUnit->AddValue(pPict, pictLen);
     pCount->IncrementValue();
-    log.verbose1f("\"%s\": new picture added %d", GetFilename().c_str(),
-                  pCount->GetValue());
+    GetLog().verbose1f("\"%s\": new picture added %d", GetFilename().c_str(),
+                       pCount->GetValue());
 
     return;
 }
@@ -2342,6 +2814,44 @@ MP4TrackId MP4File::AddColr(MP4TrackId trackId,
 }
 
 
+// append a QuickTime chapter text sample: the title with its 16-bit length
+// followed by an encoding modifier
+static void AppendChapterSample(vector<uint8_t>& samples, const char* title, uint32_t textLen)
+{
+    const vector<uint8_t>::size_type x = samples.size();
+    samples.resize(x + 2 + textLen + 12);
+    uint8_t* sample = &samples[x];
+
+    // 2-byte length marker
+    sample[0] = (textLen >> 8) & 0xff;
+    sample[1] = textLen & 0xff;
+
+    if (0 < textLen)
+    {
+        memcpy(&sample[2], title, textLen);
+    }
+
+    uint8_t* modifier = &sample[2 + textLen];
+
+    // Modifier Length Marker
+    modifier[0] = 0x00;
+    modifier[1] = 0x00;
+    modifier[2] = 0x00;
+    modifier[3] = 0x0C;
+
+    // Modifier Type Code
+    modifier[4] = 'e';
+    modifier[5] = 'n';
+    modifier[6] = 'c';
+    modifier[7] = 'd';
+
+    // Modifier Value
+    modifier[8] = 0x00;
+    modifier[9] = 0x00;
+    modifier[10] = (256 >> 8) & 0xff;
+    modifier[11] = 256 & 0xff;
+}
+
 void MP4File::AddChapter(MP4TrackId chapterTrackId, MP4Duration chapterDuration, const char *chapterTitle)
 {
     if (MP4_INVALID_TRACK_ID == chapterTrackId)
@@ -2349,18 +2859,13 @@ void MP4File::AddChapter(MP4TrackId chapterTrackId, MP4Duration chapterDuration,
         throw new Exception("No chapter track given",__FILE__, __LINE__, __FUNCTION__);
     }
 
-    uint32_t sampleLength = 0;
-    uint8_t  sample[1040] = {0};
-    int textLen = 0;
-    char *text = (char *)&(sample[2]);
+    char text[1024];
+    uint32_t textLen = 0;
 
     if(chapterTitle != NULL)
     {
         textLen = min((uint32_t)strlen(chapterTitle), (uint32_t)MP4V2_CHAPTER_TITLE_MAX);
-        if (0 < textLen)
-        {
-            strncpy(text, chapterTitle, textLen);
-        }
+        memcpy(text, chapterTitle, textLen);
     }
     else
     {
@@ -2369,33 +2874,42 @@ void MP4File::AddChapter(MP4TrackId chapterTrackId, MP4Duration chapterDuration,
         textLen = (uint32_t)strlen(text);
     }
 
-    sampleLength = textLen + 2 + 12; // Account for text length code and other marker
+    vector<uint8_t> sample;
+    AppendChapterSample(sample, text, textLen);
 
-    // 2-byte length marker
-    sample[0] = (textLen >> 8) & 0xff;
-    sample[1] = textLen & 0xff;
+    WriteSample(chapterTrackId, &sample[0], (uint32_t)sample.size(), chapterDuration);
+}
 
-    int x = 2 + textLen;
+void MP4File::AddChapters(MP4TrackId chapterTrackId, const MP4Chapter_t* chapters, uint32_t chapterCount)
+{
+    if (MP4_INVALID_TRACK_ID == chapterTrackId)
+    {
+        throw new Exception("No chapter track given",__FILE__, __LINE__, __FUNCTION__);
+    }
 
-    // Modifier Length Marker
-    sample[x] = 0x00;
-    sample[x+1] = 0x00;
-    sample[x+2] = 0x00;
-    sample[x+3] = 0x0C;
+    ProtectWriteOperation(__FILE__, __LINE__, __FUNCTION__);
 
-    // Modifier Type Code
-    sample[x+4] = 'e';
-    sample[x+5] = 'n';
-    sample[x+6] = 'c';
-    sample[x+7] = 'd';
+    MP4Track * pChapterTrack = GetTrack(chapterTrackId);
+    const uint32_t timescale = pChapterTrack->GetTimeScale();
 
-    // Modifier Value
-    sample[x+8] = 0x00;
-    sample[x+9] = 0x00;
-    sample[x+10] = (256 >> 8) & 0xff;
-    sample[x+11] = 256 & 0xff;
+    vector<uint8_t> samples;
+    vector<uint32_t> sizes(chapterCount);
+    vector<MP4Duration> durations(chapterCount);
 
-    WriteSample(chapterTrackId, sample, sampleLength, chapterDuration);
+    for (uint32_t i = 0; i < chapterCount; ++i)
+    {
+        const vector<uint8_t>::size_type before = samples.size();
+        const uint32_t textLen = (uint32_t)strnlen(chapters[i].title, MP4V2_CHAPTER_TITLE_MAX);
+        AppendChapterSample(samples, chapters[i].title, textLen);
+
+        sizes[i] = (uint32_t)(samples.size() - before);
+        durations[i] = MP4ConvertTime(chapters[i].duration, MP4_MILLISECONDS_TIME_SCALE, timescale);
+    }
+
+    pChapterTrack->WriteSamples(samples.empty() ? NULL : &samples[0],
+                                sizes.empty() ? NULL : &sizes[0],
+                                durations.empty() ? NULL : &durations[0],
+                                chapterCount);
 }
 
 void MP4File::AddNeroChapter(MP4Timestamp chapterStart, const char * chapterTitle)
@@ -2435,6 +2949,47 @@ void MP4File::AddNeroChapter(MP4Timestamp chapterStart, const char * chapterTitl
     }
 }
 
+void MP4File::AddNeroChapters(MP4Timestamp chapterStart, const MP4Chapter_t* chapters, uint32_t chapterCount)
+{
+    if (0 == chapterCount)
+    {
+        return;
+    }
+
+    MP4Atom * pChpl = FindAtom("moov.udta.chpl");
+    if (!pChpl)
+    {
+        pChpl = AddDescendantAtoms("", "moov.udta.chpl");
+    }
+
+    MP4Integer32Property * pCount = 0;
+    MP4TableProperty * pTable = 0;
+    if (!pChpl->FindProperty("chpl.chaptercount", (MP4Property **)&pCount) ||
+        !pChpl->FindProperty("chpl.chapters", (MP4Property **)&pTable))
+    {
+        throw new Exception("Nero chapter list does not exist", __FILE__, __LINE__, __FUNCTION__);
+    }
+
+    MP4Integer64Property * pStartTime = (MP4Integer64Property *) pTable->GetProperty(0);
+    MP4StringProperty * pName = (MP4StringProperty *) pTable->GetProperty(1);
+
+    // Nero titles carry an 8-bit length
+    char buffer[256];
+    for (uint32_t i = 0; i < chapterCount; ++i)
+    {
+        uint32_t len = (uint32_t)strnlen(chapters[i].title, 255);
+        memcpy(buffer, chapters[i].title, len);
+        buffer[len] = 0;
+
+        pStartTime->AddValue(chapterStart);
+        pName->AddValue(buffer);
+
+        chapterStart += 10 * MP4_MILLISECONDS_TIME_SCALE * chapters[i].duration;
+    }
+
+    pCount->IncrementValue(chapterCount);
+}
+
 MP4TrackId MP4File::FindChapterReferenceTrack(MP4TrackId chapterTrackId, char * trackName, int trackNameSize)
 {
     for (uint32_t i = 0; i < m_pTracks.Size(); i++)
@@ -2539,11 +3094,6 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
 
     if (MP4ChapterTypeAny == fromChapterType || MP4ChapterTypeQt == fromChapterType)
     {
-        uint8_t * sample = 0;
-        uint32_t sampleSize = 0;
-        MP4Timestamp startTime = 0;
-        MP4Duration duration = 0;
-
         // get the chapter track
         MP4TrackId chapterTrackId = FindChapterTrack();
         if (MP4_INVALID_TRACK_ID == chapterTrackId)
@@ -2562,30 +3112,46 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
             if (0 < counter)
             {
                 uint32_t timescale = pChapterTrack->GetTimeScale();
+
+                // the text samples are tiny and usually stored back to back,
+                // fetch all of them at once instead of seeking per chapter
+                vector<uint8_t> samples;
+                vector<uint32_t> sampleSizes;
+                pChapterTrack->ReadAllSamples(samples, sampleSizes);
+
                 MP4Chapter_t * chapters = (MP4Chapter_t*)MP4Malloc(sizeof(MP4Chapter_t) * counter);
 
+                // walk stts along with the samples for the durations
+                MP4SampleCursor cursor(*pChapterTrack, false);
+                MP4SampleId sampleId = MP4_INVALID_SAMPLE_ID;
+                MP4Timestamp startTime = 0;
+                MP4Duration duration = 0;
+                uint32_t samplePos = 0;
+
                 // process all chapter sample
                 for (uint32_t i = 0; i < counter; ++i)
                 {
-                    // get the sample corresponding to the starttime
-                    MP4SampleId sampleId = pChapterTrack->GetSampleIdFromTime(startTime + duration, true);
-                    pChapterTrack->ReadSample(sampleId, &sample, &sampleSize);
+                    if (!cursor.Next(sampleId, startTime, duration))
+                    {
+                        duration = 0;
+                    }
 
-                    // get the starttime and duration
-                    pChapterTrack->GetSampleTimes(sampleId, &startTime, &duration);
+                    const uint8_t * sample = samples.empty() ? NULL : &samples[samplePos];
+                    const uint32_t sampleSize = sampleSizes[i];
+                    samplePos += sampleSize;
 
                     // we know that sample+2 contains the title (sample[0] and sample[1] is the length)
-                    const char * title = (const char *)&(sample[2]);
-                    int titleLen = min((uint32_t)((sample[0] << 8) | sample[1]), (uint32_t)MP4V2_CHAPTER_TITLE_MAX);
-                    strncpy(chapters[i].title, title, titleLen);
+                    uint32_t titleLen = 0;
+                    if (sampleSize >= 2)
+                    {
+                        titleLen = min((uint32_t)((sample[0] << 8) | sample[1]), sampleSize - 2);
+                        titleLen = min(titleLen, (uint32_t)MP4V2_CHAPTER_TITLE_MAX);
+                        memcpy(chapters[i].title, &sample[2], titleLen);
+                    }
                     chapters[i].title[titleLen] = 0;
 
                     // write the duration (in milliseconds)
                     chapters[i].duration = MP4ConvertTime(duration, timescale, MP4_MILLISECONDS_TIME_SCALE);
-
-                    // we're done with this sample
-                    MP4Free(sample);
-                    sample = 0;
                 }
 
                 *chapterList = chapters;
@@ -2608,16 +3174,16 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
         MP4Integer32Property * pCounter = 0;
         if (!pChpl->FindProperty("chpl.chaptercount", (MP4Property **)&pCounter))
         {
-            log.warningf("%s: \"%s\": Nero chapter count does not exist",
-                         __FUNCTION__, GetFilename().c_str());
+            GetLog().warningf("%s: \"%s\": Nero chapter count does not exist",
+                              __FUNCTION__, GetFilename().c_str());
             return MP4ChapterTypeNone;
         }
 
         uint32_t counter = pCounter->GetValue();
         if (0 == counter)
         {
-            log.warningf("%s: \"%s\": No Nero chapters available",
-                         __FUNCTION__, GetFilename().c_str());
+            GetLog().warningf("%s: \"%s\": No Nero chapters available",
+                              __FUNCTION__, GetFilename().c_str());
             return MP4ChapterTypeNone;
         }
 
@@ -2629,21 +3195,21 @@ MP4ChapterType MP4File::GetChapters(MP4Chapter_t ** chapterList, uint32_t * chap
 
         if (!pChpl->FindProperty("chpl.chapters", (MP4Property **)&pTable))
         {
-            log.warningf("%s: \"%s\": Nero chapter list does not exist",
-                         __FUNCTION__, GetFilename().c_str());
+            GetLog().warningf("%s: \"%s\": Nero chapter list does not exist",
+                              __FUNCTION__, GetFilename().c_str());
             return MP4ChapterTypeNone;
         }
 
         if (0 == (pStartTime = (MP4Integer64Property *) pTable->GetProperty(0)))
         {
-            log.warningf("%s: \"%s\": List of Chapter starttimes does not exist",
-                         __FUNCTION__, GetFilename().c_str());
+            GetLog().warningf("%s: \"%s\": List of Chapter starttimes does not exist",
+                              __FUNCTION__, GetFilename().c_str());
             return MP4ChapterTypeNone;
         }
         if (0 == (pName = (MP4StringProperty *) pTable->GetProperty(1)))
         {
-            log.warningf("%s: \"%s\": List of Chapter titles does not exist",
-                         __FUNCTION__, GetFilename().c_str());
+            GetLog().warningf("%s: \"%s\": List of Chapter titles does not exist",
+                              __FUNCTION__, GetFilename().c_str());
             return MP4ChapterTypeNone;
         }
 
@@ -2703,12 +3269,7 @@ MP4ChapterType MP4File::SetChapters(MP4Chapter_t * chapterList, uint32_t chapter
 
     if( MP4ChapterTypeAny == toChapterType || MP4ChapterTypeNero == toChapterType )
     {
-        MP4Duration duration = 0;
-        for( uint32_t i = 0; i < chapterCount; ++i )
-        {
-            AddNeroChapter(duration, chapterList[i].title);
-            duration += 10 * MP4_MILLISECONDS_TIME_SCALE * chapterList[i].duration;
-        }
+        AddNeroChapters(0, chapterList, chapterCount);
 
         setType = MP4ChapterTypeNero;
     }
@@ -2735,11 +3296,8 @@ MP4ChapterType MP4File::SetChapters(MP4Chapter_t * chapterList, uint32_t chapter
         // create the chapter track
         MP4TrackId chapterTrack = AddChapterTextTrack(refTrack, MP4_MILLISECONDS_TIME_SCALE);
 
-        for( uint32_t i = 0 ; i < chapterCount; ++i )
-        {
-            // create and write the chapter track sample
-            AddChapter( chapterTrack, chapterList[i].duration, chapterList[i].title );
-        }
+        // all chapter samples go out as one chunk
+        AddChapters( chapterTrack, chapterList, chapterCount );
 
         setType = MP4ChapterTypeNone == setType ? MP4ChapterTypeQt : MP4ChapterTypeAny;
     }
@@ -2773,8 +3331,8 @@ MP4ChapterType MP4File::ConvertChapters(MP4ChapterType toChapterType)
     GetChapters(&chapters, &chapterCount, sourceType);
     if (0 == chapterCount)
     {
-        log.warningf("%s: \"%s\": %s", __FUNCTION__, GetFilename().c_str(),
-                     errMsg);
+        GetLog().warningf("%s: \"%s\": %s", __FUNCTION__, GetFilename().c_str(),
+                          errMsg);
         return MP4ChapterTypeNone;
     }
 
@@ -3069,6 +3627,32 @@ void MP4File::WriteSample(
     m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
 }
 
+void MP4File::WriteSampleRef(
+    MP4TrackId           trackId,
+    const uint8_t*       pBytes,
+    uint32_t             numBytes,
+    MP4SampleReleaseFunc release,
+    void*                userData,
+    MP4Duration          duration,
+    MP4Duration          renderingOffset,
+    bool                 isSyncSample )
+{
+    MP4Track* pTrack;
+    try {
+        ProtectWriteOperation(__FILE__, __LINE__, __FUNCTION__);
+        pTrack = m_pTracks[FindTrackIndex(trackId)];
+    }
+    catch( ... ) {
+        if( release )
+            release( userData, pBytes );
+        throw;
+    }
+
+    pTrack->WriteSampleRef(
+        pBytes, numBytes, release, userData, duration, renderingOffset, isSyncSample );
+    m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+}
+
 void MP4File::WriteSampleDependency(
     MP4TrackId     trackId,
     const uint8_t* pBytes, 
@@ -3688,7 +4272,7 @@ void MP4File::GetTrackH264SeqPictHeaders (MP4TrackId trackId,
                                     (MP4Property **)&pSeqLen) == false) ||
             (avcCAtom->FindProperty("avcC.sequenceEntries.sequenceParameterSetNALUnit",
                                     (MP4Property **)&pSeqVal) == false)) {
-        log.errorf("%s: \"%s\": Could not find avcC properties", __FUNCTION__, GetFilename().c_str());
+        GetLog().errorf("%s: \"%s\": Could not find avcC properties", __FUNCTION__, GetFilename().c_str());
         return ;
     }
     uint8_t **ppSeqHeader =
@@ -3715,8 +4299,8 @@ void MP4File::GetTrackH264SeqPictHeaders (MP4TrackId trackId,
                                     (MP4Property **)&pPictLen) == false) ||
             (avcCAtom->FindProperty("avcC.pictureEntries.pictureParameterSetNALUnit",
                                     (MP4Property **)&pPictVal) == false)) {
-        log.errorf("%s: \"%s\": Could not find avcC picture table properties",
-                   __FUNCTION__, GetFilename().c_str());
+        GetLog().errorf("%s: \"%s\": Could not find avcC picture table properties",
+                        __FUNCTION__, GetFilename().c_str());
         return ;
     }
     uint8_t
@@ -4248,6 +4832,13 @@ MP4SampleId MP4File::GetSampleIdFromEditTime(
                when, pStartTime, pDuration);
 }
 
+MP4SampleCursor* MP4File::CreateSampleCursor(
+    MP4TrackId trackId,
+    bool applyEdits)
+{
+    return new MP4SampleCursor(*m_pTracks[FindTrackIndex(trackId)], applyEdits);
+}
+
 MP4Duration MP4File::GetTrackDurationPerChunk( MP4TrackId trackId )
 {
     return m_pTracks[FindTrackIndex(trackId)]->GetDurationPerChunk();
@@ -4323,6 +4914,54 @@ void MP4File::CopySample(
     free( pBytes );
 }
 
+void MP4File::ReferenceSample(
+    MP4File*    srcFile,
+    MP4TrackId  srcTrackId,
+    MP4SampleId srcSampleId,
+    MP4File*    dstFile,
+    MP4TrackId  dstTrackId,
+    MP4Duration dstSampleDuration )
+{
+    // Note: as with CopySample() the caller ensures the tracks are
+    // compatible, the referenced bytes are not looked at
+
+    if( !dstFile || dstFile == srcFile )
+        throw new Exception( "sample can't be referenced from its own file", __FILE__, __LINE__, __FUNCTION__ );
+
+    dstFile->ProtectWriteOperation( __FILE__, __LINE__, __FUNCTION__ );
+
+    MP4Track* pSrcTrack = srcFile->m_pTracks[srcFile->FindTrackIndex( srcTrackId )];
+    MP4Track* pDstTrack = dstFile->m_pTracks[dstFile->FindTrackIndex( dstTrackId )];
+
+    pDstTrack->ReferenceSample( *pSrcTrack, srcSampleId, dstSampleDuration );
+
+    dstFile->m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+}
+
+bool MP4File::CopyTrackChunks(
+    MP4File*    srcFile,
+    MP4TrackId  srcTrackId,
+    MP4File*    dstFile,
+    MP4TrackId  dstTrackId )
+{
+    // Note: as with CopySample() the caller ensures the tracks are
+    // compatible, typically dstTrackId was cloned from srcTrackId
+
+    if( !dstFile )
+        dstFile = srcFile;
+
+    dstFile->ProtectWriteOperation( __FILE__, __LINE__, __FUNCTION__ );
+
+    MP4Track* pSrcTrack = srcFile->m_pTracks[srcFile->FindTrackIndex( srcTrackId )];
+    MP4Track* pDstTrack = dstFile->m_pTracks[dstFile->FindTrackIndex( dstTrackId )];
+
+    if( pSrcTrack == pDstTrack || !pDstTrack->CopyChunks( *pSrcTrack ))
+        return false;
+
+    dstFile->m_pModificationProperty->SetValue( MP4GetAbsTimestamp() );
+    return true;
+}
+
 void MP4File::EncAndCopySample(
     MP4File*      srcFile,
     MP4TrackId    srcTrackId,
@@ -4374,8 +5013,8 @@ void MP4File::EncAndCopySample(
 
     //if( ismacrypEncryptSampleAddHeader( ismaCryptSId, numBytes, pBytes, &encSampleLength, &encSampleData ) != 0)
     if( encfcnp( encfcnparam1, numBytes, pBytes, &encSampleLength, &encSampleData ) != 0 )
-        log.errorf("%s(%s,%s) Can't encrypt the sample and add its header %u", 
-                   __FUNCTION__, srcFile->GetFilename().c_str(), dstFile->GetFilename().c_str(), srcSampleId );
+        dstFile->GetLog().errorf("%s(%s,%s) Can't encrypt the sample and add its header %u", 
+                                 __FUNCTION__, srcFile->GetFilename().c_str(), dstFile->GetFilename().c_str(), srcSampleId );
 
     if( hasDependencyFlags ) {
         dstFile->WriteSampleDependency(
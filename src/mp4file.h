@@ -56,6 +56,20 @@ public:
         MP4TrackId  dstTrackId,
         MP4Duration dstSampleDuration );
 
+    static void ReferenceSample(
+        MP4File*    srcFile,
+        MP4TrackId  srcTrackId,
+        MP4SampleId srcSampleId,
+        MP4File*    dstFile,
+        MP4TrackId  dstTrackId,
+        MP4Duration dstSampleDuration );
+
+    static bool CopyTrackChunks(
+        MP4File*    srcFile,
+        MP4TrackId  srcTrackId,
+        MP4File*    dstFile,
+        MP4TrackId  dstTrackId );
+
     static void EncAndCopySample(
         MP4File*      srcFile,
         MP4TrackId    srcTrackId,
@@ -84,13 +98,75 @@ public:
                  uint32_t    supportedBrandsCount = 0 );
 
     const std::string &GetFilename() const;
+
+    // log for messages about this file, the global one without a sink
+    Log& GetLog() {
+        return m_pLog ? *m_pLog : log;
+    }
+    void SetLogSink( MP4LogSink sink, void* userData, MP4LogLevel verbosity );
+
+    // counters behind MP4GetFileStats()
+    MP4FileStats& GetStats() {
+        return m_stats;
+    }
+
+    // sample I/O timers of m_stats run only when enabled, see
+    // MP4SetFileStatsTiming(); the counters are always kept
+    void SetStatsTiming( bool enabled ) {
+        m_statsTimingEnabled = enabled;
+    }
+
+    // adds the time until it goes out of scope to one of the m_stats
+    // timers, unless another StatsTimer of this file is already running;
+    // does not read the clock unless timing is enabled or always is set
+    class StatsTimer {
+    public:
+        StatsTimer( MP4File& file, uint64_t& total, bool always = false )
+            : m_file  ( file )
+            , m_total ( NULL )
+            , m_start ( 0 )
+        {
+            if( ( always || file.m_statsTimingEnabled ) && !file.m_statsTiming )
+                Start( total );
+        }
+        ~StatsTimer() {
+            if( m_total )
+                Stop();
+        }
+    private:
+        void Start( uint64_t& total );
+        void Stop();
+
+        MP4File&  m_file;
+        uint64_t* m_total;
+        int64_t   m_start;
+    };
+
     void Read( const char* name, const MP4FileProvider* provider );
-    bool Modify( const char* fileName );
+    bool Modify( const char* fileName, uint32_t flags = 0 );
     void Optimize( const char* srcFileName, const char* dstFileName = NULL );
     bool CopyClose( const string& copyFileName );
     void Dump( bool dumpImplicits = false );
     void Close(uint32_t flags = 0);
 
+    uint64_t EstimateMoovSize();
+    uint64_t MeasureAtom( MP4Atom* pAtom );
+
+    // room left after moov when MP4_MODIFY_IN_PLACE has to move it
+    void SetMoovPadding( uint32_t padding ) {
+        m_moovPadding = padding;
+    }
+
+    // MP4_MODIFY_IN_PLACE, there is no mdat to write samples to
+    bool IsModifyInPlace() {
+        return m_modifyInPlace;
+    }
+
+    // cover art data is read on first access, see MP4DataAtom::Read()
+    bool IsDeferringArtwork() {
+        return m_deferArtwork;
+    }
+
     bool Use64Bits(const char *atomName);
     void Check64BitStatus(const char *atomName);
     /* file properties */
@@ -221,6 +297,16 @@ public:
         MP4Duration    renderingOffset = 0,
         bool           isSyncSample = true );
 
+    void WriteSampleRef(
+        MP4TrackId           trackId,
+        const uint8_t*       pBytes,
+        uint32_t             numBytes,
+        MP4SampleReleaseFunc release,
+        void*                userData,
+        MP4Duration          duration = 0,
+        MP4Duration          renderingOffset = 0,
+        bool                 isSyncSample = true );
+
     void WriteSampleDependency(
         MP4TrackId     trackId,
         const uint8_t* pBytes,
@@ -416,6 +502,19 @@ public:
         MP4Duration chapterDuration,
         const char* chapterTitle = 0 );
 
+    /** Add QuickTime chapters in bulk.
+     *
+     *  All text samples are written as a single chunk with one write.
+     *
+     *  @param chapterTrackId ID of chapter track.
+     *  @param chapters chapters to append, durations in milliseconds.
+     *  @param chapterCount number of chapters.
+     */
+    void AddChapters(
+        MP4TrackId          chapterTrackId,
+        const MP4Chapter_t* chapters,
+        uint32_t            chapterCount );
+
     /** Add a Nero chapter.
      *
      *  @param chapterStart the start time of the chapter in 100 nanosecond units
@@ -426,6 +525,20 @@ public:
         MP4Timestamp chapterStart,
         const char*  chapterTitle = 0 );
 
+    /** Add Nero chapters in bulk.
+     *
+     *  The chapters start back to back at <b>chapterStart</b>.
+     *
+     *  @param chapterStart the start time of the first chapter in 100
+     *      nanosecond units.
+     *  @param chapters chapters to append, durations in milliseconds.
+     *  @param chapterCount number of chapters.
+     */
+    void AddNeroChapters(
+        MP4Timestamp        chapterStart,
+        const MP4Chapter_t* chapters,
+        uint32_t            chapterCount );
+
     /*! Returns the ID of the track referencing the chapter track chapterTrackId.
      *  This function searches for a track of type MP4_AUDIO_TRACK_TYPE that references
      *  the track chapterTrackId through the atom "tref.chap".
@@ -771,6 +884,10 @@ public:
         MP4Timestamp* pStartTime = NULL,
         MP4Duration* pDuration = NULL);
 
+    MP4SampleCursor* CreateSampleCursor(
+        MP4TrackId trackId,
+        bool applyEdits);
+
     /* "protected" interface to be used only by friends in library */
 
     uint64_t GetPosition( File* file = NULL );
@@ -778,6 +895,9 @@ public:
     uint64_t GetSize( File* file = NULL );
 
     void ReadBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
+    // read from the file itself at pos, whatever the current position or
+    // memory buffer, the file position is left unchanged
+    void ReadBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz );
     void PeekBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
 
     uint64_t ReadUInt(uint8_t size);
@@ -798,6 +918,7 @@ public:
 
 
     void WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file = NULL );
+    void WriteBytesv( const File::Segment* segments, uint32_t count, File* file = NULL );
     void WriteUInt8(uint8_t value);
     void WriteUInt16(uint16_t value);
     void WriteUInt24(uint32_t value);
@@ -821,6 +942,15 @@ public:
     void DisableMemoryBuffer(
         uint8_t** ppBytes = NULL, uint64_t* pNumBytes = NULL);
 
+    void EnableMeasureMode();
+    uint64_t DisableMeasureMode();
+
+    // write-behind of chunk data, see MP4_CREATE_ASYNC_WRITE
+    bool IsAsyncWrite() {
+        return m_asyncWriter != NULL;
+    }
+    void WriteChunkAsync( MP4AsyncWriter::Job* job );
+
     bool IsWriteMode();
 
     MP4Track* GetTrack(MP4TrackId trackId);
@@ -872,7 +1002,27 @@ protected:
     void BeginWrite();
     void FinishWrite(uint32_t options);
     void CacheProperties();
-    void RewriteMdat( File& src, File& dst );
+
+    void BeginModifyInPlace( MP4Atom* pMoovAtom );
+    void FinishModifyInPlace();
+    void WritePadding( uint64_t size, bool fill = true );
+    void MoveAtom( MP4Atom* pAtom, uint64_t start );
+
+    // one chunk of an optimized mdat, in interleaved output order
+    struct MdatChunk {
+        uint32_t   trackIndex;
+        MP4ChunkId chunkId;
+        uint64_t   srcOffset;
+        uint32_t   size;
+    };
+
+    void PlanMdat( vector<MdatChunk>& chunks );
+    void LayoutMdat( const vector<MdatChunk>& chunks );
+    void RewriteMdat( File& src, File& dst, const vector<MdatChunk>& chunks );
+
+    void StartAsyncWrite();
+    void StopAsyncWrite();
+    void SyncAsyncWrite( File* file );
     bool ShallHaveIods();
 
     void Rename(const char* existingFileName, const char* newFileName);
@@ -989,6 +1139,39 @@ protected:
     uint64_t    m_memoryBufferPosition;
     uint64_t    m_memoryBufferSize;
 
+    // size-only writes, nothing reaches the file
+    bool        m_measureMode;
+    uint64_t    m_measurePosition;
+    uint64_t    m_measureSize;
+
+    // chunk data queued on m_asyncWriter, m_asyncPosition is where the
+    // file position will be once it is all written
+    MP4AsyncWriter* m_asyncWriter;
+    bool            m_asyncPending;
+    uint64_t        m_asyncPosition;
+
+    // MP4_MODIFY_IN_PLACE, moov and the free/skip atoms around it
+    bool        m_modifyInPlace;
+    uint64_t    m_moovSlotStart;
+    uint64_t    m_moovSlotSize;
+    uint32_t    m_moovPadding;
+
+    // free space ahead of the media data a moov behind it can move back
+    // to, left by an earlier edit that outgrew it; size 0 if none
+    uint64_t    m_frontSlotStart;
+    uint64_t    m_frontSlotSize;
+
+    // only for files opened by Read(), which keep reading the same file
+    bool        m_deferArtwork;
+
+    // log of this file once a sink is set, see GetLog()
+    Log*        m_pLog;
+
+    // I/O and parse statistics, m_statsTiming while a StatsTimer runs
+    MP4FileStats m_stats;
+    bool         m_statsTiming;
+    bool         m_statsTimingEnabled;
+
     // bit read/write buffering
     uint8_t m_numReadBits;
     uint8_t m_bufReadBits;
@@ -1005,6 +1188,14 @@ protected:
     MP4File &operator= ( const MP4File &src );
 };
 
+// log for messages about a file, see MP4SetLogSink()
+inline Log& LogOfFile( MP4FileHandle hFile )
+{
+    if( !MP4_IS_VALID_FILE_HANDLE( hFile ))
+        return log;
+    return ((MP4File*)hFile)->GetLog();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 
 }} // namespace mp4v2::impl
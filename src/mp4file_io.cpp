@@ -33,9 +33,16 @@ uint64_t MP4File::GetPosition( File* file )
     if( m_memoryBuffer )
         return m_memoryBufferPosition;
 
+    if( m_measureMode )
+        return m_measurePosition;
+
     if( !file )
         file = m_file;
 
+    // no need to wait for queued chunks, their extent is known
+    if( m_asyncPending && file == m_file )
+        return m_asyncPosition;
+
     ASSERT( file );
     return file->position;
 }
@@ -49,10 +56,19 @@ void MP4File::SetPosition( uint64_t pos, File* file )
         return;
     }
 
+    if( m_measureMode ) {
+        if( pos > m_measureSize )
+            throw new Exception( "position out of range", __FILE__, __LINE__, __FUNCTION__ );
+        m_measurePosition = pos;
+        return;
+    }
+
     if( !file )
         file = m_file;
+    SyncAsyncWrite( file );
 
     ASSERT( file );
+    m_stats.seekCalls++;
     if( file->seek( pos ))
         throw new PlatformException( "seek failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
 }
@@ -62,8 +78,12 @@ uint64_t MP4File::GetSize( File* file )
     if( m_memoryBuffer )
         return m_memoryBufferSize;
 
+    if( m_measureMode )
+        return m_measureSize;
+
     if( !file )
         file = m_file;
+    SyncAsyncWrite( file );
 
     ASSERT( file );
     return file->size;
@@ -87,11 +107,43 @@ void MP4File::ReadBytes( uint8_t* buf, uint32_t bufsiz, File* file )
 
     if( !file )
         file = m_file;
+    SyncAsyncWrite( file );
 
     ASSERT( file );
     File::Size nin;
+    m_stats.readCalls++;
     if( file->read( buf, bufsiz, nin ))
         throw new PlatformException( "read failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
+    m_stats.bytesRead += nin;
+    if( nin != bufsiz )
+        throw new Exception( "not enough bytes, reached end-of-file", __FILE__, __LINE__, __FUNCTION__ );
+}
+
+void MP4File::ReadBytesAt( uint64_t pos, uint8_t* buf, uint32_t bufsiz )
+{
+    if( bufsiz == 0 )
+        return;
+
+    ASSERT( buf );
+    ASSERT( m_file );
+    SyncAsyncWrite( m_file );
+
+    const uint64_t position = m_file->position;
+    m_stats.seekCalls++;
+    if( m_file->seek( pos ))
+        throw new PlatformException( "seek failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
+
+    File::Size nin;
+    m_stats.readCalls++;
+    const bool failed = m_file->read( buf, bufsiz, nin );
+    m_stats.bytesRead += nin;
+
+    m_stats.seekCalls++;
+    if( m_file->seek( position ))
+        throw new PlatformException( "seek failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
+
+    if( failed )
+        throw new PlatformException( "read failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
     if( nin != bufsiz )
         throw new Exception( "not enough bytes, reached end-of-file", __FILE__, __LINE__, __FUNCTION__ );
 }
@@ -137,6 +189,84 @@ void MP4File::DisableMemoryBuffer( uint8_t** ppBytes, uint64_t* pNumBytes )
     m_memoryBufferPosition = 0;
 }
 
+void MP4File::EnableMeasureMode()
+{
+    ASSERT( !m_measureMode );
+
+    m_measureMode = true;
+    m_measurePosition = 0;
+    m_measureSize = 0;
+}
+
+uint64_t MP4File::DisableMeasureMode()
+{
+    ASSERT( m_measureMode );
+
+    const uint64_t size = m_measureSize;
+
+    m_measureMode = false;
+    m_measurePosition = 0;
+    m_measureSize = 0;
+
+    return size;
+}
+
+void MP4File::StartAsyncWrite()
+{
+    ASSERT( !m_asyncWriter );
+    ASSERT( m_file );
+
+    m_asyncWriter = new MP4AsyncWriter( *m_file );
+    m_asyncPending = false;
+}
+
+void MP4File::StopAsyncWrite()
+{
+    if( !m_asyncWriter )
+        return;
+
+    MP4AsyncWriter* writer = m_asyncWriter;
+    m_asyncWriter = NULL;
+    m_asyncPending = false;
+
+    try {
+        writer->Drain();
+    }
+    catch( ... ) {
+        delete writer;
+        throw;
+    }
+    delete writer;
+}
+
+void MP4File::SyncAsyncWrite( File* file )
+{
+    if( !m_asyncPending || file != m_file )
+        return;
+
+    // the file is shared with the writer thread until the queue is empty
+    m_asyncWriter->Drain();
+    m_asyncPending = false;
+}
+
+void MP4File::WriteChunkAsync( MP4AsyncWriter::Job* job )
+{
+    ASSERT( m_asyncWriter );
+
+    if( !m_asyncPending )
+        m_asyncPosition = m_file->position;
+
+    // the job belongs to the writer once submitted, it may be gone already
+    const uint64_t size = job->size;
+    job->offset = m_asyncPosition;
+    m_asyncWriter->Submit( job );
+
+    m_stats.writeCalls++;
+    m_stats.bytesWritten += size;
+    m_asyncPosition += size;
+    m_asyncPending = true;
+}
+
 void MP4File::WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file )
 {
     ASSERT( m_numWriteBits == 0 || m_numWriteBits >= 8 );
@@ -154,17 +284,60 @@ void MP4File::WriteBytes( uint8_t* buf, uint32_t bufsiz, File* file )
         return;
     }
 
+    // only account for the bytes, nothing goes to disk
+    if( m_measureMode ) {
+        m_measurePosition += bufsiz;
+        if( m_measurePosition > m_measureSize )
+            m_measureSize = m_measurePosition;
+        return;
+    }
+
     if( !file )
         file = m_file;
+    SyncAsyncWrite( file );
 
     ASSERT( file );
     File::Size nout;
+    m_stats.writeCalls++;
     if( file->write( buf, bufsiz, nout ))
         throw new PlatformException( "write failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
+    m_stats.bytesWritten += nout;
     if( nout != bufsiz )
         throw new Exception( "not all bytes written", __FILE__, __LINE__, __FUNCTION__ );
 }
 
+void MP4File::WriteBytesv( const File::Segment* segments, uint32_t count, File* file )
+{
+    ASSERT( m_numWriteBits == 0 || m_numWriteBits >= 8 );
+
+    if( !segments || count == 0 )
+        return;
+
+    // memory and measure modes have no use for a gather write
+    if( m_memoryBuffer || m_measureMode ) {
+        for( uint32_t i = 0; i < count; i++ )
+            WriteBytes( (uint8_t*)segments[i].buffer, (uint32_t)segments[i].size, file );
+        return;
+    }
+
+    if( !file )
+        file = m_file;
+    SyncAsyncWrite( file );
+
+    File::Size total = 0;
+    for( uint32_t i = 0; i < count; i++ )
+        total += segments[i].size;
+
+    ASSERT( file );
+    File::Size nout;
+    m_stats.writeCalls++;
+    if( file->writev( segments, count, nout ))
+        throw new PlatformException( "write failed", sys::getLastError(), __FILE__, __LINE__, __FUNCTION__ );
+    m_stats.bytesWritten += nout;
+    if( nout != total )
+        throw new Exception( "not all bytes written", __FILE__, __LINE__, __FUNCTION__ );
+}
+
 uint64_t MP4File::ReadUInt(uint8_t size)
 {
     switch (size) {
@@ -32,6 +32,18 @@ MP4Property::MP4Property(MP4Atom& parentAtom, const char* name)
     m_name = name;
     m_readOnly = false;
     m_implicit = false;
+
+    m_parentAtom.GetFile().GetStats().propertiesAllocated++;
+}
+
+Log& MP4Property::GetLog()
+{
+    return m_parentAtom.GetFile().GetLog();
+}
+
+void MP4Property::SetModified()
+{
+    m_parentAtom.SetModified();
 }
 
 bool MP4Property::FindProperty(const char* name,
@@ -42,8 +54,8 @@ bool MP4Property::FindProperty(const char* name,
     }
 
     if (!strcasecmp(m_name, name)) {
-        log.verbose1f("\"%s\": FindProperty: matched %s", 
-                      m_parentAtom.GetFile().GetFilename().c_str(), name);
+        GetLog().verbose1f("\"%s\": FindProperty: matched %s", 
+                           m_parentAtom.GetFile().GetFilename().c_str(), name);
         *ppProperty = this;
         return true;
     }
@@ -152,13 +164,13 @@ void MP4Integer8Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%02x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%02x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%02x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%02x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], m_values[index]);
 }
 
 void MP4Integer16Property::Dump(uint8_t indent,
@@ -168,13 +180,13 @@ void MP4Integer16Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%04x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%04x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%04x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%04x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], m_values[index]);
 }
 
 void MP4Integer24Property::Dump(uint8_t indent,
@@ -184,13 +196,13 @@ void MP4Integer24Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%06x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%06x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%06x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%06x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], m_values[index]);
 }
 
 void MP4Integer32Property::Dump(uint8_t indent,
@@ -200,13 +212,13 @@ void MP4Integer32Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%08x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %u (0x%08x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%08x)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %u (0x%08x)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], m_values[index]);
 }
 
 void MP4Integer64Property::Dump(uint8_t indent,
@@ -216,13 +228,13 @@ void MP4Integer64Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %" PRIu64 " (0x%016" PRIx64 ")",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %" PRIu64 " (0x%016" PRIx64 ")",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %" PRIu64 " (0x%016" PRIx64 ")",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %" PRIu64 " (0x%016" PRIx64 ")",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], m_values[index]);
 }
 
 // MP4BitfieldProperty
@@ -254,15 +266,15 @@ void MP4BitfieldProperty::Dump(uint8_t indent,
         hexWidth++;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1,
-                 "\"%s\": %s[%u] = %" PRIu64 " (0x%0*" PRIx64 ") <%u bits>",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index], (int)hexWidth, m_values[index], m_numBits);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1,
+                      "\"%s\": %s[%u] = %" PRIu64 " (0x%0*" PRIx64 ") <%u bits>",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index], (int)hexWidth, m_values[index], m_numBits);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1,
-                 "\"%s\": %s = %" PRIu64 " (0x%0*" PRIx64 ") <%u bits>",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index], (int)hexWidth, m_values[index], m_numBits);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1,
+                      "\"%s\": %s = %" PRIu64 " (0x%0*" PRIx64 ") <%u bits>",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index], (int)hexWidth, m_values[index], m_numBits);
 }
 
 // MP4Float32Property
@@ -302,13 +314,13 @@ void MP4Float32Property::Dump(uint8_t indent,
         return;
     }
     if (index != 0)
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %f",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, index, m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u] = %f",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, index, m_values[index]);
     else
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %f",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, m_values[index]);
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %f",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, m_values[index]);
 }
 
 // MP4StringProperty
@@ -341,6 +353,8 @@ MP4StringProperty::~MP4StringProperty()
 
 void MP4StringProperty::SetCount( uint32_t count )
 {
+   SetModified();
+
    uint32_t oldCount = m_values.Size();
    for (uint32_t i = count; i < oldCount; ++i)
    {
@@ -362,6 +376,7 @@ void MP4StringProperty::SetValue(const char* value, uint32_t index)
         throw new PlatformException(msg.str().c_str(), EACCES, __FILE__, __LINE__, __FUNCTION__ );
     }
 
+    SetModified();
     MP4Free(m_values[index]);
 
     if (m_fixedLength) {
@@ -454,38 +469,38 @@ void MP4StringProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t index
             indexd[0] = '\0';
 
         if( m_useUnicode )
-            log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s%s = %ls",
-                     m_parentAtom.GetFile().GetFilename().c_str(),
-                     m_name, indexd, (wchar_t*)m_values[index] );
+            GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s%s = %ls",
+                          m_parentAtom.GetFile().GetFilename().c_str(),
+                          m_name, indexd, (wchar_t*)m_values[index] );
         else
-            log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s%s = %s",
-                     m_parentAtom.GetFile().GetFilename().c_str(),
-                     m_name, indexd, m_values[index] );
+            GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s%s = %s",
+                          m_parentAtom.GetFile().GetFilename().c_str(),
+                          m_name, indexd, m_values[index] );
     }
-    else if( log.verbosity >= MP4_LOG_VERBOSE2 )
+    else if( GetLog().verbosity >= MP4_LOG_VERBOSE2 )
     {
         const uint32_t max = GetCount();
 
-        log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s (size=%u)",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, max );
+        GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s (size=%u)",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, max );
 
         for( uint32_t i = 0; i < max; i++ ) {
             char*& value = m_values[i];
 
             if( m_useUnicode )
-                log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s[%u] = %ls",
-                         m_parentAtom.GetFile().GetFilename().c_str(),
-                         m_name, i, (wchar_t*)value );
+                GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s[%u] = %ls",
+                              m_parentAtom.GetFile().GetFilename().c_str(),
+                              m_name, i, (wchar_t*)value );
             else
-                log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s[%u] = %s",
-                         m_parentAtom.GetFile().GetFilename().c_str(),
-                         m_name, i, value );
+                GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s[%u] = %s",
+                              m_parentAtom.GetFile().GetFilename().c_str(),
+                              m_name, i, value );
         }
     }
     else {
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": <table entries suppressed>",
-                 m_parentAtom.GetFile().GetFilename().c_str() );
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": <table entries suppressed>",
+                      m_parentAtom.GetFile().GetFilename().c_str() );
     }
 }
 
@@ -496,6 +511,8 @@ MP4BytesProperty::MP4BytesProperty(MP4Atom& parentAtom, const char* name, uint32
         : MP4Property(parentAtom, name)
         , m_fixedValueSize(0)
         , m_defaultValueSize(defaultValueSize)
+        , m_deferred(false)
+        , m_deferredOffset(0)
 {
     SetCount(1);
     m_values[0] = (uint8_t*)MP4Calloc(valueSize);
@@ -512,6 +529,9 @@ MP4BytesProperty::~MP4BytesProperty()
 
 void MP4BytesProperty::SetCount(uint32_t count)
 {
+   if (m_deferred) Load();
+   SetModified();
+
    uint32_t oldCount = m_values.Size();
    for ( uint32_t i = count; i < oldCount; ++i )
    {
@@ -527,6 +547,23 @@ void MP4BytesProperty::SetCount(uint32_t count)
     }
 }
 
+void MP4BytesProperty::CopyValueRange(uint8_t* pValue, uint32_t offset, uint32_t size,
+                                      uint32_t index)
+{
+    if (offset > m_valueSizes[index] || size > m_valueSizes[index] - offset) {
+        ostringstream msg;
+        msg << GetParentAtom().GetType() << "." << GetName() << " range " << offset << "+" << size << " exceeds value size " << m_valueSizes[index];
+        throw new Exception(msg.str().c_str(), __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    if (!(m_deferred && index == 0)) {
+        memcpy(pValue, m_values[index] + offset, size);
+        return;
+    }
+
+    m_parentAtom.GetFile().ReadBytesAt(m_deferredOffset + offset, pValue, size);
+}
+
 void MP4BytesProperty::SetValue(const uint8_t* pValue, uint32_t valueSize,
                                 uint32_t index)
 {
@@ -535,6 +572,12 @@ void MP4BytesProperty::SetValue(const uint8_t* pValue, uint32_t valueSize,
         msg << "property " << m_name << "is read-only";
         throw new PlatformException(msg.str().c_str(), EACCES, __FILE__, __LINE__, __FUNCTION__ );
     }
+    if (m_deferred && index == 0) {
+        // the stored value is replaced, there is no need to load it
+        m_deferred = false;
+        m_values[0] = (uint8_t*)MP4Calloc(m_valueSizes[0]);
+    }
+    SetModified();
     if (m_fixedValueSize) {
         if (valueSize > m_fixedValueSize) {
             ostringstream msg;
@@ -567,6 +610,8 @@ void MP4BytesProperty::SetValueSize(uint32_t valueSize, uint32_t index)
         throw new Exception("can't change size of fixed sized property",
                             __FILE__, __LINE__, __FUNCTION__ );
     }
+    if (m_deferred) Load();
+    SetModified();
     if (m_values[index] != NULL) {
         m_values[index] = (uint8_t*)MP4Realloc(m_values[index], valueSize);
     }
@@ -575,6 +620,8 @@ void MP4BytesProperty::SetValueSize(uint32_t valueSize, uint32_t index)
 
 void MP4BytesProperty::SetFixedSize(uint32_t fixedSize)
 {
+    if (m_deferred) Load();
+    SetModified();
     m_fixedValueSize = 0;
     for (uint32_t i = 0; i < GetCount(); i++) {
         SetValueSize(fixedSize, i);
@@ -587,16 +634,44 @@ void MP4BytesProperty::Read(MP4File& file, uint32_t index)
     if (m_implicit) {
         return;
     }
+    if (index == 0) {
+        m_deferred = false;
+    }
     MP4Free(m_values[index]);
     m_values[index] = (uint8_t*)MP4Malloc(m_valueSizes[index]);
     file.ReadBytes(m_values[index], m_valueSizes[index]);
 }
 
+void MP4BytesProperty::Defer(uint64_t offset)
+{
+    ASSERT(GetCount() == 1);
+    MP4Free(m_values[0]);
+    m_values[0] = NULL;
+    m_deferred = true;
+    m_deferredOffset = offset;
+}
+
+void MP4BytesProperty::Load()
+{
+    uint8_t* value = (uint8_t*)MP4Malloc(m_valueSizes[0]);
+    try {
+        m_parentAtom.GetFile().ReadBytesAt(m_deferredOffset, value, m_valueSizes[0]);
+    }
+    catch (...) {
+        MP4Free(value);
+        throw;
+    }
+
+    m_values[0] = value;
+    m_deferred = false;
+}
+
 void MP4BytesProperty::Write(MP4File& file, uint32_t index)
 {
     if (m_implicit) {
         return;
     }
+    if (m_deferred) Load();
     file.WriteBytes(m_values[index], m_valueSizes[index]);
 }
 
@@ -606,13 +681,15 @@ void MP4BytesProperty::Dump(uint8_t indent,
     if( m_implicit && !dumpImplicits )
         return;
 
+    if( m_deferred ) Load();
+
     const uint32_t size  = m_valueSizes[index];
     const uint8_t* const value = m_values[index];
 
     if( size == 0 ) {
-        log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, size );
+        GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, size );
         return;
     }
 
@@ -630,9 +707,9 @@ void MP4BytesProperty::Dump(uint8_t indent,
 
         oss << "  |" << text.str() << "|";
 
-        log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>%s",
-                 m_parentAtom.GetFile().GetFilename().c_str(),
-                 m_name, size, oss.str().c_str() );
+        GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>%s",
+                      m_parentAtom.GetFile().GetFilename().c_str(),
+                      m_name, size, oss.str().c_str() );
         return;
     }
 
@@ -651,7 +728,7 @@ void MP4BytesProperty::Dump(uint8_t indent,
     bool supressed;
 
     if( showall ||
-        size < 128 || log.verbosity >= MP4_LOG_VERBOSE2 )
+        size < 128 || GetLog().verbosity >= MP4_LOG_VERBOSE2 )
     {
         adjsize = size;
         supressed = false;
@@ -664,16 +741,16 @@ void MP4BytesProperty::Dump(uint8_t indent,
     ostringstream oss;
     ostringstream text;
 
-    log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>",
-             m_parentAtom.GetFile().GetFilename().c_str(),
-             m_name, size );
-    log.hexDump(indent, MP4_LOG_VERBOSE2, value, adjsize, "\"%s\": %s",
-                m_parentAtom.GetFile().GetFilename().c_str(),
-                m_name);
+    GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = <%u bytes>",
+                  m_parentAtom.GetFile().GetFilename().c_str(),
+                  m_name, size );
+    GetLog().hexDump(indent, MP4_LOG_VERBOSE2, value, adjsize, "\"%s\": %s",
+                     m_parentAtom.GetFile().GetFilename().c_str(),
+                     m_name);
 
     if( supressed ) {
-        log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": <remaining bytes supressed>",
-                 m_parentAtom.GetFile().GetFilename().c_str() );
+        GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": <remaining bytes supressed>",
+                      m_parentAtom.GetFile().GetFilename().c_str() );
     }
 }
 
@@ -724,8 +801,8 @@ bool MP4TableProperty::FindProperty(const char *name,
         }
     }
     
-    log.verbose1f("\"%s\": FindProperty: matched %s", 
-                  m_parentAtom.GetFile().GetFilename().c_str(), name);
+    GetLog().verbose1f("\"%s\": FindProperty: matched %s", 
+                       m_parentAtom.GetFile().GetFilename().c_str(), name);
 
     // get name of table property
     const char *tablePropName = MP4NameAfterFirst(name);
@@ -889,11 +966,11 @@ void MP4TableProperty::Write(MP4File& file, uint32_t index)
     uint32_t numEntries = GetCount();
 
     if (m_pProperties[0]->GetCount() != numEntries) {
-        log.errorf("%s: \"%s\": %s %s \"%s\"table entries %u doesn't match count %u",
-                   __FUNCTION__, m_parentAtom.GetFile().GetFilename().c_str(),
-                   GetParentAtom().GetType(),
-                   GetName(), m_pProperties[0]->GetName(),
-                   m_pProperties[0]->GetCount(), numEntries);
+        GetLog().errorf("%s: \"%s\": %s %s \"%s\"table entries %u doesn't match count %u",
+                        __FUNCTION__, m_parentAtom.GetFile().GetFilename().c_str(),
+                        GetParentAtom().GetType(),
+                        GetName(), m_pProperties[0]->GetName(),
+                        m_pProperties[0]->GetCount(), numEntries);
 
         ASSERT(m_pProperties[0]->GetCount() == numEntries);
     }
@@ -963,6 +1040,7 @@ MP4Descriptor* MP4DescriptorProperty::AddDescriptor(uint8_t tag)
     MP4Descriptor* pDescriptor = CreateDescriptor(m_parentAtom, tag);
     ASSERT(pDescriptor);
 
+    SetModified();
     m_pDescriptors.Add(pDescriptor);
 
     return pDescriptor;
@@ -970,6 +1048,7 @@ MP4Descriptor* MP4DescriptorProperty::AddDescriptor(uint8_t tag)
 
 void MP4DescriptorProperty::DeleteDescriptor(uint32_t index)
 {
+    SetModified();
     delete m_pDescriptors[index];
     m_pDescriptors.Delete(index);
 }
@@ -1006,9 +1085,9 @@ bool MP4DescriptorProperty::FindProperty(const char *name,
         return false;
     }
 
-    log.verbose1f("\"%s\": matched %s",
-                  m_parentAtom.GetFile().GetFilename().c_str(),
-                  name);
+    GetLog().verbose1f("\"%s\": matched %s",
+                       m_parentAtom.GetFile().GetFilename().c_str(),
+                       name);
 
     // get name of descriptor property
     name = MP4NameAfterFirst(name);
@@ -1082,11 +1161,11 @@ void MP4DescriptorProperty::Read(MP4File& file, uint32_t index)
 
     // warnings
     if (m_mandatory && m_pDescriptors.Size() == 0) {
-        log.warningf("%s: \"%s\": Mandatory descriptor 0x%02x missing",
-                     __FUNCTION__, GetParentAtom().GetFile().GetFilename().c_str(), m_tagsStart);
+        GetLog().warningf("%s: \"%s\": Mandatory descriptor 0x%02x missing",
+                          __FUNCTION__, GetParentAtom().GetFile().GetFilename().c_str(), m_tagsStart);
     } else if (m_onlyOne && m_pDescriptors.Size() > 1) {
-        log.warningf("%s: \"%s\": Descriptor 0x%02x has more than one instance",
-                     __FUNCTION__, GetParentAtom().GetFile().GetFilename().c_str(), m_tagsStart);
+        GetLog().warningf("%s: \"%s\": Descriptor 0x%02x has more than one instance",
+                          __FUNCTION__, GetParentAtom().GetFile().GetFilename().c_str(), m_tagsStart);
     }
 }
 
@@ -1114,13 +1193,13 @@ void MP4DescriptorProperty::Dump(uint8_t indent,
 
     if (m_name) {
         if (index != 0)
-            log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u]",
-                     m_parentAtom.GetFile().GetFilename().c_str(),
-                     m_name, index);
+            GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s[%u]",
+                          m_parentAtom.GetFile().GetFilename().c_str(),
+                          m_name, index);
         else
-            log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s",
-                     m_parentAtom.GetFile().GetFilename().c_str(),
-                     m_name);
+            GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s",
+                          m_parentAtom.GetFile().GetFilename().c_str(),
+                          m_name);
         indent++;
     }
 
@@ -1156,9 +1235,9 @@ MP4LanguageCodeProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t inde
              | (((svalue[2] - 0x60) & 0x001f)      );
     }
 
-    log.dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = %s (0x%04x)",
-             m_parentAtom.GetFile().GetFilename().c_str(),
-             m_name, bmff::enumLanguageCode.toString( _value, true ).c_str(), data );
+    GetLog().dump(indent, MP4_LOG_VERBOSE2, "\"%s\": %s = %s (0x%04x)",
+                  m_parentAtom.GetFile().GetFilename().c_str(),
+                  m_name, bmff::enumLanguageCode.toString( _value, true ).c_str(), data );
 }
 
 uint32_t
@@ -1201,6 +1280,7 @@ MP4LanguageCodeProperty::SetCount( uint32_t count )
 void
 MP4LanguageCodeProperty::SetValue( bmff::LanguageCode value )
 {
+    SetModified();
     _value = value;
 }
 
@@ -1231,9 +1311,9 @@ MP4BasicTypeProperty::MP4BasicTypeProperty( MP4Atom& parentAtom, const char* nam
 void
 MP4BasicTypeProperty::Dump( uint8_t indent, bool dumpImplicits, uint32_t index )
 {
-    log.dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %s (0x%02x)",
-             m_parentAtom.GetFile().GetFilename().c_str(), m_name,
-             itmf::enumBasicType.toString( _value, true ).c_str(), _value );
+    GetLog().dump(indent, MP4_LOG_VERBOSE1, "\"%s\": %s = %s (0x%02x)",
+                  m_parentAtom.GetFile().GetFilename().c_str(), m_name,
+                  itmf::enumBasicType.toString( _value, true ).c_str(), _value );
 }
 
 uint32_t
@@ -1269,6 +1349,7 @@ MP4BasicTypeProperty::SetCount( uint32_t count )
 void
 MP4BasicTypeProperty::SetValue( itmf::BasicType value )
 {
+    SetModified();
     _value = value;
 }
 
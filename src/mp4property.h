@@ -92,6 +92,12 @@ public:
     virtual bool FindProperty(const char* name,
                               MP4Property** ppProperty, uint32_t* pIndex = NULL);
 
+protected:
+    Log& GetLog(); // of the file the property belongs to
+
+    // values are about to change, see MP4Atom::IsModified()
+    void SetModified();
+
 protected:
     MP4Atom& m_parentAtom;
     const char* m_name;
@@ -145,6 +151,7 @@ private:
             return m_values.Size(); \
         } \
         void SetCount(uint32_t count) { \
+            SetModified(); \
             m_values.Resize(count); \
         } \
         \
@@ -158,18 +165,23 @@ private:
                 msg << "property is read-only: " << m_name; \
                 throw new PlatformException(msg.str().c_str(), EACCES, __FILE__, __LINE__, __FUNCTION__); \
             } \
+            SetModified(); \
             m_values[index] = value; \
         } \
         void AddValue(uint##isize##_t value) { \
+            SetModified(); \
             m_values.Add(value); \
         } \
         void InsertValue(uint##isize##_t value, uint32_t index) { \
+            SetModified(); \
             m_values.Insert(value, index); \
         } \
         void DeleteValue(uint32_t index) { \
+            SetModified(); \
             m_values.Delete(index); \
         } \
         void IncrementValue(int32_t increment = 1, uint32_t index = 0) { \
+            SetModified(); \
             m_values[index] += increment; \
         } \
         void Read(MP4File& file, uint32_t index = 0) { \
@@ -218,6 +230,7 @@ public:
         return m_numBits;
     }
     void SetNumBits(uint8_t numBits) {
+        SetModified();
         m_numBits = numBits;
     }
 
@@ -253,6 +266,7 @@ public:
         return m_values.Size();
     }
     void SetCount(uint32_t count) {
+        SetModified();
         m_values.Resize(count);
     }
 
@@ -266,14 +280,17 @@ public:
             msg << "property is read-only: " << m_name;
             throw new PlatformException(msg.str().c_str(), EACCES, __FILE__, __LINE__, __FUNCTION__);
         }
+        SetModified();
         m_values[index] = value;
     }
 
     void AddValue(float value) {
+        SetModified();
         m_values.Add(value);
     }
 
     void InsertValue(float value, uint32_t index) {
+        SetModified();
         m_values.Insert(value, index);
     }
 
@@ -282,6 +299,7 @@ public:
     }
 
     void SetFixed16Format(bool useFixed16Format = true) {
+        SetModified();
         m_useFixed16Format = useFixed16Format;
     }
 
@@ -290,6 +308,7 @@ public:
     }
 
     void SetFixed32Format(bool useFixed32Format = true) {
+        SetModified();
         m_useFixed32Format = useFixed32Format;
     }
 
@@ -343,6 +362,7 @@ public:
     }
 
     void SetCountedFormat(bool useCountedFormat) {
+        SetModified();
         m_useCountedFormat = useCountedFormat;
     }
 
@@ -351,6 +371,7 @@ public:
     }
 
     void SetExpandedCountedFormat(bool useExpandedCount) {
+        SetModified();
         m_useExpandedCount = useExpandedCount;
     }
 
@@ -359,6 +380,7 @@ public:
     }
 
     void SetUnicode(bool useUnicode) {
+        SetModified();
         m_useUnicode = useUnicode;
     }
 
@@ -367,6 +389,7 @@ public:
     }
 
     void SetFixedLength(uint32_t fixedLength) {
+        SetModified();
         m_fixedLength = fixedLength;
     }
 
@@ -409,6 +432,7 @@ public:
 
     void GetValue(uint8_t** ppValue, uint32_t* pValueSize,
                   uint32_t index = 0) {
+        if (m_deferred) Load();
         // N.B. caller must free memory
         *ppValue = (uint8_t*)MP4Malloc(m_valueSizes[index]);
         memcpy(*ppValue, m_values[index], m_valueSizes[index]);
@@ -416,6 +440,7 @@ public:
     }
 
     char* GetValueStringAlloc( uint32_t index = 0 ) {
+        if (m_deferred) Load();
         char* buf = (char*)MP4Malloc( m_valueSizes[index] + 1 );
         memcpy( buf, m_values[index], m_valueSizes[index] );
         buf[m_valueSizes[index]] = '\0';
@@ -423,15 +448,22 @@ public:
     }
 
     bool CompareToString( const string& s, uint32_t index = 0 ) {
+        if (m_deferred) Load();
         return string( (const char*)m_values[index], m_valueSizes[index] ) != s;
     }
 
     void CopyValue(uint8_t* pValue, uint32_t index = 0) {
         // N.B. caller takes responsbility for valid pointer
         // and sufficient memory at the destination
+        if (m_deferred) Load();
         memcpy(pValue, m_values[index], m_valueSizes[index]);
     }
 
+    // copy size bytes starting at offset, a deferred value is read
+    // straight from the file and stays deferred
+    void CopyValueRange(uint8_t* pValue, uint32_t offset, uint32_t size,
+                        uint32_t index = 0);
+
     void SetValue(const uint8_t* pValue, uint32_t valueSize,
                   uint32_t index = 0);
 
@@ -453,16 +485,33 @@ public:
 
     void SetFixedSize(uint32_t fixedSize);
 
+    // leave the value of a single valued property in the file, starting at
+    // offset, until it is first accessed. GetValueSize() does not load it.
+    void Defer(uint64_t offset);
+
+    bool IsDeferred() {
+        return m_deferred;
+    }
+
+    uint64_t GetDeferredOffset() {
+        return m_deferredOffset;
+    }
+
     void Read(MP4File& file, uint32_t index = 0);
     void Write(MP4File& file, uint32_t index = 0);
     void Dump(uint8_t indent,
               bool dumpImplicits, uint32_t index = 0);
 
+protected:
+    void Load();
+
 protected:
     uint32_t        m_fixedValueSize;
     uint32_t        m_defaultValueSize;
     MP4Integer32Array   m_valueSizes;
     MP4BytesArray       m_values;
+    bool            m_deferred;
+    uint64_t        m_deferredOffset;
 
 private:
     MP4BytesProperty();
@@ -543,6 +592,7 @@ public:
         return m_pDescriptors.Size();
     }
     void SetCount(uint32_t count) {
+        SetModified();
         m_pDescriptors.Resize(count);
     }
 
@@ -554,6 +604,7 @@ public:
     MP4Descriptor* AddDescriptor(uint8_t tag);
 
     void AppendDescriptor(MP4Descriptor* pDescriptor) {
+        SetModified();
         m_pDescriptors.Add(pDescriptor);
     }
 
@@ -0,0 +1,158 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "src/impl.h"
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+
+MP4SampleCursor::MP4SampleCursor( MP4Track& track, bool applyEdits )
+    : m_track        ( track )
+    , m_numSamples   ( track.GetNumberOfSamples() )
+    , m_numStts      ( track.m_pSttsCountProperty->GetValue() )
+    , m_numEdits     ( 0 )
+    , m_editIndex    ( 0 )
+    , m_editStart    ( 0 )
+    , m_editWhen     ( 0 )
+    , m_editSampleId ( MP4_INVALID_SAMPLE_ID )
+{
+    if( applyEdits && track.m_pElstCountProperty )
+        m_numEdits = track.m_pElstCountProperty->GetValue();
+
+    Rewind();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool MP4SampleCursor::Next( MP4SampleId& sampleId, MP4Timestamp& startTime, MP4Duration& duration )
+{
+    if( !m_numEdits ) {
+        if( !NextMediaSample() )
+            return false;
+
+        sampleId  = m_sampleId;
+        startTime = m_sampleStart;
+        duration  = m_sampleDuration;
+        return true;
+    }
+
+    while( m_editIndex < m_numEdits ) {
+        const MP4Duration editDuration = m_track.m_pElstDurationProperty->GetValue( m_editIndex );
+        const MP4Timestamp editEnd = m_editStart + editDuration;
+
+        // the edit time and the media time of this edit advance in lockstep,
+        // the media side only has to move back when a new edit starts earlier
+        MP4Duration editOffset = m_editWhen - m_editStart;
+        if( m_editWhen >= editEnd || IsEmptyEdit( m_editIndex ) ||
+            !SeekMediaSample( m_track.m_pElstMediaTimeProperty->GetValue( m_editIndex ) + editOffset,
+                              m_editSampleId + 1 ))
+        {
+            m_editIndex++;
+            m_editStart    = editEnd;
+            m_editWhen     = max( m_editWhen, editEnd );
+            m_editSampleId = MP4_INVALID_SAMPLE_ID;
+            continue;
+        }
+
+        // from here on as in MP4Track::GetSampleIdFromEditTime()
+        const MP4Timestamp mediaWhen = m_track.m_pElstMediaTimeProperty->GetValue( m_editIndex ) + editOffset;
+        const MP4Duration sampleStartOffset = mediaWhen - m_sampleStart;
+        const MP4Timestamp editSampleStartTime = m_editWhen - min( editOffset, sampleStartOffset );
+
+        MP4Duration editSampleDuration;
+        if( m_track.m_pElstRateProperty->GetValue( m_editIndex ) == 0 ) {
+            // a "dwell", the sample lasts as long as the edit
+            editSampleDuration = editDuration;
+        }
+        else {
+            editSampleDuration = m_sampleDuration;
+
+            if( editOffset < sampleStartOffset )
+                editSampleDuration -= sampleStartOffset - editOffset;
+
+            if( editEnd < editSampleStartTime + m_sampleDuration )
+                editSampleDuration -= ( editSampleStartTime + m_sampleDuration ) - editEnd;
+        }
+
+        sampleId  = m_sampleId;
+        startTime = editSampleStartTime;
+        duration  = editSampleDuration;
+
+        m_editSampleId = m_sampleId;
+        m_editWhen += editSampleDuration;
+        return true;
+    }
+
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void MP4SampleCursor::Rewind()
+{
+    m_sampleId       = MP4_INVALID_SAMPLE_ID;
+    m_sampleStart    = 0;
+    m_sampleDuration = 0;
+    m_sttsIndex      = 0;
+    m_sttsLeft       = 0;
+}
+
+bool MP4SampleCursor::NextMediaSample()
+{
+    if( m_sampleId >= m_numSamples )
+        return false;
+
+    while( m_sttsLeft == 0 ) {
+        if( m_sttsIndex >= m_numStts )
+            throw new Exception( "stts does not cover all samples", __FILE__, __LINE__, __FUNCTION__ );
+        m_sttsLeft = m_track.m_pSttsSampleCountProperty->GetValue( m_sttsIndex++ );
+    }
+
+    m_sampleStart   += m_sampleDuration;
+    m_sampleDuration = m_track.m_pSttsSampleDeltaProperty->GetValue( m_sttsIndex - 1 );
+    m_sttsLeft--;
+    m_sampleId++;
+    return true;
+}
+
+bool MP4SampleCursor::SeekMediaSample( MP4Timestamp mediaWhen, MP4SampleId minSampleId )
+{
+    if( m_sampleId != MP4_INVALID_SAMPLE_ID && mediaWhen < m_sampleStart )
+        Rewind();
+
+    // a sample ending right at mediaWhen is passed over, like
+    // MP4Track::GetSampleIdFromTime() does
+    while( m_sampleId < minSampleId || mediaWhen >= m_sampleStart + m_sampleDuration ) {
+        if( !NextMediaSample() )
+            return false;
+    }
+
+    return true;
+}
+
+bool MP4SampleCursor::IsEmptyEdit( uint32_t editIndex )
+{
+    // media time -1 in either the 32-bit or 64-bit elst layout
+    const uint64_t mediaTime = m_track.m_pElstMediaTimeProperty->GetValue( editIndex );
+    if( m_track.m_pElstMediaTimeProperty->GetType() == Integer32Property )
+        return mediaTime == 0xFFFFFFFF;
+    return mediaTime == (uint64_t)-1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
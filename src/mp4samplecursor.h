@@ -0,0 +1,80 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MP4V2_IMPL_MP4SAMPLECURSOR_H
+#define MP4V2_IMPL_MP4SAMPLECURSOR_H
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Sequential walk over the samples of a track in presentation order.
+///
+/// Each step yields what MP4Track::GetSampleIdFromEditTime() would return
+/// for the current edit time, but edits and the stts table are followed
+/// together in a single pass instead of being searched from the start for
+/// every sample. Without an edit list (or with edits not applied) the
+/// samples are simply returned in decoding order with their media times.
+///
+/// Empty edits are skipped and an edit reaching past the last sample ends
+/// early. The track must neither be written to nor deleted while a cursor
+/// on it is in use.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+class MP4SampleCursor
+{
+public:
+    MP4SampleCursor( MP4Track& track, bool applyEdits );
+
+    bool Next( MP4SampleId& sampleId, MP4Timestamp& startTime, MP4Duration& duration );
+
+private:
+    void Rewind();
+    bool NextMediaSample();
+    bool SeekMediaSample( MP4Timestamp mediaWhen, MP4SampleId minSampleId );
+    bool IsEmptyEdit( uint32_t editIndex );
+
+private:
+    MP4Track&    m_track;
+    uint32_t     m_numSamples;
+    uint32_t     m_numStts;
+    uint32_t     m_numEdits;    // 0 if edits are not applied
+
+    // media timeline, m_sampleId is 0 before the first sample
+    MP4SampleId  m_sampleId;
+    MP4Timestamp m_sampleStart;
+    MP4Duration  m_sampleDuration;
+    uint32_t     m_sttsIndex;   // next stts entry to be entered
+    uint32_t     m_sttsLeft;    // samples left in the current stts entry
+
+    // edit timeline
+    uint32_t     m_editIndex;
+    MP4Timestamp m_editStart;
+    MP4Timestamp m_editWhen;
+    MP4SampleId  m_editSampleId; // last sample returned for this edit
+
+private:
+    MP4SampleCursor();
+    MP4SampleCursor( const MP4SampleCursor &src );
+    MP4SampleCursor &operator= ( const MP4SampleCursor &src );
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
+
+#endif // MP4V2_IMPL_MP4SAMPLECURSOR_H
@@ -41,9 +41,6 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
     : m_File(file)
     , m_trakAtom(trakAtom)
 {
-    m_lastStsdIndex = 0;
-    m_lastSampleFile = NULL;
-
     m_cachedReadSampleId = MP4_INVALID_SAMPLE_ID;
     m_pCachedReadSample = NULL;
     m_cachedReadSampleSize = 0;
@@ -52,9 +49,11 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
     m_fixedSampleDuration = 0;
     m_pChunkBuffer = NULL;
     m_chunkBufferSize = 0;
+    m_chunkBufferUsed = 0;
     m_sizeOfDataInChunkBuffer = 0;
     m_chunkSamples = 0;
     m_chunkDuration = 0;
+    m_referenceOffset = 0;
 
     // m_bytesPerSample should be set to 1, except for the
     // quicktime audio constant bit rate samples, which have non-1 values
@@ -236,10 +235,12 @@ MP4Track::MP4Track(MP4File& file, MP4Atom& trakAtom)
     }
     CalculateBytesPerSample();
 
-    // update sdtp log from sdtp atom
+    // update sdtp log from sdtp atom, unless the caller's filter skipped
+    // it; its data property then has a size but no bytes
     MP4Atom* atom = m_trakAtom.FindAtom( "trak.mdia.minf.stbl.sdtp" );
     MP4SdtpAtom* sdtp = dynamic_cast<MP4SdtpAtom *>( atom );  
-    if ( sdtp != nullptr )
+    ShouldParseAtomCallback shouldParse = m_File.GetShouldParseAtomCallback();
+    if ( sdtp != nullptr && ( shouldParse == nullptr || shouldParse( ATOMID( "sdtp" ))))
     {
        uint8_t* buffer;
        uint32_t bufsize;
@@ -255,6 +256,8 @@ MP4Track::~MP4Track()
     m_pCachedReadSample = NULL;
     MP4Free(m_pChunkBuffer);
     m_pChunkBuffer = NULL;
+    ReleaseChunkSegments();
+    CloseSampleFiles();
 }
 
 const char* MP4Track::GetType()
@@ -297,7 +300,7 @@ void MP4Track::ReadSample(
 
     // handle unusual case of wanting to read a sample
     // that is still sitting in the write chunk buffer
-    if (m_pChunkBuffer && sampleId >= m_writeSampleId - m_chunkSamples) {
+    if (m_chunkSamples && sampleId >= m_writeSampleId - m_chunkSamples) {
         WriteChunkBuffer();
     }
 
@@ -314,8 +317,12 @@ void MP4Track::ReadSample(
     }
     *pNumBytes = sampleSize;
 
-    log.verbose3f("\"%s\": ReadSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
-                  GetFile().GetFilename().c_str(), m_trackId, sampleId, fileOffset, *pNumBytes, *pNumBytes);
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_READ, m_trackId, sampleId,
+                      "\"%s\": ReadSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+                      GetFile().GetFilename().c_str(), m_trackId, sampleId, fileOffset, *pNumBytes, *pNumBytes);
+
+    TraceSpan span("read", "ReadSample", (MP4FileHandle)&m_File);
+    MP4File::StatsTimer timer(m_File, m_File.GetStats().sampleIoMicroseconds);
 
     bool bufferMalloc = false;
     if (*ppBytes == NULL) {
@@ -331,21 +338,24 @@ void MP4Track::ReadSample(
         if (pStartTime || pDuration) {
             GetSampleTimes(sampleId, pStartTime, pDuration);
 
-            log.verbose3f("\"%s\": ReadSample:  start %" PRIu64 " duration %" PRId64,
-                          GetFile().GetFilename().c_str(), (pStartTime ? *pStartTime : 0),
-                          (pDuration ? *pDuration : 0));
+            MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_READ, m_trackId, sampleId,
+                              "\"%s\": ReadSample:  start %" PRIu64 " duration %" PRId64,
+                              GetFile().GetFilename().c_str(), (pStartTime ? *pStartTime : 0),
+                              (pDuration ? *pDuration : 0));
         }
         if (pRenderingOffset) {
             *pRenderingOffset = GetSampleRenderingOffset(sampleId);
 
-            log.verbose3f("\"%s\": ReadSample:  renderingOffset %" PRId64,
-                          GetFile().GetFilename().c_str(), *pRenderingOffset);
+            MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_READ, m_trackId, sampleId,
+                              "\"%s\": ReadSample:  renderingOffset %" PRId64,
+                              GetFile().GetFilename().c_str(), *pRenderingOffset);
         }
         if (pIsSyncSample) {
             *pIsSyncSample = IsSyncSample(sampleId);
 
-            log.verbose3f("\"%s\": ReadSample:  isSyncSample %u",
-                          GetFile().GetFilename().c_str(), *pIsSyncSample);
+            MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_READ, m_trackId, sampleId,
+                              "\"%s\": ReadSample:  isSyncSample %u",
+                              GetFile().GetFilename().c_str(), *pIsSyncSample);
         }
     }
 
@@ -365,6 +375,116 @@ void MP4Track::ReadSample(
         m_File.SetPosition( oldPos, fin );
 }
 
+void MP4Track::ReadAllSamples(
+    vector<uint8_t>&  data,
+    vector<uint32_t>& sizes )
+{
+    // samples still sitting in the write chunk buffer have no offset yet
+    if (m_chunkSamples) {
+        WriteChunkBuffer();
+    }
+
+    const uint32_t numSamples = GetNumberOfSamples();
+    const uint32_t numChunks = GetNumberOfChunks();
+    const uint32_t numStscs = m_pStscCountProperty->GetValue();
+
+    sizes.resize(numSamples);
+    uint64_t totalSize = 0;
+    for (MP4SampleId sampleId = 1; sampleId <= numSamples; sampleId++) {
+        sizes[sampleId - 1] = GetSampleSize(sampleId);
+        totalSize += sizes[sampleId - 1];
+    }
+    if (totalSize > numeric_limits<uint32_t>::max()) {
+        throw new Exception("track too large to be read at once",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+    data.resize((size_t)totalSize);
+
+    TraceSpan span("read", "ReadAllSamples", (MP4FileHandle)&m_File);
+    MP4File::StatsTimer timer(m_File, m_File.GetStats().sampleIoMicroseconds);
+
+    // pending run of back to back bytes, read once it can't grow anymore
+    File*    runFile = NULL;
+    uint64_t runOffset = 0;
+    uint32_t runSize = 0;
+    uint32_t runDataPos = 0;
+
+    MP4SampleId sampleId = 1;
+    uint32_t dataPos = 0;
+
+    for (uint32_t stscIndex = 0; stscIndex < numStscs && sampleId <= numSamples; stscIndex++) {
+        const uint32_t samplesPerChunk = m_pStscSamplesPerChunkProperty->GetValue(stscIndex);
+        if (samplesPerChunk == 0u) {
+            throw new Exception("Invalid number of samples in stsc entry",
+                                __FILE__, __LINE__, __FUNCTION__ );
+        }
+
+        const MP4ChunkId firstChunk = m_pStscFirstChunkProperty->GetValue(stscIndex);
+        const MP4ChunkId lastChunk = stscIndex + 1 < numStscs
+            ? m_pStscFirstChunkProperty->GetValue(stscIndex + 1) - 1
+            : numChunks;
+
+        // all chunks of an stsc entry share the sample description
+        File* fin = GetSampleFile(sampleId);
+        if (fin == (File*)-1) {
+            throw new Exception("sample is located in an inaccessible file",
+                                __FILE__, __LINE__, __FUNCTION__ );
+        }
+
+        for (MP4ChunkId chunkId = firstChunk; chunkId <= lastChunk && sampleId <= numSamples; chunkId++) {
+            const uint64_t chunkOffset = GetChunkOffset(chunkId);
+
+            uint32_t chunkSize = 0;
+            for (uint32_t i = 0; i < samplesPerChunk && sampleId <= numSamples; i++, sampleId++) {
+                chunkSize += sizes[sampleId - 1];
+            }
+
+            if (runSize && (fin != runFile || chunkOffset != runOffset + runSize)) {
+                ReadRunBytes(runFile, runOffset, &data[runDataPos], runSize);
+                runSize = 0;
+            }
+            if (!runSize) {
+                runFile = fin;
+                runOffset = chunkOffset;
+                runDataPos = dataPos;
+            }
+            runSize += chunkSize;
+            dataPos += chunkSize;
+        }
+    }
+
+    if (runSize) {
+        ReadRunBytes(runFile, runOffset, &data[runDataPos], runSize);
+    }
+
+    if (sampleId <= numSamples) {
+        throw new Exception("samples not covered by chunk tables",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+}
+
+void MP4Track::ReadRunBytes(File* fin, uint64_t offset, uint8_t* pBytes, uint32_t numBytes)
+{
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_READ, m_trackId, MP4_INVALID_SAMPLE_ID,
+                      "\"%s\": ReadAllSamples: track %u offset 0x%" PRIx64 " size %u (0x%x)",
+                      GetFile().GetFilename().c_str(), m_trackId, offset, numBytes, numBytes);
+
+    uint64_t oldPos = m_File.GetPosition( fin ); // only used in mode == 'w'
+    try {
+        m_File.SetPosition( offset, fin );
+        m_File.ReadBytes( pBytes, numBytes, fin );
+    }
+    catch( Exception* x ) {
+        if( m_File.IsWriteMode() )
+            m_File.SetPosition( oldPos, fin );
+
+        throw x;
+    }
+
+    if( m_File.IsWriteMode() )
+        m_File.SetPosition( oldPos, fin );
+}
+
 void MP4Track::ReadSampleFragment(
     MP4SampleId sampleId,
     uint32_t sampleOffset,
@@ -376,7 +496,11 @@ void MP4Track::ReadSampleFragment(
                             __FILE__, __LINE__, __FUNCTION__ );
     }
 
-    if (sampleId != m_cachedReadSampleId) {
+    if (sampleId == m_cachedReadSampleId) {
+        m_File.GetStats().cacheHits++;
+    } else {
+        m_File.GetStats().cacheMisses++;
+
         MP4Free(m_pCachedReadSample);
         m_pCachedReadSample = NULL;
         m_cachedReadSampleSize = 0;
@@ -404,17 +528,59 @@ void MP4Track::WriteSample(
     MP4Duration    duration,
     MP4Duration    renderingOffset,
     bool           isSyncSample )
+{
+    WriteSampleData( pBytes, numBytes, duration, renderingOffset, isSyncSample,
+                     NULL, NULL, NULL );
+}
+
+void MP4Track::WriteSampleRef(
+    const uint8_t*       pBytes,
+    uint32_t             numBytes,
+    MP4SampleReleaseFunc release,
+    void*                userData,
+    MP4Duration          duration,
+    MP4Duration          renderingOffset,
+    bool                 isSyncSample )
+{
+    bool queued = false;
+    try {
+        WriteSampleData( pBytes, numBytes, duration, renderingOffset, isSyncSample,
+                         &queued, release, userData );
+    }
+    catch( ... ) {
+        // the buffer is ours from here on, give it back if it never got queued
+        if( !queued && release )
+            release( userData, pBytes );
+        throw;
+    }
+}
+
+void MP4Track::WriteSampleData(
+    const uint8_t*       pBytes,
+    uint32_t             numBytes,
+    MP4Duration          duration,
+    MP4Duration          renderingOffset,
+    bool                 isSyncSample,
+    bool*                pQueued,
+    MP4SampleReleaseFunc release,
+    void*                userData )
 {
     uint8_t curMode = 0;
 
-    log.verbose3f("\"%s\": WriteSample: track %u id %u size %u (0x%x) ",
-                  GetFile().GetFilename().c_str(),
-                  m_trackId, m_writeSampleId, numBytes, numBytes);
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_WRITE, m_trackId, m_writeSampleId,
+                      "\"%s\": WriteSample: track %u id %u size %u (0x%x) ",
+                      GetFile().GetFilename().c_str(),
+                      m_trackId, m_writeSampleId, numBytes, numBytes);
 
     if (pBytes == NULL && numBytes > 0) {
         throw new Exception("no sample data", __FILE__, __LINE__, __FUNCTION__ );
     }
 
+    if (!m_dataReference.empty()) {
+        throw new Exception("track refers to samples in another file",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+
     if (m_isAmr == AMR_UNINITIALIZED ) {
         // figure out if this is an AMR audio track
         if (m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.samr") ||
@@ -434,8 +600,9 @@ void MP4Track::WriteSample(
         duration = GetFixedSampleDuration();
     }
 
-    log.verbose3f("\"%s\": duration %" PRIu64, GetFile().GetFilename().c_str(), 
-                  duration);
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_WRITE, m_trackId, m_writeSampleId,
+                      "\"%s\": duration %" PRIu64, GetFile().GetFilename().c_str(),
+                      duration);
 
     if ((m_isAmr == AMR_TRUE) &&
             (m_curMode != curMode)) {
@@ -443,16 +610,46 @@ void MP4Track::WriteSample(
         m_curMode = curMode;
     }
 
-    // append sample bytes to chunk buffer
-    if( m_sizeOfDataInChunkBuffer + numBytes > m_chunkBufferSize ) {
-        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, m_chunkBufferSize + numBytes);
-        if (m_pChunkBuffer == NULL) 
-            return;	
-        
-        m_chunkBufferSize += numBytes;
-    }
+    if (pQueued) {
+        // queue the caller's buffer, it is written as is by WriteChunkBuffer()
+        ChunkSegment segment;
+        segment.pBytes   = pBytes;
+        segment.offset   = 0;
+        segment.numBytes = numBytes;
+        segment.release  = release;
+        segment.userData = userData;
+        m_chunkSegments.push_back(segment);
+        *pQueued = true;
+    } else {
+        // append sample bytes to chunk buffer, growing it geometrically
+        if( m_chunkBufferUsed + numBytes > m_chunkBufferSize ) {
+            uint32_t newSize = 2 * m_chunkBufferSize;
+            if( newSize < m_chunkBufferUsed + numBytes )
+                newSize = m_chunkBufferUsed + numBytes;
+
+            m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, newSize);
+            if (m_pChunkBuffer == NULL)
+                return;
+
+            m_chunkBufferSize = newSize;
+        }
+
+        memcpy(&m_pChunkBuffer[m_chunkBufferUsed], pBytes, numBytes);
 
-    memcpy(&m_pChunkBuffer[m_sizeOfDataInChunkBuffer], pBytes, numBytes);
+        // extend the previous segment when it is also in the chunk buffer
+        if (!m_chunkSegments.empty() && m_chunkSegments.back().pBytes == NULL) {
+            m_chunkSegments.back().numBytes += numBytes;
+        } else {
+            ChunkSegment segment;
+            segment.pBytes   = NULL;
+            segment.offset   = m_chunkBufferUsed;
+            segment.numBytes = numBytes;
+            segment.release  = NULL;
+            segment.userData = NULL;
+            m_chunkSegments.push_back(segment);
+        }
+        m_chunkBufferUsed += numBytes;
+    }
     m_sizeOfDataInChunkBuffer += numBytes;
     m_chunkSamples++;
     m_chunkDuration += duration;
@@ -477,6 +674,104 @@ void MP4Track::WriteSample(
     m_writeSampleId++;
 }
 
+void MP4Track::WriteSamples(
+    const uint8_t*     pBytes,
+    const uint32_t*    sizes,
+    const MP4Duration* durations,
+    uint32_t           numSamples )
+{
+    if (numSamples == 0) {
+        return;
+    }
+
+    if (!m_dataReference.empty()) {
+        throw new Exception("track refers to samples in another file",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    // AMR chunks break at mode changes, which needs a look at every sample
+    if (m_isAmr == AMR_TRUE ||
+            m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.samr") ||
+            m_trakAtom.FindAtom("trak.mdia.minf.stbl.stsd.sawb")) {
+        for (uint32_t i = 0; i < numSamples; i++) {
+            WriteSample(pBytes, sizes[i], durations[i]);
+            pBytes += sizes[i];
+        }
+        return;
+    }
+
+    uint64_t numBytes = 0;
+    MP4Duration totalDuration = 0;
+    vector<MP4Duration> sampleDurations(durations, durations + numSamples);
+    for (uint32_t i = 0; i < numSamples; i++) {
+        if (sampleDurations[i] == MP4_INVALID_DURATION) {
+            sampleDurations[i] = GetFixedSampleDuration();
+        }
+        numBytes += sizes[i];
+        totalDuration += sampleDurations[i];
+    }
+
+    if (numBytes > numeric_limits<uint32_t>::max()) {
+        throw new Exception("samples too large for a single chunk",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+    if (pBytes == NULL && numBytes > 0) {
+        throw new Exception("no sample data", __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_WRITE, m_trackId, m_writeSampleId,
+                      "\"%s\": WriteSamples: track %u id %u count %u size %" PRIu64,
+                      GetFile().GetFilename().c_str(),
+                      m_trackId, m_writeSampleId, numSamples, numBytes);
+
+    // pending samples keep their own chunk
+    WriteChunkBuffer();
+
+    if (numBytes > m_chunkBufferSize) {
+        m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, (uint32_t)numBytes);
+        m_chunkBufferSize = (uint32_t)numBytes;
+    }
+    if (numBytes) {
+        memcpy(m_pChunkBuffer, pBytes, (size_t)numBytes);
+
+        ChunkSegment segment;
+        segment.pBytes   = NULL;
+        segment.offset   = 0;
+        segment.numBytes = (uint32_t)numBytes;
+        segment.release  = NULL;
+        segment.userData = NULL;
+        m_chunkSegments.push_back(segment);
+    }
+    m_chunkBufferUsed = (uint32_t)numBytes;
+    m_sizeOfDataInChunkBuffer = (uint32_t)numBytes;
+    m_chunkSamples = numSamples;
+    m_chunkDuration = totalDuration;
+
+    for (uint32_t i = 0; i < numSamples; i++) {
+        UpdateSampleSizes(m_writeSampleId + i, sizes[i]);
+        UpdateRenderingOffsets(m_writeSampleId + i, 0);
+        UpdateSyncSamples(m_writeSampleId + i, true);
+    }
+
+    for (uint32_t i = 0; i < numSamples; ) {
+        uint32_t run = 1;
+        while (i + run < numSamples && sampleDurations[i + run] == sampleDurations[i]) {
+            run++;
+        }
+        UpdateSampleTimes(sampleDurations[i], run);
+        i += run;
+    }
+
+    // the chunk is recorded against its last sample
+    m_writeSampleId += numSamples - 1;
+    WriteChunkBuffer();
+    m_writeSampleId++;
+
+    UpdateDurations(totalDuration);
+
+    UpdateModificationTimes();
+}
+
 void MP4Track::WriteSampleDependency(
     const uint8_t* pBytes,
     uint32_t       numBytes,
@@ -489,21 +784,154 @@ void MP4Track::WriteSampleDependency(
     WriteSample( pBytes, numBytes, duration, renderingOffset, isSyncSample );
 }
 
+void MP4Track::ReferenceSample(
+    MP4Track&   srcTrack,
+    MP4SampleId srcSampleId,
+    MP4Duration duration )
+{
+    // a reference to a reference is not followed by GetSampleFile()
+    if (srcTrack.GetSampleFile(srcSampleId) != NULL) {
+        throw new Exception("sample is not located in its own file",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    // the reader opens the name as is, so it must not depend on the
+    // current directory of whoever reads the file
+    string name = srcTrack.GetFile().GetFilename();
+    if (FileSystem::pathnameAbsolute(name)) {
+        throw new Exception("cannot resolve path of " + srcTrack.GetFile().GetFilename(),
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+    const string location = (name[0] == '/' ? "file://" : "file:") + name;
+
+    if (m_dataReference.empty()) {
+        if (GetNumberOfSamples()) {
+            throw new Exception("track already has samples of its own",
+                                __FILE__, __LINE__, __FUNCTION__ );
+        }
+        SetDataReference(location);
+    } else if (location != m_dataReference) {
+        throw new Exception("track already refers to another file",
+                            __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    const uint64_t fileOffset = srcTrack.GetSampleFileOffset(srcSampleId);
+    const uint32_t numBytes = srcTrack.GetSampleSize(srcSampleId);
+
+    MP4Duration srcDuration;
+    srcTrack.GetSampleTimes(srcSampleId, NULL, &srcDuration);
+    if (duration == MP4_INVALID_DURATION) {
+        duration = srcDuration;
+    }
+
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_SAMPLE_WRITE, m_trackId, m_writeSampleId,
+                      "\"%s\": ReferenceSample: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+                      GetFile().GetFilename().c_str(),
+                      m_trackId, m_writeSampleId, fileOffset, numBytes, numBytes);
+
+    // samples which follow each other in the source share a chunk, a gap
+    // starts a new one; the source chunking is kept that way
+    if (m_chunkSamples && (fileOffset != m_referenceOffset + m_sizeOfDataInChunkBuffer ||
+                           numBytes > numeric_limits<uint32_t>::max() - m_sizeOfDataInChunkBuffer)) {
+        WriteChunkBuffer();
+    }
+    if (m_chunkSamples == 0) {
+        m_referenceOffset = fileOffset;
+    }
+
+    if (!srcTrack.m_sdtpLog.empty() && srcSampleId <= srcTrack.m_sdtpLog.size()) {
+        m_sdtpLog.push_back(srcTrack.m_sdtpLog[srcSampleId-1]);
+    }
+
+    m_sizeOfDataInChunkBuffer += numBytes;
+    m_chunkSamples++;
+    m_chunkDuration += duration;
+
+    UpdateSampleSizes(m_writeSampleId, numBytes);
+
+    UpdateSampleTimes(duration);
+
+    UpdateRenderingOffsets(m_writeSampleId,
+                           srcTrack.GetSampleRenderingOffset(srcSampleId));
+
+    UpdateSyncSamples(m_writeSampleId, srcTrack.IsSyncSample(srcSampleId));
+
+    // chunks are bounded like those of WriteSample()
+    if (IsChunkFull(m_writeSampleId)) {
+        WriteChunkBuffer();
+    }
+
+    UpdateDurations(duration);
+
+    UpdateModificationTimes();
+
+    m_writeSampleId++;
+}
+
 void MP4Track::WriteChunkBuffer()
 {
     if (m_sizeOfDataInChunkBuffer == 0) {
         return;
     }
 
+    if (m_File.IsModifyInPlace()) {
+        throw new Exception("no sample data can be written to a file opened with MP4_MODIFY_IN_PLACE",
+                            __FILE__, __LINE__, __FUNCTION__);
+    }
+
+    TraceSpan span("write", "WriteChunk", (MP4FileHandle)&m_File);
+    MP4File::StatsTimer timer(m_File, m_File.GetStats().sampleIoMicroseconds);
+
     uint64_t chunkOffset = m_File.GetPosition();
 
-    // write chunk buffer
-    m_File.WriteBytes(m_pChunkBuffer, m_sizeOfDataInChunkBuffer);
+    // write the pending chunk with one gather write, copied samples are
+    // only resolved now because the chunk buffer may have moved
+    const vector<ChunkSegment>::size_type numSegments = m_chunkSegments.size();
+    m_chunkIov.resize(numSegments);
+    for (vector<ChunkSegment>::size_type i = 0; i < numSegments; i++) {
+        const ChunkSegment& segment = m_chunkSegments[i];
+        m_chunkIov[i].buffer = segment.pBytes ? segment.pBytes : &m_pChunkBuffer[segment.offset];
+        m_chunkIov[i].size   = segment.numBytes;
+    }
+
+    if (!m_dataReference.empty()) {
+        // nothing to write, the chunk is where it is in the referenced file
+        chunkOffset = m_referenceOffset;
+    } else if (m_File.IsAsyncWrite()) {
+        // hand the chunk over to the writer thread, including our chunk
+        // buffer if it holds any of it, and start over with a fresh one
+        MP4AsyncWriter::Job* job = new MP4AsyncWriter::Job;
+        job->offset = chunkOffset;
+        job->size = m_sizeOfDataInChunkBuffer;
+        job->pBuffer = NULL;
+        job->segments.swap(m_chunkIov);
+        for (vector<ChunkSegment>::size_type i = 0; i < numSegments; i++) {
+            const ChunkSegment& segment = m_chunkSegments[i];
+            if (segment.release) {
+                MP4AsyncWriter::Release release;
+                release.func = segment.release;
+                release.userData = segment.userData;
+                release.pBytes = segment.pBytes;
+                job->releases.push_back(release);
+            }
+        }
+        m_chunkSegments.clear();
+
+        if (m_chunkBufferUsed) {
+            job->pBuffer = m_pChunkBuffer;
+            m_pChunkBuffer = (uint8_t*)MP4Malloc(m_chunkBufferSize);
+        }
+
+        m_File.WriteChunkAsync(job);
+    } else {
+        m_File.WriteBytesv(&m_chunkIov[0], (uint32_t)numSegments);
+    }
 
-    log.verbose3f("\"%s\": WriteChunk: track %u offset 0x%" PRIx64 " size %u (0x%x) numSamples %u",
-                  GetFile().GetFilename().c_str(), 
-                  m_trackId, chunkOffset, m_sizeOfDataInChunkBuffer,
-                  m_sizeOfDataInChunkBuffer, m_chunkSamples);
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_CHUNK_WRITE, m_trackId, MP4_INVALID_SAMPLE_ID,
+                      "\"%s\": WriteChunk: track %u offset 0x%" PRIx64 " size %u (0x%x) numSamples %u",
+                      GetFile().GetFilename().c_str(),
+                      m_trackId, chunkOffset, m_sizeOfDataInChunkBuffer,
+                      m_sizeOfDataInChunkBuffer, m_chunkSamples);
 
     UpdateSampleToChunk(m_writeSampleId,
                         m_pChunkCountProperty->GetValue() + 1,
@@ -511,16 +939,37 @@ void MP4Track::WriteChunkBuffer()
 
     UpdateChunkOffsets(chunkOffset);
 
+    ReleaseChunkSegments();
+
     // note: we do not free our chunk buffer; we reuse it, expanding as needed.
     // It gets zapped when this class goes out of scope
+    m_chunkBufferUsed = 0;
     m_sizeOfDataInChunkBuffer = 0;
     m_chunkSamples = 0;
     m_chunkDuration = 0;
 }
 
+void MP4Track::ReleaseChunkSegments()
+{
+    const vector<ChunkSegment>::size_type max = m_chunkSegments.size();
+    for (vector<ChunkSegment>::size_type i = 0; i < max; i++) {
+        const ChunkSegment& segment = m_chunkSegments[i];
+        if (segment.release)
+            segment.release(segment.userData, segment.pBytes);
+    }
+    m_chunkSegments.clear();
+}
+
 void MP4Track::FinishWrite(uint32_t options)
 {
-    FinishSdtp();
+    // tables derived from the samples are only updated if samples can have
+    // been written; the trak then stays as read, see
+    // MP4File::FinishModifyInPlace()
+    const bool samplesWritten = !m_File.IsModifyInPlace();
+
+    if (samplesWritten) {
+        FinishSdtp();
+    }
 
     // write out any remaining samples in chunk buffer
     WriteChunkBuffer();
@@ -536,14 +985,14 @@ void MP4Track::FinishWrite(uint32_t options)
     // record buffer size and bitrates
     MP4BitfieldProperty* pBufferSizeProperty;
 
-    if (m_trakAtom.FindProperty(
+    if (samplesWritten && m_trakAtom.FindProperty(
                 "trak.mdia.minf.stbl.stsd.*.esds.decConfigDescr.bufferSizeDB",
                 (MP4Property**)&pBufferSizeProperty)) {
         pBufferSizeProperty->SetValue(GetMaxSampleSize());
     }
 
 	// don't overwrite bitrate if it was requested in the Close call
-    if( !(options & MP4_CLOSE_DO_NOT_COMPUTE_BITRATE)) {
+    if( samplesWritten && !(options & MP4_CLOSE_DO_NOT_COMPUTE_BITRATE)) {
         MP4Integer32Property* pBitrateProperty;
 
         if (m_trakAtom.FindProperty(
@@ -613,6 +1062,59 @@ void MP4Track::FinishSdtp()
     }
 }
 
+uint64_t MP4Track::GetPendingMoovBytes(uint64_t& chunkOffset)
+{
+    // nothing is written and no tables change, see FinishWrite()
+    if (m_File.IsModifyInPlace()) {
+        return 0;
+    }
+
+    uint64_t bytes = 0;
+
+    if (m_sizeOfDataInChunkBuffer != 0) {
+        const uint64_t offset = m_dataReference.empty() ? chunkOffset : m_referenceOffset;
+        if (m_dataReference.empty()) {
+            chunkOffset += m_sizeOfDataInChunkBuffer;
+        }
+
+        // one more chunk offset, all of them 64-bit if it needs a promotion
+        if (m_pChunkOffsetProperty->GetType() != Integer32Property) {
+            bytes += 8;
+        } else if (offset > 0xFFFFFFFF) {
+            bytes += 8 + 4 * (uint64_t)m_pChunkOffsetProperty->GetCount();
+        } else {
+            bytes += 4;
+        }
+
+        // and a sample to chunk entry unless the last one matches
+        const uint32_t numStsc = m_pStscCountProperty->GetValue();
+        if (numStsc == 0 ||
+                m_pStscSamplesPerChunkProperty->GetValue(numStsc - 1) != m_chunkSamples) {
+            bytes += 12;
+        }
+    }
+
+    // an odd number of 4-bit sample sizes still owes its last byte
+    if (m_pStszFixedSampleSizeProperty == NULL &&
+            m_stsz_sample_bits == 4 && m_have_stz2_4bit_sample) {
+        bytes += 1;
+    }
+
+    // sdtp is only created or resized by FinishSdtp()
+    if (!m_sdtpLog.empty()) {
+        MP4SdtpAtom* sdtp = (MP4SdtpAtom*)m_trakAtom.FindAtom( "trak.mdia.minf.stbl.sdtp" );
+        const uint32_t written = sdtp ? sdtp->data.GetValueSize() : 0;
+        if (!sdtp) {
+            bytes += 12;    // full atom header
+        }
+        if (m_sdtpLog.size() > written) {
+            bytes += m_sdtpLog.size() - written;
+        }
+    }
+
+    return bytes;
+}
+
 bool MP4Track::IsChunkFull(MP4SampleId sampleId)
 {
     if (m_samplesPerChunk) {
@@ -737,9 +1239,9 @@ void MP4Track::UpdateSampleSizes(MP4SampleId sampleId, uint32_t numBytes)
     if (m_bytesPerSample > 1) {
         if ((numBytes % m_bytesPerSample) != 0) {
             // error
-            log.errorf("%s: \"%s\": numBytes %u not divisible by bytesPerSample %u sampleId %u",
-                       __FUNCTION__, GetFile().GetFilename().c_str(),
-                       numBytes, m_bytesPerSample, sampleId);
+            m_File.GetLog().errorf("%s: \"%s\": numBytes %u not divisible by bytesPerSample %u sampleId %u",
+                                   __FUNCTION__, GetFile().GetFilename().c_str(),
+                                   numBytes, m_bytesPerSample, sampleId);
         }
         numBytes /= m_bytesPerSample;
     }
@@ -889,10 +1391,32 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
     uint32_t stscIndex = GetSampleStscIndex( sampleId );
     uint32_t stsdIndex = m_pStscSampleDescrIndexProperty->GetValue( stscIndex );
 
-    // check if the answer will be the same as last time
-    if( m_lastStsdIndex && stsdIndex == m_lastStsdIndex )
-        return m_lastSampleFile;
+    if( stsdIndex == 0 )
+        throw new Exception( "invalid stsd index", __FILE__, __LINE__, __FUNCTION__ );
+
+    if( stsdIndex > m_sampleFiles.size() ) {
+        // the index comes from the file, only trust it as far as stsd goes;
+        // entries can still be added while writing, so size on demand
+        MP4Atom* pStsdAtom = m_trakAtom.FindAtom( "trak.mdia.minf.stbl.stsd" );
+        const uint32_t numStsdEntries = pStsdAtom ? pStsdAtom->GetNumberOfChildAtoms() : 0;
+        if( stsdIndex > numStsdEntries )
+            throw new Exception( "invalid stsd index", __FILE__, __LINE__, __FUNCTION__ );
 
+        SampleFile unresolved = { false, NULL };
+        m_sampleFiles.resize( numStsdEntries, unresolved );
+    }
+
+    SampleFile& sampleFile = m_sampleFiles[stsdIndex - 1];
+    if( !sampleFile.resolved ) {
+        sampleFile.file = OpenSampleFile( stsdIndex );
+        sampleFile.resolved = true;
+    }
+
+    return sampleFile.file;
+}
+
+File* MP4Track::OpenSampleFile( uint32_t stsdIndex )
+{
     MP4Atom* pStsdAtom = m_trakAtom.FindAtom( "trak.mdia.minf.stbl.stsd" );
     ASSERT( pStsdAtom );
 
@@ -946,8 +1470,8 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
 
         const char* url = pLocationProperty->GetValue();
 
-        log.verbose3f("\"%s\": dref url = %s", GetFile().GetFilename().c_str(), 
-                      url);
+        m_File.GetLog().verbose3f("\"%s\": dref url = %s", GetFile().GetFilename().c_str(), 
+                                  url);
 
         file = (File*)-1;
 
@@ -961,7 +1485,7 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
 
             if( fileName ) {
                 file = new File( fileName, File::MODE_READ );
-                if( !file->open() ) {
+                if( file->open() ) {
                     delete file;
                     file = (File*)-1;
                 }
@@ -969,14 +1493,67 @@ File* MP4Track::GetSampleFile( MP4SampleId sampleId )
         }
     }
 
-    if( m_lastSampleFile )
-        m_lastSampleFile->close();
+    return file;
+}
+
+void MP4Track::CloseSampleFiles()
+{
+    const vector<SampleFile>::size_type max = m_sampleFiles.size();
+    for( vector<SampleFile>::size_type i = 0; i < max; i++ ) {
+        File* file = m_sampleFiles[i].file;
+        if( file && file != (File*)-1 )
+            delete file;
+    }
+    m_sampleFiles.clear();
+}
 
-    // cache the answer
-    m_lastStsdIndex = stsdIndex;
-    m_lastSampleFile = file;
+void MP4Track::SetDataReference( const string& location )
+{
+    // samples are always written with the first sample description
+    MP4Atom* pStsdEntryAtom = m_trakAtom.FindAtom( "trak.mdia.minf.stbl.stsd" );
+    if( pStsdEntryAtom )
+        pStsdEntryAtom = pStsdEntryAtom->GetChildAtom( 0 );
 
-    return file;
+    MP4Integer16Property* pDrefIndexProperty = NULL;
+    if( !pStsdEntryAtom ||
+        !pStsdEntryAtom->FindProperty( "*.dataReferenceIndex", (MP4Property**)&pDrefIndexProperty ) )
+    {
+        throw new Exception( "invalid stsd entry", __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    MP4Atom* pDrefAtom = m_trakAtom.FindAtom( "trak.mdia.minf.dinf.dref" );
+    MP4Atom* pUrlAtom = NULL;
+    if( pDrefAtom && pDrefIndexProperty->GetValue() )
+        pUrlAtom = pDrefAtom->GetChildAtom( pDrefIndexProperty->GetValue() - 1 );
+
+    MP4StringProperty* pLocationProperty = NULL;
+    if( !pUrlAtom || strcmp( pUrlAtom->GetType(), "url " ) ||
+        !pUrlAtom->FindProperty( "*.location", (MP4Property**)&pLocationProperty ))
+    {
+        throw new Exception( "track has no url data reference", __FILE__, __LINE__, __FUNCTION__ );
+    }
+
+    // MP4UrlAtom::Write() clears the self-contained flag as well, but
+    // GetSampleFile() has to see it right away
+    pLocationProperty->SetValue( location.c_str() );
+    pUrlAtom->SetFlags( pUrlAtom->GetFlags() & 0xFFFFFE );
+
+    m_dataReference = location;
+    CloseSampleFiles();
+}
+
+bool MP4Track::HasExternalSamples()
+{
+    if( !m_dataReference.empty() )
+        return true;
+
+    const uint32_t numStsc = m_pStscCountProperty->GetValue();
+    for( uint32_t i = 0; i < numStsc; i++ ) {
+        if( GetSampleFile( m_pStscFirstSampleProperty->GetValue( i )) != NULL )
+            return true;
+    }
+
+    return false;
 }
 
 uint64_t MP4Track::GetSampleFileOffset(MP4SampleId sampleId)
@@ -1042,6 +1619,9 @@ void MP4Track::UpdateSampleToChunk(MP4SampleId sampleId,
 
 void MP4Track::UpdateChunkOffsets(uint64_t chunkOffset)
 {
+    if (chunkOffset > 0xFFFFFFFF)
+        PromoteChunkOffsetsTo64();
+
     if (m_pChunkOffsetProperty->GetType() == Integer32Property) {
         ((MP4Integer32Property*)m_pChunkOffsetProperty)->AddValue(chunkOffset);
     } else {
@@ -1084,9 +1664,11 @@ void MP4Track::GetSampleTimes(MP4SampleId sampleId,
 
 
     if (m_cachedSttsSid != MP4_INVALID_SAMPLE_ID && sampleId >= m_cachedSttsSid) {
+        m_File.GetStats().cacheHits++;
         sid   = m_cachedSttsSid;
         elapsed   = m_cachedSttsElapsed;
     } else {
+        m_File.GetStats().cacheMisses++;
         m_cachedSttsIndex = 0;
         sid   = 1;
         elapsed   = 0;
@@ -1137,8 +1719,8 @@ MP4SampleId MP4Track::GetSampleIdFromTime(
             m_pSttsSampleDeltaProperty->GetValue(sttsIndex);
 
         if (sampleDelta == 0 && sttsIndex < numStts - 1) {
-            log.warningf("%s: \"%s\": Zero sample duration, stts entry %u",
-                         __FUNCTION__, GetFile().GetFilename().c_str(), sttsIndex);
+            m_File.GetLog().warningf("%s: \"%s\": Zero sample duration, stts entry %u",
+                                     __FUNCTION__, GetFile().GetFilename().c_str(), sttsIndex);
         }
 
         MP4Duration d = when - elapsed;
@@ -1165,7 +1747,7 @@ MP4SampleId MP4Track::GetSampleIdFromTime(
     return 0; // satisfy MS compiler
 }
 
-void MP4Track::UpdateSampleTimes(MP4Duration duration)
+void MP4Track::UpdateSampleTimes(MP4Duration duration, uint32_t numSamples)
 {
     uint32_t numStts = m_pSttsCountProperty->GetValue();
 
@@ -1173,11 +1755,11 @@ void MP4Track::UpdateSampleTimes(MP4Duration duration)
     if (numStts
             && duration == m_pSttsSampleDeltaProperty->GetValue(numStts-1)) {
         // increment last entry sampleCount
-        m_pSttsSampleCountProperty->IncrementValue(1, numStts-1);
+        m_pSttsSampleCountProperty->IncrementValue(numSamples, numStts-1);
 
     } else {
-        // add stts entry, sampleCount = 1, sampleDuration = duration
-        m_pSttsSampleCountProperty->AddValue(1);
+        // add stts entry, sampleCount = numSamples, sampleDuration = duration
+        m_pSttsSampleCountProperty->AddValue(numSamples);
         m_pSttsSampleDeltaProperty->AddValue(duration);
         m_pSttsCountProperty->IncrementValue();;
     }
@@ -1190,8 +1772,10 @@ uint32_t MP4Track::GetSampleCttsIndex(MP4SampleId sampleId,
     MP4SampleId sid;
 
     if (m_cachedCttsSid != MP4_INVALID_SAMPLE_ID && sampleId >= m_cachedCttsSid) {
+        m_File.GetStats().cacheHits++;
         sid   = m_cachedCttsSid;
     } else {
+        m_File.GetStats().cacheMisses++;
         m_cachedCttsIndex = 0;
         sid = 1;
     }
@@ -1603,25 +2187,39 @@ void MP4Track::ReadChunk(MP4ChunkId chunkId,
     ASSERT(ppChunk);
     ASSERT(pChunkSize);
 
+    *pChunkSize = GetChunkSize(chunkId);
+    *ppChunk = (uint8_t*)MP4Malloc(*pChunkSize);
+
+    try {
+        ReadChunkBytes(chunkId, *ppChunk, *pChunkSize);
+    }
+    catch( Exception* x ) {
+        MP4Free( *ppChunk );
+        *ppChunk = NULL;
+        throw x;
+    }
+}
+
+void MP4Track::ReadChunkBytes(MP4ChunkId chunkId,
+                              uint8_t* pBytes, uint32_t numBytes)
+{
     uint64_t chunkOffset =
         m_pChunkOffsetProperty->GetValue(chunkId - 1);
 
-    *pChunkSize = GetChunkSize(chunkId);
-    *ppChunk = (uint8_t*)MP4Malloc(*pChunkSize);
+    MP4V2_LOG_RECORDF(m_File.GetLog(), MP4_LOG_VERBOSE3, MP4_LOG_CODE_CHUNK_READ, m_trackId, MP4_INVALID_SAMPLE_ID,
+                      "\"%s\": ReadChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
+                      GetFile().GetFilename().c_str(),
+                      m_trackId, chunkId, chunkOffset, numBytes, numBytes);
 
-    log.verbose3f("\"%s\": ReadChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
-                  GetFile().GetFilename().c_str(),
-                  m_trackId, chunkId, chunkOffset, *pChunkSize, *pChunkSize);
+    TraceSpan span("read", "ReadChunk", (MP4FileHandle)&m_File);
+    MP4File::StatsTimer timer(m_File, m_File.GetStats().sampleIoMicroseconds);
 
     uint64_t oldPos = m_File.GetPosition(); // only used in mode == 'w'
     try {
         m_File.SetPosition( chunkOffset );
-        m_File.ReadBytes( *ppChunk, *pChunkSize );
+        m_File.ReadBytes( pBytes, numBytes );
     }
     catch( Exception* x ) {
-        MP4Free( *ppChunk );
-        *ppChunk = NULL;
-
         if( m_File.IsWriteMode() )
             m_File.SetPosition( oldPos );
 
@@ -1632,18 +2230,264 @@ void MP4Track::ReadChunk(MP4ChunkId chunkId,
         m_File.SetPosition( oldPos );
 }
 
-void MP4Track::RewriteChunk(MP4ChunkId chunkId,
-                            uint8_t* pChunk, uint32_t chunkSize)
+bool MP4Track::CopyChunks(MP4Track& srcTrack)
 {
-    uint64_t chunkOffset = m_File.GetPosition();
+    // only an untouched track can take over whole tables
+    if (GetNumberOfSamples() || m_pChunkCountProperty->GetValue() ||
+            m_sizeOfDataInChunkBuffer || !m_sdtpLog.empty()) {
+        return false;
+    }
+
+    // the source must be settled, self-contained and use a single
+    // sample description, its stsz values are taken over as they are
+    if (srcTrack.m_sizeOfDataInChunkBuffer ||
+            srcTrack.m_bytesPerSample != m_bytesPerSample ||
+            srcTrack.m_stsz_sample_bits == 4 ||
+            m_pStszFixedSampleSizeProperty == NULL ||
+            m_pStszSampleSizeProperty->GetType() != Integer32Property) {
+        return false;
+    }
+
+    const uint32_t numSamples = srcTrack.GetNumberOfSamples();
+    const uint32_t numChunks = srcTrack.GetNumberOfChunks();
+    const uint32_t numStsc = srcTrack.m_pStscCountProperty->GetValue();
+
+    if (numSamples == 0) {
+        return true;
+    }
+    if (!srcTrack.m_sdtpLog.empty() && srcTrack.m_sdtpLog.size() < numSamples) {
+        return false;
+    }
+
+    uint32_t stscSamples = 0;
+    for (uint32_t i = 0; i < numStsc; i++) {
+        if (srcTrack.m_pStscSampleDescrIndexProperty->GetValue(i) != 1) {
+            return false;
+        }
+        MP4ChunkId lastChunk = (i + 1 < numStsc)
+            ? srcTrack.m_pStscFirstChunkProperty->GetValue(i + 1) - 1
+            : numChunks;
+        MP4ChunkId firstChunk = srcTrack.m_pStscFirstChunkProperty->GetValue(i);
+        if (firstChunk == 0 || lastChunk < firstChunk - 1 || lastChunk > numChunks) {
+            return false;
+        }
+        stscSamples += (lastChunk - firstChunk + 1) *
+            srcTrack.m_pStscSamplesPerChunkProperty->GetValue(i);
+    }
+    if (stscSamples != numSamples || srcTrack.GetSampleFile(1) != NULL) {
+        return false;
+    }
+
+    m_File.GetLog().verbose1f("\"%s\": CopyChunks: track %u from track %u, %u samples in %u chunks",
+                              GetFile().GetFilename().c_str(),
+                              m_trackId, srcTrack.m_trackId, numSamples, numChunks);
+
+    // sample sizes
+    uint32_t fixedSampleSize = 0;
+    if (srcTrack.m_pStszFixedSampleSizeProperty) {
+        fixedSampleSize = srcTrack.m_pStszFixedSampleSizeProperty->GetValue();
+    }
+    m_pStszFixedSampleSizeProperty->SetValue(fixedSampleSize);
+    if (fixedSampleSize == 0) {
+        MP4Integer32Property* pSizes = (MP4Integer32Property*)m_pStszSampleSizeProperty;
+        pSizes->SetCount(numSamples);
+        for (uint32_t i = 0; i < numSamples; i++) {
+            pSizes->SetValue((uint32_t)srcTrack.m_pStszSampleSizeProperty->GetValue(i), i);
+        }
+    }
+    m_pStszSampleCountProperty->IncrementValue(numSamples);
+
+    // sample times
+    const uint32_t numStts = srcTrack.m_pSttsCountProperty->GetValue();
+    MP4Duration duration = 0;
+    m_pSttsSampleCountProperty->SetCount(numStts);
+    m_pSttsSampleDeltaProperty->SetCount(numStts);
+    for (uint32_t i = 0; i < numStts; i++) {
+        uint32_t sampleCount = srcTrack.m_pSttsSampleCountProperty->GetValue(i);
+        uint32_t sampleDelta = srcTrack.m_pSttsSampleDeltaProperty->GetValue(i);
+        m_pSttsSampleCountProperty->SetValue(sampleCount, i);
+        m_pSttsSampleDeltaProperty->SetValue(sampleDelta, i);
+        duration += (MP4Duration)sampleCount * sampleDelta;
+    }
+    m_pSttsCountProperty->IncrementValue(numStts);
+
+    // rendering offsets, only if there are any, as WriteSample() would do
+    const uint32_t numCtts =
+        srcTrack.m_pCttsCountProperty ? srcTrack.m_pCttsCountProperty->GetValue() : 0;
+    bool haveCtts = false;
+    for (uint32_t i = 0; i < numCtts && !haveCtts; i++) {
+        haveCtts = srcTrack.m_pCttsSampleOffsetProperty->GetValue(i) != 0;
+    }
+    if (haveCtts) {
+        if (m_pCttsCountProperty == NULL) {
+            MP4Atom* pCttsAtom = AddAtom("trak.mdia.minf.stbl", "ctts");
+
+            ASSERT(pCttsAtom->FindProperty(
+                       "ctts.entryCount",
+                       (MP4Property**)&m_pCttsCountProperty));
+
+            ASSERT(pCttsAtom->FindProperty(
+                       "ctts.entries.sampleCount",
+                       (MP4Property**)&m_pCttsSampleCountProperty));
+
+            ASSERT(pCttsAtom->FindProperty(
+                       "ctts.entries.sampleOffset",
+                       (MP4Property**)&m_pCttsSampleOffsetProperty));
+        }
+
+        m_pCttsSampleCountProperty->SetCount(numCtts);
+        m_pCttsSampleOffsetProperty->SetCount(numCtts);
+        for (uint32_t i = 0; i < numCtts; i++) {
+            m_pCttsSampleCountProperty->SetValue(
+                srcTrack.m_pCttsSampleCountProperty->GetValue(i), i);
+            m_pCttsSampleOffsetProperty->SetValue(
+                srcTrack.m_pCttsSampleOffsetProperty->GetValue(i), i);
+        }
+        m_pCttsCountProperty->IncrementValue(numCtts);
+    }
+
+    // sync samples, stss is only needed if some sample is not one
+    const uint32_t numStss =
+        srcTrack.m_pStssCountProperty ? srcTrack.m_pStssCountProperty->GetValue() : numSamples;
+    if (numStss < numSamples) {
+        if (m_pStssCountProperty == NULL) {
+            MP4Atom* pStssAtom = AddAtom("trak.mdia.minf.stbl", "stss");
+
+            ASSERT(pStssAtom->FindProperty(
+                       "stss.entryCount",
+                       (MP4Property**)&m_pStssCountProperty));
+
+            ASSERT(pStssAtom->FindProperty(
+                       "stss.entries.sampleNumber",
+                       (MP4Property**)&m_pStssSampleProperty));
+        }
+
+        m_pStssSampleProperty->SetCount(numStss);
+        for (uint32_t i = 0; i < numStss; i++) {
+            m_pStssSampleProperty->SetValue(
+                srcTrack.m_pStssSampleProperty->GetValue(i), i);
+        }
+        m_pStssCountProperty->IncrementValue(numStss);
+    }
+
+    // dependency flags, written out by FinishSdtp()
+    if (!srcTrack.m_sdtpLog.empty()) {
+        m_sdtpLog.assign(srcTrack.m_sdtpLog, 0, numSamples);
+    }
+
+    // chunk data, one read and one write per chunk; WriteChunkBuffer()
+    // takes care of stsc and the new chunk offsets
+    MP4SampleId sampleId = 1;
+    for (uint32_t i = 0; i < numStsc; i++) {
+        MP4ChunkId firstChunk = srcTrack.m_pStscFirstChunkProperty->GetValue(i);
+        MP4ChunkId lastChunk = (i + 1 < numStsc)
+            ? srcTrack.m_pStscFirstChunkProperty->GetValue(i + 1) - 1
+            : numChunks;
+        uint32_t samplesPerChunk = srcTrack.m_pStscSamplesPerChunkProperty->GetValue(i);
+
+        for (MP4ChunkId chunkId = firstChunk; chunkId <= lastChunk; chunkId++) {
+            uint32_t chunkSize = 0;
+            for (uint32_t j = 0; j < samplesPerChunk; j++) {
+                chunkSize += srcTrack.GetSampleSize(sampleId + j);
+            }
+
+            if (chunkSize > m_chunkBufferSize) {
+                uint32_t newSize = 2 * m_chunkBufferSize;
+                if (newSize < chunkSize)
+                    newSize = chunkSize;
+
+                m_pChunkBuffer = (uint8_t*)MP4Realloc(m_pChunkBuffer, newSize);
+                m_chunkBufferSize = newSize;
+            }
+
+            srcTrack.ReadChunkBytes(chunkId, m_pChunkBuffer, chunkSize);
+
+            ChunkSegment segment;
+            segment.pBytes   = NULL;
+            segment.offset   = 0;
+            segment.numBytes = chunkSize;
+            segment.release  = NULL;
+            segment.userData = NULL;
+            m_chunkSegments.push_back(segment);
+
+            m_chunkBufferUsed = chunkSize;
+            m_sizeOfDataInChunkBuffer = chunkSize;
+            m_chunkSamples = samplesPerChunk;
+
+            sampleId += samplesPerChunk;
+            m_writeSampleId = sampleId - 1;
+            WriteChunkBuffer();
+        }
+    }
+    m_writeSampleId = sampleId;
+
+    UpdateDurations(duration);
+
+    UpdateModificationTimes();
+
+    return true;
+}
 
-    m_File.WriteBytes(pChunk, chunkSize);
+uint64_t MP4Track::GetChunkOffset(MP4ChunkId chunkId)
+{
+    ASSERT(chunkId);
+
+    return m_pChunkOffsetProperty->GetValue(chunkId - 1);
+}
+
+void MP4Track::SetChunkOffset(MP4ChunkId chunkId, uint64_t chunkOffset)
+{
+    ASSERT(chunkId);
+
+    if (chunkOffset > 0xFFFFFFFF)
+        PromoteChunkOffsetsTo64();
 
     m_pChunkOffsetProperty->SetValue(chunkOffset, chunkId - 1);
+}
+
+void MP4Track::PromoteChunkOffsetsTo64()
+{
+    if (m_pChunkOffsetProperty->GetType() != Integer32Property)
+        return;
+
+    MP4Atom* pStblAtom = m_trakAtom.FindAtom("trak.mdia.minf.stbl");
+    MP4Atom* pStcoAtom = m_trakAtom.FindAtom("trak.mdia.minf.stbl.stco");
+    ASSERT(pStblAtom);
+    ASSERT(pStcoAtom);
+
+    uint32_t index = 0;
+    while (pStblAtom->GetChildAtom(index) != pStcoAtom)
+        index++;
+
+    MP4Atom* pCo64Atom = m_File.InsertChildAtom(pStblAtom, "co64", index);
+
+    MP4Integer32Property* pCountProperty = NULL;
+    MP4Integer64Property* pOffsetProperty = NULL;
+    (void)pCo64Atom->FindProperty("co64.entryCount",
+                                  (MP4Property**)&pCountProperty);
+    (void)pCo64Atom->FindProperty("co64.entries.chunkOffset",
+                                  (MP4Property**)&pOffsetProperty);
+    ASSERT(pCountProperty);
+    ASSERT(pOffsetProperty);
+
+    MP4Integer32Property* pStcoOffsetProperty =
+        (MP4Integer32Property*)m_pChunkOffsetProperty;
+    uint32_t numChunks = pStcoOffsetProperty->GetCount();
+
+    pOffsetProperty->SetCount(numChunks);
+    for (uint32_t i = 0; i < numChunks; i++) {
+        pOffsetProperty->SetValue(pStcoOffsetProperty->GetValue(i), i);
+    }
+    pCountProperty->SetValue(m_pChunkCountProperty->GetValue());
+
+    pStblAtom->DeleteChildAtom(pStcoAtom);
+    delete pStcoAtom;
+
+    m_pChunkCountProperty = pCountProperty;
+    m_pChunkOffsetProperty = pOffsetProperty;
 
-    log.verbose3f("\"%s\": RewriteChunk: track %u id %u offset 0x%" PRIx64 " size %u (0x%x)",
-                  GetFile().GetFilename().c_str(),
-                  m_trackId, chunkId, chunkOffset, chunkSize, chunkSize);
+    m_File.GetLog().verbose1f("\"%s\": track %u chunk offsets promoted to co64",
+                              GetFile().GetFilename().c_str(), m_trackId);
 }
 
 // map track type name aliases to official names
@@ -1878,11 +2722,11 @@ MP4SampleId MP4Track::GetSampleIdFromEditTime(
                 *pDuration = editSampleDuration;
             }
 
-            log.verbose2f("\"%s\": GetSampleIdFromEditTime: when %" PRIu64 " "
-                          "sampleId %u start %" PRIu64 " duration %" PRId64,
-                          GetFile().GetFilename().c_str(),
-                          editWhen, sampleId,
-                          editSampleStartTime, editSampleDuration);
+            m_File.GetLog().verbose2f("\"%s\": GetSampleIdFromEditTime: when %" PRIu64 " "
+                                      "sampleId %u start %" PRIu64 " duration %" PRId64,
+                                      GetFile().GetFilename().c_str(),
+                                      editWhen, sampleId,
+                                      editSampleStartTime, editSampleDuration);
 
             return sampleId;
         }
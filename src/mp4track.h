@@ -48,6 +48,8 @@ class MP4StringProperty;
 
 class MP4Track
 {
+    friend class MP4SampleCursor;
+
 public:
     MP4Track(MP4File& file, MP4Atom& trakAtom);
 
@@ -82,6 +84,14 @@ public:
         bool*         hasDependencyFlags = NULL,
         uint32_t*     dependencyFlags = NULL );
 
+    // read the data of all samples in decoding order in one pass; samples
+    // stored back to back, also across chunks, are fetched with one read.
+    // meant for small tracks such as chapter text, the whole track ends up
+    // in memory
+    void ReadAllSamples(
+        vector<uint8_t>&  data,
+        vector<uint32_t>& sizes );
+
     void WriteSample(
         const uint8_t* pBytes,
         uint32_t numBytes,
@@ -89,6 +99,26 @@ public:
         MP4Duration renderingOffset = 0,
         bool isSyncSample = true);
 
+    // like WriteSample() but the bytes are not copied, they are written
+    // straight from pBytes when the chunk is flushed and then handed back
+    void WriteSampleRef(
+        const uint8_t* pBytes,
+        uint32_t numBytes,
+        MP4SampleReleaseFunc release,
+        void* userData,
+        MP4Duration duration = 0,
+        MP4Duration renderingOffset = 0,
+        bool isSyncSample = true);
+
+    // write numSamples sync samples, stored back to back in pBytes, as one
+    // chunk of their own with a single write; stts gets one entry per run
+    // of equal durations
+    void WriteSamples(
+        const uint8_t*     pBytes,
+        const uint32_t*    sizes,
+        const MP4Duration* durations,
+        uint32_t           numSamples);
+
     void WriteSampleDependency(
         const uint8_t* pBytes,
         uint32_t       numBytes,
@@ -97,8 +127,23 @@ public:
         bool           isSyncSample,
         uint32_t       dependencyFlags );
 
+    // like MP4File::CopySample() but the bytes stay where they are, the track
+    // refers to the file of srcTrack through its data reference instead
+    void ReferenceSample(
+        MP4Track&   srcTrack,
+        MP4SampleId srcSampleId,
+        MP4Duration duration = MP4_INVALID_DURATION);
+
+    // true if samples are located in a file other than this one
+    bool HasExternalSamples();
+
     virtual void FinishWrite(uint32_t options = 0);
 
+    // bytes FinishWrite() will add to the moov atom for samples still
+    // pending, chunkOffset is where the pending chunk goes and is advanced
+    // past it
+    uint64_t GetPendingMoovBytes(uint64_t& chunkOffset);
+
     uint64_t    GetDuration();      // in track timeScale units
     uint32_t    GetTimeScale();
     uint32_t    GetNumberOfSamples();
@@ -157,8 +202,17 @@ public:
     void ReadChunk(MP4ChunkId chunkId,
                    uint8_t** ppChunk, uint32_t* pChunkSize);
 
-    void RewriteChunk(MP4ChunkId chunkId,
-                      uint8_t* pChunk, uint32_t chunkSize);
+    // take over all samples of srcTrack chunk by chunk, with their tables
+    // copied as a whole; false if that is not possible (nothing changed)
+    bool CopyChunks(MP4Track& srcTrack);
+
+    uint32_t    GetChunkSize(MP4ChunkId chunkId);
+
+    uint64_t    GetChunkOffset(MP4ChunkId chunkId);
+    void        SetChunkOffset(MP4ChunkId chunkId, uint64_t chunkOffset);
+
+    // replace a 32-bit stco with an equivalent co64, no-op if already 64-bit
+    void        PromoteChunkOffsetsTo64();
 
     MP4Duration GetDurationPerChunk();
     void        SetDurationPerChunk( MP4Duration );
@@ -169,9 +223,11 @@ protected:
     bool        InitEditListProperties();
 
     File*       GetSampleFile( MP4SampleId sampleId );
+    File*       OpenSampleFile( uint32_t stsdIndex );
+    void        CloseSampleFiles();
+    void        SetDataReference( const string& location );
     uint32_t    GetSampleStscIndex(MP4SampleId sampleId);
     uint32_t    GetChunkStscIndex(MP4ChunkId chunkId);
-    uint32_t    GetChunkSize(MP4ChunkId chunkId);
     uint32_t    GetSampleCttsIndex(MP4SampleId sampleId,
                                    MP4SampleId* pFirstSampleId = NULL);
     MP4SampleId GetNextSyncSample(MP4SampleId sampleId);
@@ -182,7 +238,7 @@ protected:
     void UpdateSampleToChunk(MP4SampleId sampleId,
                              MP4ChunkId chunkId, uint32_t samplesPerChunk);
     void UpdateChunkOffsets(uint64_t chunkOffset);
-    void UpdateSampleTimes(MP4Duration duration);
+    void UpdateSampleTimes(MP4Duration duration, uint32_t numSamples = 1);
     void UpdateRenderingOffsets(MP4SampleId sampleId,
                                 MP4Duration renderingOffset);
     void UpdateSyncSamples(MP4SampleId sampleId,
@@ -195,7 +251,21 @@ protected:
 
     void UpdateModificationTimes();
 
+    void WriteSampleData(
+        const uint8_t* pBytes,
+        uint32_t numBytes,
+        MP4Duration duration,
+        MP4Duration renderingOffset,
+        bool isSyncSample,
+        bool* pQueued,
+        MP4SampleReleaseFunc release,
+        void* userData);
     void WriteChunkBuffer();
+    void ReadChunkBytes(MP4ChunkId chunkId,
+                        uint8_t* pBytes, uint32_t numBytes);
+    void ReadRunBytes(File* fin, uint64_t offset,
+                      uint8_t* pBytes, uint32_t numBytes);
+    void ReleaseChunkSegments();
 
     void CalculateBytesPerSample();
 
@@ -207,8 +277,13 @@ protected:
     MP4TrackId  m_trackId;          // moov.trak[].tkhd.trackId
     MP4StringProperty* m_pTypeProperty; // moov.trak[].mdia.hdlr.handlerType
 
-    uint32_t m_lastStsdIndex;
-    File*    m_lastSampleFile;
+    // files samples are located in, by stsd index - 1; an entry is resolved
+    // on first use and its file stays open for the life of the track
+    struct SampleFile {
+        bool  resolved;
+        File* file;     // NULL if self-contained, (File*)-1 if inaccessible
+    };
+    vector<SampleFile> m_sampleFiles;
 
     // for efficient construction of hint track packets
     MP4SampleId m_cachedReadSampleId;
@@ -220,10 +295,27 @@ protected:
     MP4Duration m_fixedSampleDuration;
     uint8_t*    m_pChunkBuffer;
     uint32_t    m_chunkBufferSize;          // Actual size of our chunk buffer.
-    uint32_t    m_sizeOfDataInChunkBuffer;  // Size of the data in the chunk buffer.
+    uint32_t    m_chunkBufferUsed;          // Bytes copied into our chunk buffer.
+    uint32_t    m_sizeOfDataInChunkBuffer;  // Size of the pending chunk, copied and referenced.
     uint32_t    m_chunkSamples;
+
+    // pending chunk as written out, in file order; a NULL pBytes means the
+    // bytes live at offset in m_pChunkBuffer which may move while growing
+    struct ChunkSegment {
+        const uint8_t*       pBytes;
+        uint32_t             offset;
+        uint32_t             numBytes;
+        MP4SampleReleaseFunc release;
+        void*                userData;
+    };
+    vector<ChunkSegment>    m_chunkSegments;
+    vector<File::Segment>   m_chunkIov;
     MP4Duration m_chunkDuration;
 
+    // for samples referenced in another file, see ReferenceSample()
+    string      m_dataReference;    // url of that file, empty if none
+    uint64_t    m_referenceOffset;  // where the pending chunk starts in it
+
     // controls for chunking
     uint32_t    m_samplesPerChunk;
     MP4Duration m_durationPerChunk;
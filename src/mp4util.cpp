@@ -120,14 +120,11 @@ char* MP4ToBase16(const uint8_t* pData, uint32_t dataSize)
     if (dataSize) {
         ASSERT(pData);
     }
-    uint32_t size = 2 * dataSize + 1;
-    char* s = (char*)MP4Calloc(size);
+    uint32_t size = TextCodec::base16Size(dataSize);
+    char* s = (char*)MP4Malloc(size + 1);
 
-    uint32_t i, j;
-    for (i = 0, j = 0; i < dataSize; i++) {
-        size -= snprintf(&s[j], size, "%02x", pData[i]);
-        j += 2;
-    }
+    TextCodec::encodeBase16(pData, dataSize, s);
+    s[size] = '\0';
 
     return s;   /* N.B. caller is responsible for free'ing s */
 }
@@ -136,75 +133,17 @@ char* MP4ToBase64(const uint8_t* pData, uint32_t dataSize)
 {
     if (pData == NULL || dataSize == 0) return NULL;
 
-    static const char encoding[64] = {
-        'A','B','C','D','E','F','G','H','I','J','K','L','M','N','O','P',
-        'Q','R','S','T','U','V','W','X','Y','Z','a','b','c','d','e','f',
-        'g','h','i','j','k','l','m','n','o','p','q','r','s','t','u','v',
-        'w','x','y','z','0','1','2','3','4','5','6','7','8','9','+','/'
-    };
-
-    char* s = (char*)MP4Calloc((((dataSize + 2) * 4) / 3) + 1);
-
-    const uint8_t* src = pData;
-    if (pData == NULL) return NULL;
-    char* dest = s;
-    uint32_t numGroups = dataSize / 3;
-
-    for (uint32_t i = 0; i < numGroups; i++) {
-        *dest++ = encoding[src[0] >> 2];
-        *dest++ = encoding[((src[0] & 0x03) << 4) | (src[1] >> 4)];
-        *dest++ = encoding[((src[1] & 0x0F) << 2) | (src[2] >> 6)];
-        *dest++ = encoding[src[2] & 0x3F];
-        src += 3;
-    }
+    uint32_t size = TextCodec::base64Size(dataSize);
+    char* s = (char*)MP4Malloc(size + 1);
 
-    if (dataSize % 3 == 1) {
-        *dest++ = encoding[src[0] >> 2];
-        *dest++ = encoding[((src[0] & 0x03) << 4)];
-        *dest++ = '=';
-        *dest++ = '=';
-    } else if (dataSize % 3 == 2) {
-        *dest++ = encoding[src[0] >> 2];
-        *dest++ = encoding[((src[0] & 0x03) << 4) | (src[1] >> 4)];
-        *dest++ = encoding[((src[1] & 0x0F) << 2)];
-        *dest++ = '=';
-    }
-    *dest = '\0';
-    return s;   /* N.B. caller is responsible for free'ing s */
-}
+    TextCodec::encodeBase64(pData, dataSize, s);
+    s[size] = '\0';
 
-static bool convertBase64 (const char data, uint8_t *value)
-{
-    static const uint8_t decodingarr64[128] = {
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
-        0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b,
-        0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
-        0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
-        0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
-        0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
-        0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20,
-        0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
-        0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30,
-        0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
-    };
-    uint8_t index = (uint8_t)data;
-    if ((index & 0x80) != 0) return false;
-
-    if (decodingarr64[index] == 0xff) return false;
-    *value = decodingarr64[index];
-    return true;
+    return s;   /* N.B. caller is responsible for free'ing s */
 }
 
 uint8_t *Base64ToBinary (const char *pData, uint32_t decodeSize, uint32_t *pDataSize)
 {
-    uint8_t *ret;
-    uint32_t size, ix, groups;
     if (pData == NULL ||  decodeSize == 0 || pDataSize == NULL)
         return NULL;
 
@@ -212,29 +151,12 @@ uint8_t *Base64ToBinary (const char *pData, uint32_t decodeSize, uint32_t *pData
         // must be multiples of 4 characters
         return NULL;
     }
-    size = (decodeSize * 3) / 4;
-    groups = decodeSize / 4;
-    ret = (uint8_t *)MP4Calloc(size);
-    if (ret == NULL) return NULL;
-    for (ix = 0; ix < groups; ix++) {
-        uint8_t value[4];
-        for (uint8_t jx = 0; jx < 4; jx++) {
-            if (pData[jx] == '=') {
-                if (ix != (groups - 1)) {
-                    free(ret);
-                    return NULL;
-                }
-                size--;
-                value[jx] = 0;
-            } else if (convertBase64(pData[jx], &value[jx]) == false) {
-                free(ret);
-                return NULL;
-            }
-        }
-        ret[(ix * 3)] = value[0] << 2 | ((value[1] >> 4) & 0x3);
-        ret[(ix * 3) + 1] = (value[1] << 4) | (value[2] >> 2 & 0xf);
-        ret[(ix * 3) + 2] = ((value[2] & 0x3) << 6) | value[3];
-        pData += 4;
+
+    uint8_t *ret = (uint8_t *)MP4Malloc((decodeSize / 4) * 3);
+    uint32_t size = 0;
+    if (!TextCodec::decodeBase64(pData, decodeSize, ret, size)) {
+        MP4Free(ret);
+        return NULL;
     }
     *pDataSize = size;
     return ret;
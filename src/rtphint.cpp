@@ -250,9 +250,11 @@ void MP4RtpHintTrack::ReadPacket(
         throw x;
     }
 
-    log.hexDump(0, MP4_LOG_VERBOSE1, *ppBytes, *pNumBytes,
-                "\"%s\": %u ", GetFile().GetFilename().c_str(),
-                packetIndex);
+    if (MP4V2_LOG_ENABLED(log, MP4_LOG_VERBOSE1)) {
+        log.hexDump(0, MP4_LOG_VERBOSE1, *ppBytes, *pNumBytes,
+                    "\"%s\": %u ", GetFile().GetFilename().c_str(),
+                    packetIndex);
+    }
 }
 
 MP4Timestamp MP4RtpHintTrack::GetRtpTimestampStart()
@@ -25,9 +25,13 @@ namespace mp4v2 { namespace impl {
 
 #include "util.h"
 #include "log.h"
+#include "trace.h"
 #include "mp4util.h"
+#include "textcodec.h"
 #include "mp4array.h"
+#include "mp4asyncwriter.h"
 #include "mp4track.h"
+#include "mp4samplecursor.h"
 #include "mp4file.h"
 #include "mp4property.h"
 #include "mp4container.h"
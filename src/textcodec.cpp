@@ -0,0 +1,386 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "src/impl.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#   define MP4V2_TEXTCODEC_X86 1
+#   include <tmmintrin.h>
+#   if defined( _MSC_VER )
+#       include <intrin.h>
+#       define MP4V2_TARGET_SSSE3
+#   else
+#       include <cpuid.h>
+#       define MP4V2_TARGET_SSSE3 __attribute__(( target( "ssse3" )))
+#   endif
+#endif
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::atomic<int> TextCodec::_kernel( -1 );
+
+namespace {
+
+const char BASE16[] = "0123456789abcdef";
+
+const char BASE64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+    "abcdefghijklmnopqrstuvwxyz"
+    "0123456789+/";
+
+// 0xff for anything outside the alphabet, '=' included
+struct Base64Decoding {
+    uint8_t value[256];
+
+    Base64Decoding() {
+        memset( value, 0xff, sizeof( value ));
+        for( uint8_t i = 0; i < 64; i++ )
+            value[(uint8_t)BASE64[i]] = i;
+    }
+};
+
+const Base64Decoding base64Decoding;
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+encodeBase16Scalar( const uint8_t* src, uint32_t size, char* dst )
+{
+    for( uint32_t i = 0; i < size; i++ ) {
+        *dst++ = BASE16[src[i] >> 4];
+        *dst++ = BASE16[src[i] & 0x0f];
+    }
+}
+
+void
+encodeBase64Scalar( const uint8_t* src, uint32_t size, char* dst )
+{
+    for( ; size >= 3; size -= 3, src += 3 ) {
+        *dst++ = BASE64[src[0] >> 2];
+        *dst++ = BASE64[((src[0] & 0x03) << 4) | (src[1] >> 4)];
+        *dst++ = BASE64[((src[1] & 0x0f) << 2) | (src[2] >> 6)];
+        *dst++ = BASE64[src[2] & 0x3f];
+    }
+
+    if( size == 1 ) {
+        *dst++ = BASE64[src[0] >> 2];
+        *dst++ = BASE64[(src[0] & 0x03) << 4];
+        *dst++ = '=';
+        *dst++ = '=';
+    }
+    else if( size == 2 ) {
+        *dst++ = BASE64[src[0] >> 2];
+        *dst++ = BASE64[((src[0] & 0x03) << 4) | (src[1] >> 4)];
+        *dst++ = BASE64[(src[1] & 0x0f) << 2];
+        *dst++ = '=';
+    }
+}
+
+// decode whole groups of 4 chars, the last one may be padded
+bool
+decodeBase64Scalar( const char* src, uint32_t size, uint8_t* dst, uint32_t& dstSize )
+{
+    const uint8_t* const table = base64Decoding.value;
+    const uint8_t* const start = dst;
+
+    if( size % 4 )
+        return false;
+
+    for( ; size > 4; size -= 4, src += 4 ) {
+        const uint8_t a = table[(uint8_t)src[0]];
+        const uint8_t b = table[(uint8_t)src[1]];
+        const uint8_t c = table[(uint8_t)src[2]];
+        const uint8_t d = table[(uint8_t)src[3]];
+        if( (a | b | c | d) & 0x80 )
+            return false;
+
+        *dst++ = uint8_t( (a << 2) | (b >> 4) );
+        *dst++ = uint8_t( (b << 4) | (c >> 2) );
+        *dst++ = uint8_t( (c << 6) | d );
+    }
+
+    if( size ) {
+        const uint8_t a = table[(uint8_t)src[0]];
+        const uint8_t b = table[(uint8_t)src[1]];
+        if( (a | b) & 0x80 )
+            return false;
+        *dst++ = uint8_t( (a << 2) | (b >> 4) );
+
+        if( src[2] == '=' ) {
+            // one byte, the unused bits of b must be clear
+            if( src[3] != '=' || (b & 0x0f) )
+                return false;
+        }
+        else {
+            const uint8_t c = table[(uint8_t)src[2]];
+            if( c & 0x80 )
+                return false;
+            *dst++ = uint8_t( (b << 4) | (c >> 2) );
+
+            if( src[3] == '=' ) {
+                if( c & 0x03 )
+                    return false;
+            }
+            else {
+                const uint8_t d = table[(uint8_t)src[3]];
+                if( d & 0x80 )
+                    return false;
+                *dst++ = uint8_t( (c << 6) | d );
+            }
+        }
+    }
+
+    dstSize = uint32_t( dst - start );
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined( MP4V2_TEXTCODEC_X86 )
+
+bool
+cpuHasSsse3()
+{
+#if defined( _MSC_VER )
+    int info[4];
+    __cpuid( info, 1 );
+    return ( info[2] & ( 1 << 9 )) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ))
+        return false;
+    return ( ecx & bit_SSSE3 ) != 0;
+#endif
+}
+
+MP4V2_TARGET_SSSE3 void
+encodeBase16Ssse3( const uint8_t* src, uint32_t size, char* dst )
+{
+    const __m128i lut  = _mm_loadu_si128( (const __m128i*)BASE16 );
+    const __m128i mask = _mm_set1_epi8( 0x0f );
+
+    for( ; size >= 16; size -= 16, src += 16, dst += 32 ) {
+        const __m128i in = _mm_loadu_si128( (const __m128i*)src );
+        const __m128i hi = _mm_shuffle_epi8( lut, _mm_and_si128( _mm_srli_epi16( in, 4 ), mask ));
+        const __m128i lo = _mm_shuffle_epi8( lut, _mm_and_si128( in, mask ));
+        _mm_storeu_si128( (__m128i*)dst,        _mm_unpacklo_epi8( hi, lo ));
+        _mm_storeu_si128( (__m128i*)(dst + 16), _mm_unpackhi_epi8( hi, lo ));
+    }
+
+    encodeBase16Scalar( src, size, dst );
+}
+
+// 12 input bytes to 16 six-bit indices, one per byte
+MP4V2_TARGET_SSSE3 inline __m128i
+base64Reshuffle( __m128i in )
+{
+    in = _mm_shuffle_epi8( in, _mm_set_epi8( 10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1 ));
+
+    const __m128i t0 = _mm_and_si128( in, _mm_set1_epi32( 0x0fc0fc00 ));
+    const __m128i t1 = _mm_mulhi_epu16( t0, _mm_set1_epi32( 0x04000040 ));
+    const __m128i t2 = _mm_and_si128( in, _mm_set1_epi32( 0x003f03f0 ));
+    const __m128i t3 = _mm_mullo_epi16( t2, _mm_set1_epi32( 0x01000010 ));
+
+    return _mm_or_si128( t1, t3 );
+}
+
+// six-bit indices to alphabet chars by adding a per-range offset
+MP4V2_TARGET_SSSE3 inline __m128i
+base64Translate( __m128i in )
+{
+    const __m128i lut = _mm_setr_epi8( 65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0 );
+
+    // 0 for A-Z, 1 for a-z, 2..11 for 0-9, 12 for '+' and 13 for '/'
+    __m128i range = _mm_subs_epu8( in, _mm_set1_epi8( 51 ));
+    range = _mm_sub_epi8( range, _mm_cmpgt_epi8( in, _mm_set1_epi8( 25 )));
+
+    return _mm_add_epi8( in, _mm_shuffle_epi8( lut, range ));
+}
+
+MP4V2_TARGET_SSSE3 void
+encodeBase64Ssse3( const uint8_t* src, uint32_t size, char* dst )
+{
+    // 16 bytes are loaded for 12 consumed
+    for( ; size >= 16; size -= 12, src += 12, dst += 16 ) {
+        const __m128i in = _mm_loadu_si128( (const __m128i*)src );
+        _mm_storeu_si128( (__m128i*)dst, base64Translate( base64Reshuffle( in )));
+    }
+
+    encodeBase64Scalar( src, size, dst );
+}
+
+MP4V2_TARGET_SSSE3 bool
+decodeBase64Ssse3( const char* src, uint32_t size, uint8_t* dst, uint32_t& dstSize )
+{
+    // bit sets per low and high nibble, a char is valid if they don't meet
+    const __m128i lutLo   = _mm_setr_epi8( 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                           0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a );
+    const __m128i lutHi   = _mm_setr_epi8( 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                           0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 );
+    const __m128i lutRoll = _mm_setr_epi8( 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0 );
+    const __m128i mask2f  = _mm_set1_epi8( 0x2f );
+
+    if( size % 4 )
+        return false;
+
+    const uint8_t* const start = dst;
+
+    // 16 bytes are stored for 12 decoded, keep the padded group and at
+    // least one more for the scalar code so the extra bytes land in dst
+    for( ; size > 20; size -= 16, src += 16, dst += 12 ) {
+        __m128i in = _mm_loadu_si128( (const __m128i*)src );
+
+        const __m128i hiNibbles = _mm_and_si128( _mm_srli_epi32( in, 4 ), mask2f );
+        const __m128i loNibbles = _mm_and_si128( in, mask2f );
+        const __m128i hi = _mm_shuffle_epi8( lutHi, hiNibbles );
+        const __m128i lo = _mm_shuffle_epi8( lutLo, loNibbles );
+
+        // anything invalid is left to the scalar code to reject
+        if( _mm_movemask_epi8( _mm_cmpgt_epi8( _mm_and_si128( lo, hi ), _mm_setzero_si128() )))
+            break;
+
+        const __m128i eq2f = _mm_cmpeq_epi8( in, mask2f );
+        in = _mm_add_epi8( in, _mm_shuffle_epi8( lutRoll, _mm_add_epi8( eq2f, hiNibbles )));
+
+        // pack 4 six-bit values into 3 bytes in each 32-bit lane
+        const __m128i merged = _mm_maddubs_epi16( in, _mm_set1_epi32( 0x01400140 ));
+        __m128i out = _mm_madd_epi16( merged, _mm_set1_epi32( 0x00011000 ));
+        out = _mm_shuffle_epi8( out, _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ));
+
+        _mm_storeu_si128( (__m128i*)dst, out );
+    }
+
+    uint32_t tailSize = 0;
+    if( !decodeBase64Scalar( src, size, dst, tailSize ))
+        return false;
+
+    dstSize = uint32_t( dst - start ) + tailSize;
+    return true;
+}
+
+#endif // MP4V2_TEXTCODEC_X86
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+TextCodec::Kernel
+TextCodec::getKernel()
+{
+    int kernel = _kernel.load( std::memory_order_relaxed );
+    if( kernel < 0 ) {
+        kernel = KERNEL_SCALAR;
+        if( isSupported( KERNEL_SSSE3 ))
+            kernel = KERNEL_SSSE3;
+        _kernel.store( kernel, std::memory_order_relaxed );
+    }
+    return Kernel( kernel );
+}
+
+bool
+TextCodec::setKernel( Kernel kernel )
+{
+    if( !isSupported( kernel ))
+        return false;
+    _kernel.store( kernel, std::memory_order_relaxed );
+    return true;
+}
+
+bool
+TextCodec::isSupported( Kernel kernel )
+{
+    switch( kernel ) {
+        case KERNEL_SCALAR:
+            return true;
+
+#if defined( MP4V2_TEXTCODEC_X86 )
+        case KERNEL_SSSE3:
+        {
+            static const bool ssse3 = cpuHasSsse3();
+            return ssse3;
+        }
+#endif
+
+        default:
+            return false;
+    }
+}
+
+const char*
+TextCodec::kernelName( Kernel kernel )
+{
+    switch( kernel ) {
+        case KERNEL_SCALAR: return "scalar";
+        case KERNEL_SSSE3:  return "ssse3";
+        default:            return "unknown";
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+TextCodec::encodeBase16( const uint8_t* src, uint32_t size, char* dst )
+{
+    switch( getKernel() ) {
+#if defined( MP4V2_TEXTCODEC_X86 )
+        case KERNEL_SSSE3:
+            encodeBase16Ssse3( src, size, dst );
+            break;
+#endif
+
+        default:
+            encodeBase16Scalar( src, size, dst );
+            break;
+    }
+}
+
+void
+TextCodec::encodeBase64( const uint8_t* src, uint32_t size, char* dst )
+{
+    switch( getKernel() ) {
+#if defined( MP4V2_TEXTCODEC_X86 )
+        case KERNEL_SSSE3:
+            encodeBase64Ssse3( src, size, dst );
+            break;
+#endif
+
+        default:
+            encodeBase64Scalar( src, size, dst );
+            break;
+    }
+}
+
+bool
+TextCodec::decodeBase64( const char* src, uint32_t size, uint8_t* dst, uint32_t& dstSize )
+{
+    switch( getKernel() ) {
+#if defined( MP4V2_TEXTCODEC_X86 )
+        case KERNEL_SSSE3:
+            return decodeBase64Ssse3( src, size, dst, dstSize );
+#endif
+
+        default:
+            return decodeBase64Scalar( src, size, dst, dstSize );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
@@ -0,0 +1,71 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MP4V2_IMPL_TEXTCODEC_H
+#define MP4V2_IMPL_TEXTCODEC_H
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Base16 and base64 (RFC 4648, padded, standard alphabet) kernels.
+///
+/// The fastest kernel the CPU supports is picked on first use. All kernels
+/// produce identical output; the vector ones hand the last block and
+/// anything they reject to the scalar code, so validation has a single
+/// definition. setKernel() exists for benchmarks and tests.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+class MP4V2_EXPORT TextCodec
+{
+public:
+    enum Kernel {
+        KERNEL_SCALAR,
+        KERNEL_SSSE3,   // x86, 16 bytes per step
+
+        KERNEL_MAX
+    };
+
+    static uint32_t base16Size( uint32_t size ) { return size * 2; }
+    static uint32_t base64Size( uint32_t size ) { return ( size + 2 ) / 3 * 4; }
+
+    // write exactly base16Size()/base64Size() chars, no terminator
+    static void encodeBase16 ( const uint8_t* src, uint32_t size, char* dst );
+    static void encodeBase64 ( const uint8_t* src, uint32_t size, char* dst );
+
+    // dst must hold size / 4 * 3 bytes; false unless src is canonical
+    // base64: a multiple of 4 chars, padding only at the very end and no
+    // bits set in the unused part of the last char
+    static bool decodeBase64 ( const char* src, uint32_t size, uint8_t* dst, uint32_t& dstSize );
+
+    static Kernel      getKernel   ();
+    static bool        setKernel   ( Kernel kernel ); // false if not supported
+    static bool        isSupported ( Kernel kernel );
+    static const char* kernelName  ( Kernel kernel );
+
+private:
+    static std::atomic<int> _kernel; // -1 until first use
+
+private:
+    TextCodec();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
+
+#endif // MP4V2_IMPL_TEXTCODEC_H
@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "src/impl.h"
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::atomic<MP4TraceCallback> Trace::_callback( (MP4TraceCallback)NULL );
+void*                         Trace::_userData = NULL;
+
+namespace {
+    // spans open on this thread
+    thread_local uint32_t traceDepth = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+Trace::setCallback( MP4TraceCallback callback, void* userData )
+{
+    _callback.store( NULL );
+    _userData = userData;
+    _callback.store( callback );
+}
+
+void
+Trace::begin( const char* category, const char* name, MP4FileHandle file )
+{
+    emit( MP4_TRACE_BEGIN, category, name, file, traceDepth++ );
+}
+
+void
+Trace::end( const char* category, const char* name, MP4FileHandle file )
+{
+    emit( MP4_TRACE_END, category, name, file, --traceDepth );
+}
+
+void
+Trace::emit( MP4TraceEvent event, const char* category, const char* name,
+             MP4FileHandle file, uint32_t depth )
+{
+    // the callback may have been removed since the span began
+    const MP4TraceCallback callback = _callback.load();
+    if( !callback )
+        return;
+
+    MP4TraceRecord record;
+    record.event     = event;
+    record.category  = category;
+    record.name      = name;
+    record.file      = file;
+    record.depth     = depth;
+    record.timestamp = time::getMonotonicMicroseconds();
+
+    callback( &record, _userData );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Trace callback writing the Chrome trace event format, JSON object form.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+class ChromeTrace
+{
+public:
+    static bool start ( const char* fileName );
+    static void stop  ();
+
+private:
+    static void callback ( const MP4TraceRecord* record, void* userData );
+    static void write    ( const string& text );
+    static void append   ( string& json, const char* text );
+
+private:
+    static std::mutex _mutex;
+    static File*      _file;
+    static bool       _first;
+};
+
+std::mutex ChromeTrace::_mutex;
+File*      ChromeTrace::_file  = NULL;
+bool       ChromeTrace::_first = true;
+
+// threads are numbered in order of their first event
+std::atomic<uint32_t> traceThreads( 0 );
+thread_local uint32_t traceThreadId = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ChromeTrace::start( const char* fileName )
+{
+    stop();
+
+    std::lock_guard<std::mutex> lock( _mutex );
+
+    _file = new File( fileName, File::MODE_CREATE );
+    if( _file->open() ) {
+        delete _file;
+        _file = NULL;
+        return false;
+    }
+
+    _first = true;
+    write( "{\"traceEvents\":[" );
+
+    Trace::setCallback( callback, NULL );
+    return true;
+}
+
+void
+ChromeTrace::stop()
+{
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !_file )
+        return;
+
+    Trace::setCallback( NULL, NULL );
+
+    write( "\n],\"displayTimeUnit\":\"ms\"}\n" );
+    _file->close();
+    delete _file;
+    _file = NULL;
+}
+
+void
+ChromeTrace::callback( const MP4TraceRecord* record, void* )
+{
+    if( !traceThreadId )
+        traceThreadId = ++traceThreads;
+
+    char buffer[128];
+    string json = "{\"ph\":\"";
+    json += record->event == MP4_TRACE_BEGIN ? 'B' : 'E';
+    json += "\",\"name\":\"";
+    append( json, record->name );
+    json += "\",\"cat\":\"";
+    append( json, record->category );
+    snprintf( buffer, sizeof( buffer ), "\",\"ts\":%" PRId64 ",\"pid\":1,\"tid\":%u",
+              record->timestamp, traceThreadId );
+    json += buffer;
+
+    if( record->event == MP4_TRACE_BEGIN && record->file != MP4_INVALID_FILE_HANDLE ) {
+        snprintf( buffer, sizeof( buffer ), ",\"args\":{\"file\":\"%p\"}", record->file );
+        json += buffer;
+    }
+    json += '}';
+
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( !_file )
+        return;
+
+    write( string( _first ? "\n" : ",\n" ) + json );
+    _first = false;
+}
+
+void
+ChromeTrace::write( const string& text )
+{
+    // a failing trace must not fail the traced operation
+    File::Size nout;
+    _file->write( text.data(), text.size(), nout );
+}
+
+void
+ChromeTrace::append( string& json, const char* text )
+{
+    // atom types of damaged files may hold any byte
+    for( const char* p = text; *p; p++ ) {
+        const unsigned char c = (unsigned char)*p;
+        if( c < 0x20 || c >= 0x7f || c == '"' || c == '\\' ) {
+            char escaped[8];
+            snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+            json += escaped;
+        }
+        else {
+            json += (char)c;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
+
+using namespace mp4v2::impl;
+
+extern "C"
+void MP4SetTraceCallback( MP4TraceCallback callback, void* userData )
+{
+    Trace::setCallback( callback, userData );
+}
+
+extern "C"
+bool MP4StartChromeTrace( const char* fileName )
+{
+    if( !fileName )
+        return false;
+
+    return ChromeTrace::start( fileName );
+}
+
+extern "C"
+void MP4StopChromeTrace( void )
+{
+    ChromeTrace::stop();
+}
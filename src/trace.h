@@ -0,0 +1,94 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MP4V2_IMPL_TRACE_H
+#define MP4V2_IMPL_TRACE_H
+
+namespace mp4v2 { namespace impl {
+
+///////////////////////////////////////////////////////////////////////////////
+///
+/// Span tracing, see MP4SetTraceCallback().
+///
+/// Spans are scoped TraceSpan objects. With no callback installed a span
+/// only loads the callback pointer and remembers that it was not set, so
+/// they can stay in place on per-sample paths.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+class MP4V2_EXPORT Trace
+{
+public:
+    static bool isEnabled() {
+        return _callback.load( std::memory_order_relaxed ) != NULL;
+    }
+
+    static void setCallback ( MP4TraceCallback callback, void* userData );
+
+    static void begin ( const char* category, const char* name, MP4FileHandle file );
+    static void end   ( const char* category, const char* name, MP4FileHandle file );
+
+private:
+    static void emit ( MP4TraceEvent event, const char* category, const char* name,
+                       MP4FileHandle file, uint32_t depth );
+
+private:
+    static std::atomic<MP4TraceCallback> _callback;
+    static void*                         _userData;
+
+private:
+    Trace();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class TraceSpan
+{
+public:
+    // name must stay valid for the lifetime of the span
+    TraceSpan( const char* category, const char* name, MP4FileHandle file, bool enabled = true )
+        : _active   ( enabled && Trace::isEnabled() )
+        , _category ( category )
+        , _name     ( name )
+        , _file     ( file )
+    {
+        if( _active )
+            Trace::begin( _category, _name, _file );
+    }
+
+    ~TraceSpan()
+    {
+        if( _active )
+            Trace::end( _category, _name, _file );
+    }
+
+private:
+    const bool    _active;
+    const char*   _category;
+    const char*   _name;
+    MP4FileHandle _file;
+
+private:
+    TraceSpan();
+    TraceSpan( const TraceSpan &src );
+    TraceSpan &operator= ( const TraceSpan &src );
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::impl
+
+#endif // MP4V2_IMPL_TRACE_H
@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Regression test for MP4_MODIFY_IN_PLACE: shrinking a moov that ends the
+//  file by less than a free atom header must still leave a well formed file,
+//  and a moov that outgrew its place in front of mdat must move back there
+//  once it fits again.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <mp4v2/mp4v2.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+
+int errors = 0;
+
+void
+logCallback( MP4LogLevel level, const char* fmt, va_list ap )
+{
+    if( level > MP4_LOG_ERROR )
+        return;
+
+    errors++;
+    vfprintf( stderr, fmt, ap );
+    fputc( '\n', stderr );
+}
+
+bool
+create( const char* name, const char* title )
+{
+    MP4FileHandle file = MP4Create( name );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    MP4SetTimeScale( file, 90000 );
+    const MP4TrackId track = MP4AddVideoTrack( file, 90000, 3000, 320, 240 );
+
+    uint8_t sample[100];
+    memset( sample, 0x5a, sizeof( sample ));
+    bool ok = track != MP4_INVALID_TRACK_ID;
+    for( int i = 0; ok && i < 10; i++ )
+        ok = MP4WriteSample( file, track, sample, sizeof( sample ));
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    ok = ok && MP4TagsSetName( tags, title ) && MP4TagsStore( tags, file );
+    MP4TagsFree( tags );
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+retitle( const char* name, const char* title )
+{
+    MP4FileHandle file = MP4Modify( name, MP4_MODIFY_IN_PLACE );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    const bool ok = MP4TagsFetch( tags, file ) && MP4TagsSetName( tags, title ) && MP4TagsStore( tags, file );
+    MP4TagsFree( tags );
+
+    MP4Close( file );
+    return ok;
+}
+
+bool
+load( const char* name, std::vector<uint8_t>& data )
+{
+    FILE* f = fopen( name, "rb" );
+    if( !f )
+        return false;
+
+    fseek( f, 0, SEEK_END );
+    data.resize( ftell( f ));
+    fseek( f, 0, SEEK_SET );
+    const bool ok = fread( data.data(), 1, data.size(), f ) == data.size();
+    fclose( f );
+    return ok;
+}
+
+// offset of the last top level atom, data.size() if atoms don't cover it
+size_t
+lastAtom( const std::vector<uint8_t>& data )
+{
+    size_t pos = 0;
+    size_t last = 0;
+    while( pos + 8 <= data.size() ) {
+        const uint8_t* p = &data[pos];
+        const uint32_t atomSize = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+        if( atomSize < 8 )
+            break;
+        last = pos;
+        pos += atomSize;
+    }
+    return pos == data.size() ? last : data.size();
+}
+
+// MP4Create() leaves a free atom after moov, drop it so moov ends the file
+bool
+moveMoovToEnd( const char* name )
+{
+    std::vector<uint8_t> data;
+    if( !load( name, data ))
+        return false;
+
+    const size_t last = lastAtom( data );
+    if( last == data.size() || memcmp( &data[last + 4], "free", 4 ))
+        return false;
+
+    FILE* f = fopen( name, "wb" );
+    if( !f )
+        return false;
+    const bool ok = fwrite( data.data(), 1, last, f ) == last;
+    fclose( f );
+    return ok;
+}
+
+// top level atoms must cover the file exactly
+bool
+checkLayout( const char* name )
+{
+    std::vector<uint8_t> data;
+    if( !load( name, data ))
+        return false;
+
+    if( lastAtom( data ) == data.size() ) {
+        fprintf( stderr, "%s: top level atoms don't end with the file\n", name );
+        return false;
+    }
+    return true;
+}
+
+// offset of the first top level atom of type, data.size() if none
+size_t
+findAtom( const std::vector<uint8_t>& data, const char* type )
+{
+    size_t pos = 0;
+    while( pos + 8 <= data.size() ) {
+        const uint8_t* p = &data[pos];
+        const uint32_t atomSize = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+        if( !memcmp( p + 4, type, 4 ))
+            return pos;
+        if( atomSize < 8 )
+            break;
+        pos += atomSize;
+    }
+    return data.size();
+}
+
+bool
+moovInFront( const char* name )
+{
+    std::vector<uint8_t> data;
+    return load( name, data ) && findAtom( data, "moov" ) < findAtom( data, "mdat" );
+}
+
+bool
+checkTitle( const char* name, const char* title )
+{
+    MP4FileHandle file = MP4Read( name );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    const bool ok = MP4TagsFetch( tags, file ) && tags->name && !strcmp( tags->name, title );
+    MP4TagsFree( tags );
+
+    MP4Close( file );
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+int
+main( int argc, char** argv )
+{
+    MP4SetLogCallback( logCallback );
+
+    const std::string name = std::string( argc > 1 ? argv[1] : "." ) + "/modifyinplace.mp4";
+    const char* const before = "12345678";
+
+    int failures = 0;
+    for( size_t shrink = 1; shrink < 8; shrink++ ) {
+        const std::string after( before, strlen( before ) - shrink );
+
+        errors = 0;
+        const bool ok = create( name.c_str(), before ) &&
+                        moveMoovToEnd( name.c_str() ) &&
+                        retitle( name.c_str(), after.c_str() ) &&
+                        checkLayout( name.c_str() ) &&
+                        checkTitle( name.c_str(), after.c_str() );
+
+        if( !ok || errors ) {
+            fprintf( stderr, "FAIL: moov at end of file shrunk by %u bytes\n", (unsigned)shrink );
+            failures++;
+        }
+    }
+
+    // grow moov out of its slot in front of mdat, then shrink it back
+    const std::string source = name + ".src";
+    const std::string large( 8192, 'x' );
+
+    errors = 0;
+    const bool ok = create( source.c_str(), before ) &&
+                    MP4Optimize( source.c_str(), name.c_str() ) &&
+                    retitle( name.c_str(), large.c_str() ) &&
+                    !moovInFront( name.c_str() ) &&
+                    retitle( name.c_str(), before ) &&
+                    checkLayout( name.c_str() ) &&
+                    moovInFront( name.c_str() ) &&
+                    checkTitle( name.c_str(), before );
+
+    if( !ok || errors ) {
+        fprintf( stderr, "FAIL: moov moved back in front of mdat\n" );
+        failures++;
+    }
+
+    remove( source.c_str() );
+    remove( name.c_str() );
+    return failures ? 1 : 0;
+}
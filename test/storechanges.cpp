@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Regression test for MP4TagsStoreChanges(): storing unchanged tags into a
+//  file opened with MP4_MODIFY_IN_PLACE must not write anything on close,
+//  also for tracks with sample dependency flags (sdtp).
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <mp4v2/mp4v2.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#   include <sys/utime.h>
+#else
+#   include <utime.h>
+#endif
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+
+int errors = 0;
+
+void
+logCallback( MP4LogLevel level, const char* fmt, va_list ap )
+{
+    if( level > MP4_LOG_ERROR )
+        return;
+
+    errors++;
+    vfprintf( stderr, fmt, ap );
+    fputc( '\n', stderr );
+}
+
+// an H.264 track with dependency flags, so the file gets an sdtp atom
+bool
+create( const char* name )
+{
+    MP4FileHandle file = MP4Create( name );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    MP4SetTimeScale( file, 90000 );
+    const MP4TrackId track = MP4AddH264VideoTrack( file, 90000, 3000, 320, 240, 66, 0xc0, 30, 3 );
+
+    uint8_t sample[100];
+    memset( sample, 0x5a, sizeof( sample ));
+    bool ok = track != MP4_INVALID_TRACK_ID;
+    for( int i = 0; ok && i < 100; i++ ) {
+        const bool sync = i % 30 == 0;
+        ok = MP4WriteSampleDependency( file, track, sample, sizeof( sample ), 3000, 0, sync, sync ? 0x20 : 0x10 );
+    }
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    ok = ok && MP4TagsSetName( tags, "title" ) && MP4TagsStore( tags, file );
+    MP4TagsFree( tags );
+
+    MP4Close( file );
+    return ok;
+}
+
+// store the tags as they are, nothing may change
+bool
+storeUnchanged( const char* name )
+{
+    MP4FileHandle file = MP4Modify( name, MP4_MODIFY_IN_PLACE );
+    if( file == MP4_INVALID_FILE_HANDLE )
+        return false;
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    bool changed = true;
+    const bool ok = MP4TagsFetch( tags, file ) && MP4TagsStoreChanges( tags, file, &changed );
+    MP4TagsFree( tags );
+
+    MP4Close( file );
+
+    if( changed )
+        fprintf( stderr, "%s: unchanged tags reported as changed\n", name );
+    return ok && !changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+int
+main( int argc, char** argv )
+{
+    MP4SetLogCallback( logCallback );
+
+    const std::string name = std::string( argc > 1 ? argv[1] : "." ) + "/storechanges.mp4";
+
+    bool ok = create( name.c_str() );
+
+    // any write moves the modification time away from this one
+    const time_t stamp = 1000000000;
+    struct utimbuf times;
+    times.actime  = stamp;
+    times.modtime = stamp;
+    ok = ok && utime( name.c_str(), &times ) == 0;
+
+    ok = ok && storeUnchanged( name.c_str() );
+
+    struct stat st;
+    if( ok && ( stat( name.c_str(), &st ) || st.st_mtime != stamp )) {
+        fprintf( stderr, "%s: file was written\n", name.c_str() );
+        ok = false;
+    }
+
+    if( !ok || errors )
+        fprintf( stderr, "FAIL: no-op tag store on a file with sdtp\n" );
+
+    remove( name.c_str() );
+    return ok && !errors ? 0 : 1;
+}
@@ -0,0 +1,722 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+//
+//  mp4v2_bench - performance suite
+//
+//  Synthetic files are generated in-process, then the common read and write
+//  paths of the public API are timed on them. Results are printed as JSON
+//  in the layout of Google Benchmark, so existing tooling can compare runs.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "util/impl.h"
+
+using namespace mp4v2::util;
+using mp4v2::impl::TextCodec;
+
+namespace {
+
+///////////////////////////////////////////////////////////////////////////////
+
+struct Options {
+    string   dir;
+    string   filter;
+    uint32_t numSamples;
+    uint32_t numTracks;
+    uint32_t sampleSize;
+    double   minTime;
+    bool     keep;
+};
+
+// synthetic file layouts
+struct Dataset {
+    const char* name;
+    uint32_t    createFlags;
+    uint32_t    numTracks;      // 0 for Options::numTracks
+    uint32_t    numSamples;     // per track, 0 for Options::numSamples
+    bool        chunkPerSample; // many small interleaved chunks
+    string      fileName;       // set by runDataset()
+};
+
+struct Result {
+    string   name;
+    uint64_t iterations;
+    double   realTime;  // microseconds per iteration
+    double   cpuTime;   // microseconds per iteration
+    uint64_t items;     // per iteration
+    uint64_t bytes;     // per iteration
+};
+
+const uint32_t TIMESCALE = 90000;
+const uint32_t DURATION  = 3000; // 30 fps
+
+Options        options;
+vector<Result> results;
+
+///////////////////////////////////////////////////////////////////////////////
+
+// deterministic sequence, runs must be comparable
+class Random {
+public:
+    explicit Random( uint32_t seed ) : _state( seed ) { }
+
+    uint32_t next( uint32_t range ) {
+        _state = _state * 1664525 + 1013904223;
+        return (_state >> 8) % range;
+    }
+
+private:
+    uint32_t _state;
+};
+
+uint32_t
+sampleSize( Random& random )
+{
+    // between half and one and a half of the average
+    return options.sampleSize / 2 + random.next( options.sampleSize + 1 );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// one benchmark, run repeatedly until options.minTime has passed
+class Benchmark {
+public:
+    virtual ~Benchmark() { }
+    virtual bool run() = 0;
+
+    uint64_t items;
+    uint64_t bytes;
+
+protected:
+    Benchmark() : items( 0 ), bytes( 0 ) { }
+};
+
+bool
+measure( const string& name, Benchmark& bm )
+{
+    if( !options.filter.empty() && name.find( options.filter ) == string::npos )
+        return true;
+
+    uint64_t iterations = 0;
+    double   elapsed    = 0;
+    clock_t  cpuStart   = clock();
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    do {
+        if( !bm.run() ) {
+            fprintf( stderr, "mp4v2_bench: %s failed\n", name.c_str() );
+            return false;
+        }
+        iterations++;
+        elapsed = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+    } while( elapsed < options.minTime * 1e6 );
+
+    Result r;
+    r.name       = name;
+    r.iterations = iterations;
+    r.realTime   = elapsed / iterations;
+    r.cpuTime    = double( clock() - cpuStart ) * 1e6 / CLOCKS_PER_SEC / iterations;
+    r.items      = bm.items;
+    r.bytes      = bm.bytes;
+    results.push_back( r );
+
+    fprintf( stderr, "%-40s %10.0f us %8" PRIu64 " iterations\n", name.c_str(), r.realTime, iterations );
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// muxing through MP4WriteSample(), leaves the file for the other benchmarks
+class Mux : public Benchmark {
+public:
+    explicit Mux( const Dataset& ds ) : _ds( ds ) { }
+
+    bool run() {
+        MP4FileHandle file = MP4Create( _ds.fileName.c_str(), _ds.createFlags );
+        if( file == MP4_INVALID_FILE_HANDLE )
+            return false;
+
+        MP4SetTimeScale( file, TIMESCALE );
+
+        const uint32_t numTracks  = _ds.numTracks ? _ds.numTracks : options.numTracks;
+        const uint32_t numSamples = _ds.numSamples ? _ds.numSamples : options.numSamples;
+
+        vector<MP4TrackId> tracks;
+        for( uint32_t i = 0; i < numTracks; i++ ) {
+            const MP4TrackId id = MP4AddVideoTrack( file, TIMESCALE, DURATION, 640, 480 );
+            if( id == MP4_INVALID_TRACK_ID ) {
+                MP4Close( file );
+                return false;
+            }
+            if( _ds.chunkPerSample )
+                MP4SetTrackDurationPerChunk( file, id, DURATION );
+            tracks.push_back( id );
+        }
+
+        vector<uint8_t> buffer( options.sampleSize * 2 + 1, 0x5a );
+        Random random( 1 );
+
+        items = 0;
+        bytes = 0;
+        bool ok = true;
+        for( uint32_t sampleId = 1; ok && sampleId <= numSamples; sampleId++ ) {
+            // tracks interleave sample by sample
+            for( uint32_t i = 0; ok && i < numTracks; i++ ) {
+                const uint32_t size = sampleSize( random );
+                ok = MP4WriteSample( file, tracks[i], &buffer[0], size, DURATION, 0, sampleId % 30 == 1 );
+                items++;
+                bytes += size;
+            }
+        }
+
+        const MP4Tags* tags = MP4TagsAlloc();
+        MP4TagsSetName( tags, _ds.name );
+        MP4TagsSetArtist( tags, "mp4v2_bench" );
+        MP4TagsSetComments( tags, "synthetic file" );
+        ok = ok && MP4TagsStore( tags, file );
+        MP4TagsFree( tags );
+
+        MP4Close( file );
+        return ok;
+    }
+
+private:
+    const Dataset& _ds;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class Open : public Benchmark {
+public:
+    explicit Open( const Dataset& ds ) : _ds( ds ) { items = 1; }
+
+    bool run() {
+        MP4FileHandle file = MP4Read( _ds.fileName.c_str() );
+        if( file == MP4_INVALID_FILE_HANDLE )
+            return false;
+        MP4Close( file );
+        return true;
+    }
+
+private:
+    const Dataset& _ds;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// benchmarks working on an open file and its samples
+class OpenFileBenchmark : public Benchmark {
+public:
+    explicit OpenFileBenchmark( const Dataset& ds )
+        : _file( MP4Read( ds.fileName.c_str() ))
+    {
+        if( _file == MP4_INVALID_FILE_HANDLE )
+            return;
+
+        uint32_t maxSampleSize = 0;
+        const uint32_t numTracks = MP4GetNumberOfTracks( _file );
+        for( uint32_t i = 0; i < numTracks; i++ ) {
+            const MP4TrackId id = MP4FindTrackId( _file, i );
+            maxSampleSize = max( maxSampleSize, MP4GetTrackMaxSampleSize( _file, id ));
+
+            const uint32_t numSamples = MP4GetTrackNumberOfSamples( _file, id );
+            for( MP4SampleId sampleId = 1; sampleId <= numSamples; sampleId++ ) {
+                Sample s = { id, sampleId };
+                _samples.push_back( s );
+            }
+        }
+
+        _buffer.resize( maxSampleSize );
+        items = _samples.size();
+    }
+
+    ~OpenFileBenchmark() {
+        MP4Close( _file );
+    }
+
+protected:
+    struct Sample {
+        MP4TrackId  trackId;
+        MP4SampleId sampleId;
+    };
+
+    bool readSample( const Sample& s ) {
+        uint8_t* pBytes = &_buffer[0];
+        uint32_t numBytes = (uint32_t)_buffer.size();
+        if( !MP4ReadSample( _file, s.trackId, s.sampleId, &pBytes, &numBytes ))
+            return false;
+        bytes += numBytes;
+        return true;
+    }
+
+    MP4FileHandle   _file;
+    vector<Sample>  _samples;
+    vector<uint8_t> _buffer;
+};
+
+class ReadSequential : public OpenFileBenchmark {
+public:
+    explicit ReadSequential( const Dataset& ds ) : OpenFileBenchmark( ds ) { }
+
+    bool run() {
+        if( _file == MP4_INVALID_FILE_HANDLE )
+            return false;
+
+        bytes = 0;
+        const vector<Sample>::size_type max = _samples.size();
+        for( vector<Sample>::size_type i = 0; i < max; i++ ) {
+            if( !readSample( _samples[i] ))
+                return false;
+        }
+        return true;
+    }
+};
+
+class ReadRandom : public OpenFileBenchmark {
+public:
+    explicit ReadRandom( const Dataset& ds ) : OpenFileBenchmark( ds ) {
+        Random random( 2 );
+        for( vector<Sample>::size_type i = _samples.size(); i > 1; i-- )
+            swap( _samples[i - 1], _samples[random.next( (uint32_t)i )] );
+    }
+
+    bool run() {
+        if( _file == MP4_INVALID_FILE_HANDLE )
+            return false;
+
+        bytes = 0;
+        const vector<Sample>::size_type max = _samples.size();
+        for( vector<Sample>::size_type i = 0; i < max; i++ ) {
+            if( !readSample( _samples[i] ))
+                return false;
+        }
+        return true;
+    }
+};
+
+class SampleIdFromTime : public OpenFileBenchmark {
+public:
+    explicit SampleIdFromTime( const Dataset& ds ) : OpenFileBenchmark( ds ) {
+        Random random( 3 );
+        const vector<Sample>::size_type max = _samples.size();
+        for( vector<Sample>::size_type i = 0; i < max; i++ ) {
+            Lookup l;
+            l.trackId = _samples[i].trackId;
+            l.when = MP4Timestamp( random.next( MP4GetTrackNumberOfSamples( _file, l.trackId ))) * DURATION;
+            _lookups.push_back( l );
+        }
+    }
+
+    bool run() {
+        if( _file == MP4_INVALID_FILE_HANDLE )
+            return false;
+
+        const vector<Lookup>::size_type max = _lookups.size();
+        for( vector<Lookup>::size_type i = 0; i < max; i++ ) {
+            if( MP4GetSampleIdFromTime( _file, _lookups[i].trackId, _lookups[i].when ) == MP4_INVALID_SAMPLE_ID )
+                return false;
+        }
+        return true;
+    }
+
+private:
+    struct Lookup {
+        MP4TrackId   trackId;
+        MP4Timestamp when;
+    };
+
+    vector<Lookup> _lookups;
+};
+
+class TagsFetch : public OpenFileBenchmark {
+public:
+    explicit TagsFetch( const Dataset& ds ) : OpenFileBenchmark( ds ) { items = 1; }
+
+    bool run() {
+        const MP4Tags* tags = MP4TagsAlloc();
+        const bool ok = MP4TagsFetch( tags, _file ) && tags->name;
+        MP4TagsFree( tags );
+        return ok;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+class TagsStore : public Benchmark {
+public:
+    explicit TagsStore( const Dataset& ds ) : _ds( ds ), _count( 0 ) { items = 1; }
+
+    bool run() {
+        MP4FileHandle file = MP4Modify( _ds.fileName.c_str() );
+        if( file == MP4_INVALID_FILE_HANDLE )
+            return false;
+
+        const MP4Tags* tags = MP4TagsAlloc();
+        bool ok = MP4TagsFetch( tags, file );
+
+        // alternate lengths, so both growing and shrinking are covered
+        ok = ok && MP4TagsSetComments( tags, ++_count % 2 ? "synthetic file, modified" : "synthetic file" );
+        ok = ok && MP4TagsStore( tags, file );
+        MP4TagsFree( tags );
+
+        MP4Close( file );
+        return ok;
+    }
+
+private:
+    const Dataset& _ds;
+    uint32_t       _count;
+};
+
+class Optimize : public Benchmark {
+public:
+    explicit Optimize( const Dataset& ds ) : _ds( ds ), _dstName( ds.fileName + ".optimized" ) {
+        items = 1;
+
+        File::Size size = 0;
+        FileSystem::getFileSize( _ds.fileName, size );
+        bytes = size;
+    }
+
+    ~Optimize() {
+        if( !options.keep )
+            remove( _dstName.c_str() );
+    }
+
+    bool run() {
+        return MP4Optimize( _ds.fileName.c_str(), _dstName.c_str() );
+    }
+
+private:
+    const Dataset& _ds;
+    const string   _dstName;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+// text codec kernels, on random data so the decode input is valid base64
+class Codec : public Benchmark {
+public:
+    explicit Codec( uint32_t size ) : _binary( size ), _text( TextCodec::base64Size( size ))
+    {
+        items = 1;
+        bytes = size;
+
+        Random random( size );
+        for( uint32_t i = 0; i < size; i++ )
+            _binary[i] = uint8_t( random.next( 256 ));
+        TextCodec::encodeBase64( &_binary[0], size, &_text[0] );
+    }
+
+protected:
+    vector<uint8_t> _binary;
+    vector<char>    _text;
+};
+
+class Base16Encode : public Codec {
+public:
+    explicit Base16Encode( uint32_t size ) : Codec( size ), _out( TextCodec::base16Size( size )) { }
+
+    bool run() {
+        TextCodec::encodeBase16( &_binary[0], uint32_t( _binary.size() ), &_out[0] );
+        return true;
+    }
+
+private:
+    vector<char> _out;
+};
+
+class Base64Encode : public Codec {
+public:
+    explicit Base64Encode( uint32_t size ) : Codec( size ) { }
+
+    bool run() {
+        TextCodec::encodeBase64( &_binary[0], uint32_t( _binary.size() ), &_text[0] );
+        return true;
+    }
+};
+
+class Base64Decode : public Codec {
+public:
+    explicit Base64Decode( uint32_t size ) : Codec( size ) { }
+
+    bool run() {
+        uint32_t size = 0;
+        return TextCodec::decodeBase64( &_text[0], uint32_t( _text.size() ), &_binary[0], size )
+            && size == _binary.size();
+    }
+};
+
+class Checksum : public Benchmark {
+public:
+    explicit Checksum( uint32_t size ) : _data( size ), _expected( 0 )
+    {
+        items = 1;
+        bytes = size;
+
+        Random random( size );
+        for( uint32_t i = 0; i < size; i++ )
+            _data[i] = uint8_t( random.next( 256 ));
+
+        // every kernel is checked against the table one
+        const Crc32::Kernel kernel = Crc32::getKernel();
+        Crc32::setKernel( Crc32::KERNEL_TABLE );
+        _expected = crc32( &_data[0], size );
+        Crc32::setKernel( kernel );
+    }
+
+    bool run() {
+        return crc32( &_data[0], uint32_t( _data.size() )) == _expected;
+    }
+
+private:
+    vector<unsigned char> _data;
+    uint32_t              _expected;
+};
+
+template <class T>
+bool
+measure( const char* name, const char* kernel, uint32_t size )
+{
+    T bm( size );
+    return measure( string( name ) + "/" + kernel + "/" + to_string( size ), bm );
+}
+
+// every supported kernel, the scalar one is the baseline
+bool
+runCodecs()
+{
+    static const uint32_t sizes[] = { 64, 65536 };
+
+    const TextCodec::Kernel saved = TextCodec::getKernel();
+
+    bool ok = true;
+    for( int k = 0; ok && k < TextCodec::KERNEL_MAX; k++ ) {
+        const TextCodec::Kernel kernel = TextCodec::Kernel( k );
+        if( !TextCodec::setKernel( kernel ))
+            continue;
+
+        for( size_t i = 0; ok && i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+            const char* const name = TextCodec::kernelName( kernel );
+            ok = measure<Base16Encode>( "base16_encode", name, sizes[i] ) &&
+                 measure<Base64Encode>( "base64_encode", name, sizes[i] ) &&
+                 measure<Base64Decode>( "base64_decode", name, sizes[i] );
+        }
+    }
+
+    TextCodec::setKernel( saved );
+    return ok;
+}
+
+// every supported kernel, the table one is the baseline
+bool
+runChecksums()
+{
+    static const uint32_t sizes[] = { 64, 65536 };
+
+    const Crc32::Kernel saved = Crc32::getKernel();
+
+    bool ok = true;
+    for( int k = 0; ok && k < Crc32::KERNEL_MAX; k++ ) {
+        const Crc32::Kernel kernel = Crc32::Kernel( k );
+        if( !Crc32::setKernel( kernel ))
+            continue;
+
+        for( size_t i = 0; ok && i < sizeof( sizes ) / sizeof( sizes[0] ); i++ )
+            ok = measure<Checksum>( "crc32", Crc32::kernelName( kernel ), sizes[i] );
+    }
+
+    Crc32::setKernel( saved );
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+template <class T>
+bool
+measure( const char* name, const Dataset& ds )
+{
+    T bm( ds );
+    return measure( string( name ) + "/" + ds.name, bm );
+}
+
+bool
+runDataset( Dataset& ds )
+{
+    ds.fileName = options.dir + FileSystem::DIR_SEPARATOR + "mp4v2_bench_" + ds.name + ".mp4";
+
+    // the mux benchmark creates the file, it cannot be filtered out
+    Mux mux( ds );
+    if( !mux.run() ) {
+        fprintf( stderr, "mp4v2_bench: cannot create %s\n", ds.fileName.c_str() );
+        return false;
+    }
+    if( !measure( string( "mux/" ) + ds.name, mux ))
+        return false;
+
+    const bool ok =
+        measure<Open>( "open", ds ) &&
+        measure<ReadSequential>( "read_sequential", ds ) &&
+        measure<ReadRandom>( "read_random", ds ) &&
+        measure<SampleIdFromTime>( "sample_id_from_time", ds ) &&
+        measure<TagsFetch>( "tags_fetch", ds ) &&
+        measure<TagsStore>( "tags_store", ds ) &&
+        measure<Optimize>( "optimize", ds );
+
+    if( !options.keep )
+        remove( ds.fileName.c_str() );
+    return ok;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+printJson()
+{
+    char date[64];
+    const time_t now = ::time( NULL );
+    strftime( date, sizeof( date ), "%Y-%m-%dT%H:%M:%S", localtime( &now ));
+
+    printf( "{\n" );
+    printf( "  \"context\": {\n" );
+    printf( "    \"date\": \"%s\",\n", date );
+    printf( "    \"executable\": \"mp4v2_bench\",\n" );
+    printf( "    \"mp4v2_version\": \"%s\",\n", MP4V2_PROJECT_version );
+    printf( "    \"num_cpus\": %u,\n", thread::hardware_concurrency() );
+    printf( "    \"samples\": %u,\n", options.numSamples );
+    printf( "    \"tracks\": %u,\n", options.numTracks );
+    printf( "    \"sample_size\": %u\n", options.sampleSize );
+    printf( "  },\n" );
+    printf( "  \"benchmarks\": [" );
+
+    const vector<Result>::size_type max = results.size();
+    for( vector<Result>::size_type i = 0; i < max; i++ ) {
+        const Result& r = results[i];
+        const double seconds = r.realTime / 1e6;
+
+        printf( "%s\n    {\n", i ? "," : "" );
+        printf( "      \"name\": \"%s\",\n", r.name.c_str() );
+        printf( "      \"run_name\": \"%s\",\n", r.name.c_str() );
+        printf( "      \"run_type\": \"iteration\",\n" );
+        printf( "      \"iterations\": %" PRIu64 ",\n", r.iterations );
+        printf( "      \"real_time\": %.3f,\n", r.realTime );
+        printf( "      \"cpu_time\": %.3f,\n", r.cpuTime );
+        printf( "      \"time_unit\": \"us\"" );
+        if( r.items && seconds > 0 )
+            printf( ",\n      \"items_per_second\": %.1f", r.items / seconds );
+        if( r.bytes && seconds > 0 )
+            printf( ",\n      \"bytes_per_second\": %.1f", r.bytes / seconds );
+        printf( "\n    }" );
+    }
+
+    printf( "\n  ]\n}\n" );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+extern "C" int main( int argc, char** argv )
+{
+    const char* const usageString =
+        "[--dir=DIR] [--filter=TEXT] [--samples=N] [--tracks=N] [--sample-size=N]\n"
+        "       [--min-time=SECONDS] [--keep]";
+
+    options.dir        = ".";
+    options.numSamples = 20000;
+    options.numTracks  = 1000;
+    options.sampleSize = 1500;
+    options.minTime    = 0.5;
+    options.keep       = false;
+
+    char* ProgName = argv[0];
+    while ( true ) {
+        int c = -1;
+        int option_index = 0;
+        static const prog::Option long_options[] = {
+            { "dir",         prog::Option::REQUIRED_ARG, 0, 'd' },
+            { "filter",      prog::Option::REQUIRED_ARG, 0, 'f' },
+            { "samples",     prog::Option::REQUIRED_ARG, 0, 'n' },
+            { "tracks",      prog::Option::REQUIRED_ARG, 0, 't' },
+            { "sample-size", prog::Option::REQUIRED_ARG, 0, 's' },
+            { "min-time",    prog::Option::REQUIRED_ARG, 0, 'm' },
+            { "keep",        prog::Option::NO_ARG,       0, 'k' },
+            { "version",     prog::Option::NO_ARG,       0, 'V' },
+            { NULL, prog::Option::NO_ARG, 0, 0 }
+        };
+
+        c = prog::getOptionSingle( argc, argv, "d:f:n:t:s:m:kV", long_options, &option_index );
+
+        if ( c == -1 )
+            break;
+
+        switch ( c ) {
+            case 'd':
+                options.dir = prog::optarg;
+                break;
+            case 'f':
+                options.filter = prog::optarg;
+                break;
+            case 'n':
+                options.numSamples = (uint32_t)strtoul( prog::optarg, NULL, 10 );
+                break;
+            case 't':
+                options.numTracks = (uint32_t)strtoul( prog::optarg, NULL, 10 );
+                break;
+            case 's':
+                options.sampleSize = (uint32_t)strtoul( prog::optarg, NULL, 10 );
+                break;
+            case 'm':
+                options.minTime = strtod( prog::optarg, NULL );
+                break;
+            case 'k':
+                options.keep = true;
+                break;
+            case '?':
+                fprintf( stderr, "usage: %s %s\n", ProgName, usageString );
+                exit( 0 );
+            case 'V':
+                fprintf( stderr, "%s - %s\n", ProgName, MP4V2_PROJECT_name_formal );
+                exit( 0 );
+            default:
+                fprintf( stderr, "%s: unknown option specified, ignoring: %c\n",
+                         ProgName, c );
+        }
+    }
+
+    if ( options.numSamples == 0 || options.numTracks == 0 || options.sampleSize == 0 ) {
+        fprintf( stderr, "usage: %s %s\n", ProgName, usageString );
+        exit( 1 );
+    }
+
+    // errors are reported by the benchmark that hits them
+    MP4LogSetLevel( MP4_LOG_NONE );
+
+    Dataset datasets[] = {
+        // name           flags                   tracks samples chunkPerSample fileName
+        { "flat32",       0,                      1,     0,      false,         "" },
+        { "flat64",       MP4_CREATE_64BIT_DATA,  1,     0,      false,         "" },
+        { "interleaved",  0,                      2,     0,      true,          "" },
+        { "many_tracks",  0,                      0,     10,     false,         "" },
+    };
+
+    bool ok = runCodecs() && runChecksums();
+    for( size_t i = 0; ok && i < sizeof( datasets ) / sizeof( datasets[0] ); i++ )
+        ok = runDataset( datasets[i] );
+
+    printJson();
+    return ok ? 0 : 1;
+}
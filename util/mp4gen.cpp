@@ -0,0 +1,528 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "util/impl.h"
+
+namespace mp4v2 { namespace util {
+
+///////////////////////////////////////////////////////////////////////////////
+
+class GenUtility : public Utility
+{
+private:
+    enum GenLongCode {
+        LC_VIDEO = _LC_MAX,
+        LC_AUDIO,
+        LC_DURATION,
+        LC_FPS,
+        LC_VIDEO_SIZE,
+        LC_AUDIO_SIZE,
+        LC_SIZES,
+        LC_GOP,
+        LC_CHUNK,
+        LC_64BIT,
+        LC_TAGS,
+        LC_ART,
+        LC_SEED,
+        LC_ASYNC,
+    };
+
+    enum Distribution {
+        DIST_CONSTANT, // every sample has the average size
+        DIST_UNIFORM,  // between half and one and a half of the average
+        DIST_GOP,      // sync samples 8x the size of the others
+    };
+
+    // one track being generated
+    struct Track {
+        MP4TrackId  id;
+        bool        video;
+        uint32_t    timeScale;
+        MP4Duration sampleDuration;
+        uint32_t    averageSize;
+        uint64_t    numSamples;
+        uint64_t    sampleCount;   // samples written so far
+    };
+
+public:
+    GenUtility( int, char** );
+
+protected:
+    // delegates implementation
+    bool utility_option( int, bool& );
+    bool utility_job( JobContext& );
+
+private:
+    bool addTracks     ( JobContext&, vector<Track>& );
+    bool writeSamples  ( JobContext&, vector<Track>& );
+    bool writeMetadata ( JobContext& );
+
+    uint32_t random( uint32_t );
+    uint32_t sampleSize( const Track&, bool );
+    bool     parseNumber( const char*, uint64_t&, const char* );
+
+private:
+    Group _parmGroup;
+
+    uint32_t     _numVideo;
+    uint32_t     _numAudio;
+    uint64_t     _duration;    // seconds
+    uint32_t     _fps;
+    uint32_t     _videoSize;
+    uint32_t     _audioSize;
+    Distribution _distribution;
+    uint32_t     _gop;
+    uint32_t     _chunkMs;     // 0 for the library default
+    bool         _64bit;
+    uint32_t     _numTags;
+    uint32_t     _artSize;
+    uint32_t     _seed;
+    bool         _async;
+
+    uint32_t        _random;
+    vector<uint8_t> _buffer; // sample data, shared by all samples
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+GenUtility::GenUtility( int argc, char** argv )
+    : Utility       ( "mp4gen", argc, argv )
+    , _parmGroup    ( "GENERATOR PARAMETERS" )
+    , _numVideo     ( 1 )
+    , _numAudio     ( 1 )
+    , _duration     ( 60 )
+    , _fps          ( 30 )
+    , _videoSize    ( 20000 )
+    , _audioSize    ( 400 )
+    , _distribution ( DIST_GOP )
+    , _gop          ( 30 )
+    , _chunkMs      ( 0 )
+    , _64bit        ( false )
+    , _numTags      ( 0 )
+    , _artSize      ( 0 )
+    , _seed         ( 1 )
+    , _async        ( false )
+    , _random       ( 1 )
+{
+    // add standard options which make sense for this utility
+    _group.add( STD_OPTIMIZE );
+    _group.add( STD_DRYRUN );
+    _group.add( STD_KEEPGOING );
+    _group.add( STD_OVERWRITE );
+    _group.add( STD_FORCE );
+    _group.add( STD_QUIET );
+    _group.add( STD_DEBUG );
+    _group.add( STD_VERBOSE );
+    _group.add( STD_HELP );
+    _group.add( STD_VERSION );
+    _group.add( STD_VERSIONX );
+
+    _parmGroup.add( "video",      true,  LC_VIDEO,      "number of video tracks (default: 1)", "NUM" );
+    _parmGroup.add( "audio",      true,  LC_AUDIO,      "number of audio tracks (default: 1)", "NUM" );
+    _parmGroup.add( "duration",   true,  LC_DURATION,   "duration in seconds (default: 60)", "SEC" );
+    _parmGroup.add( "fps",        true,  LC_FPS,        "video frames per second (default: 30)", "NUM" );
+    _parmGroup.add( "video-size", true,  LC_VIDEO_SIZE, "average video sample size (default: 20000)", "BYTES" );
+    _parmGroup.add( "audio-size", true,  LC_AUDIO_SIZE, "average audio sample size (default: 400)", "BYTES" );
+    _parmGroup.add( "sizes",      true,  LC_SIZES,      "sample size distribution: constant, uniform, gop (default)", "DIST" );
+    _parmGroup.add( "gop",        true,  LC_GOP,        "video samples per sync sample (default: 30)", "NUM" );
+    _parmGroup.add( "chunk",      true,  LC_CHUNK,      "chunk duration in milliseconds (default: library)", "MS" );
+    _parmGroup.add( "64bit",      false, LC_64BIT,      "use 64-bit chunk offsets from the start" );
+    _parmGroup.add( "tags",       true,  LC_TAGS,       "number of freeform metadata items (default: 0)", "NUM" );
+    _parmGroup.add( "art",        true,  LC_ART,        "add cover-art of BYTES size", "BYTES" );
+    _parmGroup.add( "seed",       true,  LC_SEED,       "seed for sample sizes and data (default: 1)", "NUM" );
+    _parmGroup.add( "async",      false, LC_ASYNC,      "write chunk data on a background thread" );
+    _groups.push_back( &_parmGroup );
+
+    _usage = "[OPTION]... file...";
+    _description =
+        // 79-cols, inclusive, max desired width
+        // |----------------------------------------------------------------------------|
+        "\nFor each mp4 file specified, generate a synthetic file with the specified"
+        "\nparameters. Files are identical for identical parameters, the same seed"
+        "\nalways yields the same sample sizes and data."
+        "\n"
+        "\nVideo tracks use a 90000 timescale, audio tracks 48000 with 1024 samples"
+        "\nper frame, i.e. 1M audio samples take about 6 hours."
+        "\n"
+        "\nFiles grow past 4 GiB by themselves if the samples call for it, chunk"
+        "\noffsets then switch to 64-bit as needed.";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+GenUtility::addTracks( JobContext& job, vector<Track>& tracks )
+{
+    for( uint32_t i = 0; i < _numVideo + _numAudio; i++ ) {
+        Track track;
+        track.video       = i < _numVideo;
+        track.sampleCount = 0;
+
+        if( track.video ) {
+            track.timeScale      = 90000;
+            track.sampleDuration = 90000 / _fps;
+            track.averageSize    = _videoSize;
+            track.id = MP4AddVideoTrack( job.fileHandle, track.timeScale, track.sampleDuration, 1920, 1080 );
+        }
+        else {
+            track.timeScale      = 48000;
+            track.sampleDuration = 1024;
+            track.averageSize    = _audioSize;
+            track.id = MP4AddAudioTrack( job.fileHandle, track.timeScale, track.sampleDuration );
+        }
+
+        if( track.id == MP4_INVALID_TRACK_ID )
+            return herrf( "unable to add track: %s\n", job.file.c_str() );
+
+        // AAC-LC, 48 kHz, stereo
+        const uint8_t audioConfig[] = { 0x11, 0x90 };
+        if( !track.video && !MP4SetTrackESConfiguration( job.fileHandle, track.id, audioConfig, sizeof( audioConfig )))
+            return herrf( "unable to set audio configuration: %s\n", job.file.c_str() );
+
+        track.numSamples = ( _duration * track.timeScale + track.sampleDuration - 1 ) / track.sampleDuration;
+
+        if( _chunkMs && !MP4SetTrackDurationPerChunk( job.fileHandle, track.id, uint64_t( _chunkMs ) * track.timeScale / 1000 ))
+            return herrf( "unable to set chunk duration: %s\n", job.file.c_str() );
+
+        tracks.push_back( track );
+    }
+
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+GenUtility::writeSamples( JobContext& job, vector<Track>& tracks )
+{
+    // samples are written in time order across all tracks, as a recorder
+    // would; the queue holds (start time in microseconds, track index)
+    typedef pair<uint64_t, uint32_t> Next;
+    priority_queue<Next, vector<Next>, greater<Next> > queue;
+
+    for( uint32_t i = 0; i < tracks.size(); i++ ) {
+        if( tracks[i].numSamples )
+            queue.push( Next( 0, i ));
+    }
+
+    uint64_t numSamples = 0;
+    uint64_t numBytes   = 0;
+
+    while( !queue.empty() ) {
+        const uint32_t index = queue.top().second;
+        queue.pop();
+
+        Track& track = tracks[index];
+        const bool isSync = !track.video || track.sampleCount % _gop == 0;
+        const uint32_t size = sampleSize( track, isSync );
+
+        // the data differs from sample to sample without being rewritten
+        const uint32_t offset = random( (uint32_t)_buffer.size() - size + 1 );
+
+        if( !MP4WriteSampleRef( job.fileHandle, track.id, &_buffer[offset], size,
+                                NULL, NULL, track.sampleDuration, 0, isSync ))
+        {
+            return herrf( "unable to write sample: %s\n", job.file.c_str() );
+        }
+
+        numSamples++;
+        numBytes += size;
+
+        if( ++track.sampleCount < track.numSamples ) {
+            const uint64_t when = track.sampleCount * track.sampleDuration * 1000000 / track.timeScale;
+            queue.push( Next( when, index ));
+        }
+    }
+
+    verbose2f( "wrote %" PRIu64 " samples, %" PRIu64 " bytes: %s\n", numSamples, numBytes, job.file.c_str() );
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+GenUtility::writeMetadata( JobContext& job )
+{
+    const MP4Tags* tags = MP4TagsAlloc();
+    MP4TagsSetName( tags, "mp4gen" );
+    MP4TagsSetArtist( tags, "mp4gen" );
+    MP4TagsSetEncodingTool( tags, MP4V2_PROJECT_name_formal );
+
+    vector<uint8_t> art;
+    if( _artSize ) {
+        // a JPEG header is enough for readers sniffing the type
+        art.resize( _artSize );
+        for( uint32_t i = 0; i < _artSize; i++ )
+            art[i] = uint8_t( random( 256 ));
+        const uint8_t soi[] = { 0xff, 0xd8, 0xff, 0xe0 };
+        memcpy( &art[0], soi, min( (uint32_t)sizeof( soi ), _artSize ));
+
+        MP4TagArtwork artwork;
+        artwork.data = &art[0];
+        artwork.size = _artSize;
+        artwork.type = MP4_ART_JPEG;
+        MP4TagsAddArtwork( tags, &artwork );
+    }
+
+    const bool stored = MP4TagsStore( tags, job.fileHandle );
+    MP4TagsFree( tags );
+    if( !stored )
+        return herrf( "unable to store tags: %s\n", job.file.c_str() );
+
+    for( uint32_t i = 0; i < _numTags; i++ ) {
+        char name[32];
+        char value[64];
+        snprintf( name, sizeof( name ), "item%u", i );
+        snprintf( value, sizeof( value ), "value %u of %u, seed %u", i, _numTags, _seed );
+
+        MP4ItmfItem* item = MP4ItmfItemAlloc( "----", 1 );
+        item->mean = strdup( "org.mp4v2.mp4gen" );
+        item->name = strdup( name );
+
+        MP4ItmfData* data = &item->dataList.elements[0];
+        data->typeCode  = MP4_ITMF_BT_UTF8;
+        data->valueSize = (uint32_t)strlen( value );
+        data->value     = (uint8_t*)malloc( data->valueSize );
+        memcpy( data->value, value, data->valueSize );
+
+        const bool added = MP4ItmfAddItem( job.fileHandle, item );
+        MP4ItmfItemFree( item );
+        if( !added )
+            return herrf( "unable to add metadata item: %s\n", job.file.c_str() );
+    }
+
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+uint32_t
+GenUtility::random( uint32_t range )
+{
+    _random = _random * 1664525 + 1013904223;
+    return (_random >> 8) % range;
+}
+
+uint32_t
+GenUtility::sampleSize( const Track& track, bool isSync )
+{
+    switch( _distribution ) {
+        case DIST_CONSTANT:
+            return track.averageSize;
+
+        case DIST_UNIFORM:
+        default:
+            return track.averageSize / 2 + random( track.averageSize + 1 );
+
+        case DIST_GOP:
+        {
+            if( !track.video || _gop == 1 )
+                return track.averageSize / 2 + random( track.averageSize + 1 );
+
+            // one sync sample weighs as much as 8 others, keep the average
+            const uint64_t unit = uint64_t( track.averageSize ) * _gop / ( _gop + 7 );
+            const uint32_t base = (uint32_t)( isSync ? unit * 8 : unit );
+            return base / 2 + random( base + 1 );
+        }
+    }
+}
+
+bool
+GenUtility::parseNumber( const char* arg, uint64_t& value, const char* what )
+{
+    istringstream iss( arg );
+    iss >> value;
+    if( iss.rdstate() != ios::eofbit )
+        return herrf( "invalid %s: %s\n", what, arg );
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+GenUtility::utility_job( JobContext& job )
+{
+    if( _numVideo + _numAudio == 0 )
+        return herrf( "no tracks specified\n" );
+
+    if( io::FileSystem::exists( job.file )) {
+        if( !_overwrite )
+            return herrf( "file already exists: %s\n", job.file.c_str() );
+        if( !io::FileSystem::isFile( job.file ))
+            return herrf( "cannot overwrite non-file: %s\n", job.file.c_str() );
+    }
+
+    verbose1f( "generating %s\n", job.file.c_str() );
+
+    if( dryrunAbort() )
+        return SUCCESS;
+
+    // every file of a batch starts from the same state
+    _random = _seed;
+
+    // large enough for the biggest sample of any distribution
+    const uint32_t maxSize = max( _videoSize * 8, _audioSize ) * 3 / 2 + 1;
+    _buffer.resize( maxSize * 2 );
+    for( vector<uint8_t>::size_type i = 0; i < _buffer.size(); i++ )
+        _buffer[i] = uint8_t( random( 256 ));
+
+    uint32_t flags = 0;
+    if( _64bit )
+        flags |= MP4_CREATE_64BIT_DATA;
+    if( _async )
+        flags |= MP4_CREATE_ASYNC_WRITE;
+
+    job.fileHandle = MP4Create( job.file.c_str(), flags );
+    if( job.fileHandle == MP4_INVALID_FILE_HANDLE )
+        return herrf( "unable to create: %s\n", job.file.c_str() );
+
+    MP4SetTimeScale( job.fileHandle, 1000 );
+
+    vector<Track> tracks;
+    if( addTracks( job, tracks ) || writeSamples( job, tracks ) || writeMetadata( job ))
+        return FAILURE;
+
+    job.optimizeApplicable = true;
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+GenUtility::utility_option( int code, bool& handled )
+{
+    handled = true;
+
+    // long codes are above INT_MAX
+    uint64_t value = 0;
+    switch( uint32_t( code )) {
+        case LC_VIDEO:
+            if( parseNumber( prog::optarg, value, "video track count" ))
+                return FAILURE;
+            _numVideo = (uint32_t)value;
+            break;
+
+        case LC_AUDIO:
+            if( parseNumber( prog::optarg, value, "audio track count" ))
+                return FAILURE;
+            _numAudio = (uint32_t)value;
+            break;
+
+        case LC_DURATION:
+            if( parseNumber( prog::optarg, _duration, "duration" ))
+                return FAILURE;
+            break;
+
+        case LC_FPS:
+            if( parseNumber( prog::optarg, value, "frame rate" ))
+                return FAILURE;
+            if( value == 0 || value > 90000 )
+                return herrf( "invalid frame rate: %s\n", prog::optarg );
+            _fps = (uint32_t)value;
+            break;
+
+        case LC_VIDEO_SIZE:
+            if( parseNumber( prog::optarg, value, "video sample size" ))
+                return FAILURE;
+            if( value == 0 || value > 0x1000000 )
+                return herrf( "invalid video sample size: %s\n", prog::optarg );
+            _videoSize = (uint32_t)value;
+            break;
+
+        case LC_AUDIO_SIZE:
+            if( parseNumber( prog::optarg, value, "audio sample size" ))
+                return FAILURE;
+            if( value == 0 || value > 0x1000000 )
+                return herrf( "invalid audio sample size: %s\n", prog::optarg );
+            _audioSize = (uint32_t)value;
+            break;
+
+        case LC_SIZES:
+        {
+            const string dist = prog::optarg;
+            if( dist == "constant" )
+                _distribution = DIST_CONSTANT;
+            else if( dist == "uniform" )
+                _distribution = DIST_UNIFORM;
+            else if( dist == "gop" )
+                _distribution = DIST_GOP;
+            else
+                return herrf( "invalid size distribution: %s\n", prog::optarg );
+            break;
+        }
+
+        case LC_GOP:
+            if( parseNumber( prog::optarg, value, "gop length" ))
+                return FAILURE;
+            if( value == 0 )
+                return herrf( "invalid gop length: %s\n", prog::optarg );
+            _gop = (uint32_t)value;
+            break;
+
+        case LC_CHUNK:
+            if( parseNumber( prog::optarg, value, "chunk duration" ))
+                return FAILURE;
+            _chunkMs = (uint32_t)value;
+            break;
+
+        case LC_64BIT:
+            _64bit = true;
+            break;
+
+        case LC_TAGS:
+            if( parseNumber( prog::optarg, value, "metadata item count" ))
+                return FAILURE;
+            _numTags = (uint32_t)value;
+            break;
+
+        case LC_ART:
+            if( parseNumber( prog::optarg, value, "cover-art size" ))
+                return FAILURE;
+            if( value > 0x10000000 )
+                return herrf( "invalid cover-art size: %s\n", prog::optarg );
+            _artSize = (uint32_t)value;
+            break;
+
+        case LC_SEED:
+            if( parseNumber( prog::optarg, value, "seed" ))
+                return FAILURE;
+            _seed = (uint32_t)value;
+            break;
+
+        case LC_ASYNC:
+            _async = true;
+            break;
+
+        default:
+            handled = false;
+            break;
+    }
+
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::util
+
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+int main( int argc, char** argv )
+{
+    mp4v2::util::GenUtility util( argc, argv );
+    return util.process();
+}
@@ -87,7 +87,7 @@ extern "C" int main( int argc, char** argv )
         MP4FileHandle mp4file = MP4Read( mp4FileName ); //, MP4_DETAILS_ERROR);
         if ( mp4file != MP4_INVALID_FILE_HANDLE ) {
             const MP4Tags* tags = MP4TagsAlloc();
-            MP4TagsFetch( tags, mp4file );
+            MP4TagsFetchWithoutArtwork( tags, mp4file );
             if ( tags->name ) {
                 fprintf( stdout, " Name: %s\n", tags->name );
             }
@@ -149,8 +149,9 @@ extern "C" int main( int argc, char** argv )
             if ( tags->gapless ) {
                 fprintf( stdout, " Part of Gapless Album: %s\n", *tags->gapless ? "yes" : "no" );
             }
-            if ( tags->artworkCount ) {
-                fprintf( stdout, " Cover Art pieces: %u\n", tags->artworkCount );
+            const uint32_t artworkCount = MP4GetArtworkCount( mp4file );
+            if ( artworkCount ) {
+                fprintf( stdout, " Cover Art pieces: %u\n", artworkCount );
             }
             if ( tags->albumArtist ) {
                 fprintf( stdout, " Album Artist: %s\n", tags->albumArtist );
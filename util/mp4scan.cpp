@@ -0,0 +1,492 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The contents of this file are subject to the Mozilla Public License
+//  Version 1.1 (the "License"); you may not use this file except in
+//  compliance with the License. You may obtain a copy of the License at
+//  http://www.mozilla.org/MPL/
+//
+//  Software distributed under the License is distributed on an "AS IS"
+//  basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See the
+//  License for the specific language governing rights and limitations
+//  under the License.
+//
+//  The Original Code is MP4v2.
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include "util/impl.h"
+
+namespace mp4v2 { namespace util {
+
+///////////////////////////////////////////////////////////////////////////////
+
+class ScanUtility : public Utility
+{
+private:
+    enum ScanLongCode {
+        LC_JOBS = _LC_MAX,
+        LC_ALL_FILES,
+    };
+
+public:
+    ScanUtility( int, char** );
+
+    bool scan();
+
+protected:
+    // delegates implementation
+    bool utility_option( int, bool& );
+    bool utility_job( JobContext& );
+
+private:
+    void walk       ( const string&, uint32_t );
+    bool isMediaFile( const string& );
+    void worker     ();
+    bool scanFile   ( const string&, string& );
+
+    static void        logToStderr  ( MP4LogLevel, const char*, va_list );
+    static bool        shouldParse  ( uint32_t );
+    static void        jsonString   ( string&, const char* );
+    static void        jsonTag      ( string&, const char*, const char* );
+    static string      jsonNumber   ( uint64_t );
+    static string      jsonSeconds  ( MP4Duration, uint32_t );
+
+private:
+    Group _parmGroup;
+
+    uint32_t _jobs;
+    bool     _all;
+    bool     _walked;  // at least one argument was accepted
+
+    vector<string> _files;
+
+    // shared by the workers
+    atomic<size_t>   _next;
+    atomic<uint32_t> _failures;
+    mutex            _outMutex;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+ScanUtility::ScanUtility( int argc, char** argv )
+    : Utility    ( "mp4scan", argc, argv )
+    , _parmGroup ( "SCAN PARAMETERS" )
+    , _jobs      ( max( thread::hardware_concurrency(), 1u ))
+    , _all       ( false )
+    , _walked    ( false )
+    , _next      ( 0 )
+    , _failures  ( 0 )
+{
+    // add standard options which make sense for this utility
+    _group.add( STD_QUIET );
+    _group.add( STD_DEBUG );
+    _group.add( STD_VERBOSE );
+    _group.add( STD_HELP );
+    _group.add( STD_VERSION );
+    _group.add( STD_VERSIONX );
+
+    _parmGroup.add( 'j', true, "jobs", true, LC_JOBS, "number of files scanned at once (default: cpu count)", "NUM" );
+    _parmGroup.add( "all", false, LC_ALL_FILES, "scan every file, not only mp4 extensions" );
+    _groups.push_back( &_parmGroup );
+
+    _usage = "[OPTION]... path...";
+    _description =
+        // 79-cols, inclusive, max desired width
+        // |----------------------------------------------------------------------------|
+        "\nFor each file or directory specified, scan all mp4 files below it and print"
+        "\none JSON object per file to stdout: size, duration, tracks and tags, or the"
+        "\nerror that prevented reading it. Lines are printed as files complete, so"
+        "\ntheir order varies between runs."
+        "\n"
+        "\nFiles are opened without sample tables or cover art, only the atoms needed"
+        "\nfor the summary are read. Throughput is reported on stderr at the end.";
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ScanUtility::logToStderr( MP4LogLevel, const char* fmt, va_list ap )
+{
+    // keep stdout clean for the JSON lines
+    vfprintf( stderr, fmt, ap );
+    fputc( '\n', stderr );
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::shouldParse( uint32_t type )
+{
+    // sample tables hold most of moov and none of it is reported
+    static const uint32_t SKIP[] = {
+        impl::STRTOINT32( "stts" ),
+        impl::STRTOINT32( "ctts" ),
+        impl::STRTOINT32( "cslg" ),
+        impl::STRTOINT32( "stss" ),
+        impl::STRTOINT32( "stsh" ),
+        impl::STRTOINT32( "stsz" ),
+        impl::STRTOINT32( "stz2" ),
+        impl::STRTOINT32( "stsc" ),
+        impl::STRTOINT32( "stco" ),
+        impl::STRTOINT32( "co64" ),
+    };
+
+    for( size_t i = 0; i < sizeof( SKIP ) / sizeof( SKIP[0] ); i++ ) {
+        if( type == SKIP[i] )
+            return false;
+    }
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ScanUtility::jsonString( string& out, const char* s )
+{
+    out += '"';
+    for( ; *s; s++ ) {
+        const unsigned char c = *s;
+        switch( c ) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b";  break;
+            case '\f': out += "\\f";  break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+
+            default:
+                if( c < 0x20 ) {
+                    char buf[8];
+                    snprintf( buf, sizeof( buf ), "\\u%04x", c );
+                    out += buf;
+                }
+                else {
+                    out += c;
+                }
+                break;
+        }
+    }
+    out += '"';
+}
+
+void
+ScanUtility::jsonTag( string& out, const char* key, const char* value )
+{
+    if( !value )
+        return;
+
+    out += ',';
+    jsonString( out, key );
+    out += ':';
+    jsonString( out, value );
+}
+
+string
+ScanUtility::jsonNumber( uint64_t value )
+{
+    char buf[32];
+    snprintf( buf, sizeof( buf ), "%" PRIu64, value );
+    return buf;
+}
+
+string
+ScanUtility::jsonSeconds( MP4Duration duration, uint32_t timeScale )
+{
+    char buf[32];
+    snprintf( buf, sizeof( buf ), "%.3f", timeScale ? double( duration ) / timeScale : 0.0 );
+    return buf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::isMediaFile( const string& name )
+{
+    if( _all )
+        return true;
+
+    string ext = name;
+    io::FileSystem::pathnameOnlyExtension( ext );
+    for( string::size_type i = 0; i < ext.size(); i++ )
+        ext[i] = char( tolower( (unsigned char)ext[i] ));
+
+    static const char* const EXTENSIONS[] = {
+        "mp4", "m4a", "m4v", "m4b", "m4p", "mov", "3gp", "3g2", "f4v",
+    };
+
+    for( size_t i = 0; i < sizeof( EXTENSIONS ) / sizeof( EXTENSIONS[0] ); i++ ) {
+        if( ext == EXTENSIONS[i] )
+            return true;
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ScanUtility::walk( const string& dir, uint32_t depth )
+{
+    // warnings go to stderr, stdout only carries the JSON lines
+
+    // guards against symlink loops
+    if( depth > 64 ) {
+        errf( "WARNING: directory nesting too deep: %s\n", dir.c_str() );
+        return;
+    }
+
+    vector<string> entries;
+    if( io::FileSystem::listDirectory( dir, entries )) {
+        errf( "WARNING: unable to list directory: %s\n", dir.c_str() );
+        return;
+    }
+
+    // deterministic job order, output order still depends on the workers
+    sort( entries.begin(), entries.end() );
+
+    for( vector<string>::size_type i = 0; i < entries.size(); i++ ) {
+        const string path = dir + io::FileSystem::DIR_SEPARATOR + entries[i];
+        if( io::FileSystem::isDirectory( path ))
+            walk( path, depth + 1 );
+        else if( io::FileSystem::isFile( path ) && isMediaFile( path ))
+            _files.push_back( path );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::scanFile( const string& file, string& line )
+{
+    line = "{\"file\":";
+    jsonString( line, file.c_str() );
+
+    io::File::Size size = 0;
+    if( !io::FileSystem::getFileSize( file, size ))
+        line += ",\"size\":" + jsonNumber( size );
+
+    MP4FileHandle handle = MP4Read( file.c_str(), shouldParse );
+    if( handle == MP4_INVALID_FILE_HANDLE ) {
+        line += ",\"error\":\"unable to read\"}\n";
+        return FAILURE;
+    }
+
+    const uint32_t timeScale = MP4GetTimeScale( handle );
+    line += ",\"duration\":" + jsonSeconds( MP4GetDuration( handle ), timeScale );
+    line += ",\"timescale\":" + jsonNumber( timeScale );
+
+    line += ",\"tracks\":[";
+    const uint32_t numTracks = MP4GetNumberOfTracks( handle );
+    for( uint32_t i = 0; i < numTracks; i++ ) {
+        const MP4TrackId id = MP4FindTrackId( handle, (uint16_t)i );
+        const char* type = MP4GetTrackType( handle, id );
+        const char* codec = MP4GetTrackMediaDataName( handle, id );
+        const uint32_t trackScale = MP4GetTrackTimeScale( handle, id );
+
+        if( i )
+            line += ',';
+        line += "{\"id\":" + jsonNumber( id );
+        jsonTag( line, "type", type );
+        jsonTag( line, "codec", codec );
+        line += ",\"duration\":" + jsonSeconds( MP4GetTrackDuration( handle, id ), trackScale );
+        line += ",\"timescale\":" + jsonNumber( trackScale );
+
+        char language[4] = "";
+        if( MP4GetTrackLanguage( handle, id, language ))
+            jsonTag( line, "language", language );
+
+        if( type && !strcmp( type, MP4_VIDEO_TRACK_TYPE )) {
+            line += ",\"width\":" + jsonNumber( MP4GetTrackVideoWidth( handle, id ));
+            line += ",\"height\":" + jsonNumber( MP4GetTrackVideoHeight( handle, id ));
+        }
+        line += '}';
+    }
+    line += ']';
+
+    const MP4Tags* tags = MP4TagsAlloc();
+    if( MP4TagsFetchWithoutArtwork( tags, handle )) {
+        string fields;
+        jsonTag( fields, "name",         tags->name );
+        jsonTag( fields, "artist",       tags->artist );
+        jsonTag( fields, "albumArtist",  tags->albumArtist );
+        jsonTag( fields, "album",        tags->album );
+        jsonTag( fields, "grouping",     tags->grouping );
+        jsonTag( fields, "composer",     tags->composer );
+        jsonTag( fields, "comments",     tags->comments );
+        jsonTag( fields, "genre",        tags->genre );
+        jsonTag( fields, "releaseDate",  tags->releaseDate );
+        jsonTag( fields, "tvShow",       tags->tvShow );
+        jsonTag( fields, "tvNetwork",    tags->tvNetwork );
+        jsonTag( fields, "tvEpisodeID",  tags->tvEpisodeID );
+        jsonTag( fields, "description",  tags->description );
+        jsonTag( fields, "copyright",    tags->copyright );
+        jsonTag( fields, "encodingTool", tags->encodingTool );
+        jsonTag( fields, "encodedBy",    tags->encodedBy );
+
+        if( tags->track ) {
+            fields += ",\"track\":" + jsonNumber( tags->track->index );
+            fields += ",\"tracks\":" + jsonNumber( tags->track->total );
+        }
+        if( tags->disk ) {
+            fields += ",\"disk\":" + jsonNumber( tags->disk->index );
+            fields += ",\"disks\":" + jsonNumber( tags->disk->total );
+        }
+        if( tags->tempo )
+            fields += ",\"tempo\":" + jsonNumber( *tags->tempo );
+        if( tags->compilation )
+            fields += string( ",\"compilation\":" ) + ( *tags->compilation ? "true" : "false" );
+        if( tags->mediaType )
+            fields += ",\"mediaType\":" + jsonNumber( *tags->mediaType );
+
+        const uint32_t artworkCount = MP4GetArtworkCount( handle );
+        if( artworkCount )
+            fields += ",\"artwork\":" + jsonNumber( artworkCount );
+
+        // drop the leading comma
+        line += ",\"tags\":{" + ( fields.empty() ? fields : fields.substr( 1 )) + '}';
+    }
+    MP4TagsFree( tags );
+
+    MP4Close( handle );
+
+    line += "}\n";
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+void
+ScanUtility::worker()
+{
+    string line;
+    for( ;; ) {
+        const size_t index = _next++;
+        if( index >= _files.size() )
+            break;
+
+        bool result = FAILURE;
+        try {
+            result = scanFile( _files[index], line );
+        }
+        catch( Exception* x ) {
+            mp4v2::impl::log.errorf( *x );
+            delete x;
+
+            line = "{\"file\":";
+            jsonString( line, _files[index].c_str() );
+            line += ",\"error\":\"exception\"}\n";
+        }
+
+        if( result == FAILURE )
+            _failures++;
+
+        // one write per line keeps concurrent output whole
+        lock_guard<mutex> lock( _outMutex );
+        fwrite( line.data(), 1, line.size(), stdout );
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::scan()
+{
+    // nothing was asked for, e.g. --help
+    if( !_walked )
+        return SUCCESS;
+
+    // library diagnostics would otherwise interleave with the JSON lines
+    MP4SetLogCallback( logToStderr );
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    _next     = 0;
+    _failures = 0;
+
+    const uint32_t numWorkers = (uint32_t)min( size_t( _jobs ), max( _files.size(), size_t( 1 )));
+    vector<thread> workers;
+    for( uint32_t i = 1; i < numWorkers; i++ )
+        workers.push_back( thread( &ScanUtility::worker, this ));
+    worker();
+    for( vector<thread>::size_type i = 0; i < workers.size(); i++ )
+        workers[i].join();
+
+    fflush( stdout );
+
+    const double seconds = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+    if( _verbosity )
+        errf( "%s: scanned %u files, %u failed, in %.3f seconds (%.1f files/sec, %u jobs)\n",
+              _name.c_str(), (uint32_t)_files.size(), _failures.load(), seconds,
+              seconds > 0 ? _files.size() / seconds : 0.0, numWorkers );
+
+    return _failures ? FAILURE : SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::utility_job( JobContext& job )
+{
+    // files are only collected here, scan() works through all of them
+    _walked = true;
+
+    if( io::FileSystem::isDirectory( job.file )) {
+        walk( job.file, 0 );
+        return SUCCESS;
+    }
+
+    // explicitly named files are scanned whatever their extension
+    if( !io::FileSystem::isFile( job.file ))
+        return herrf( "no such file or directory: %s\n", job.file.c_str() );
+
+    _files.push_back( job.file );
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+ScanUtility::utility_option( int code, bool& handled )
+{
+    handled = true;
+
+    // long codes are above INT_MAX
+    switch( uint32_t( code )) {
+        case 'j':
+        case LC_JOBS:
+        {
+            istringstream iss( prog::optarg );
+            uint32_t value = 0;
+            iss >> value;
+            if( iss.rdstate() != ios::eofbit || value == 0 )
+                return herrf( "invalid number of jobs: %s\n", prog::optarg );
+            _jobs = value;
+            break;
+        }
+
+        case LC_ALL_FILES:
+            _all = true;
+            break;
+
+        default:
+            handled = false;
+            break;
+    }
+
+    return SUCCESS;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+}} // namespace mp4v2::util
+
+///////////////////////////////////////////////////////////////////////////////
+
+extern "C"
+int main( int argc, char** argv )
+{
+    mp4v2::util::ScanUtility util( argc, argv );
+    if( util.process() )
+        return 1;
+    return util.scan();
+}